@@ -7,22 +7,109 @@
 
 lecs::ComponentID::IDType lecs::ComponentID::counter = 0;
 
+// Stats
+lecs::Stats& lecs::Stats::operator+=(const Stats& other) {
+	remove_swap_moves += other.remove_swap_moves;
+	free_list_hits += other.free_list_hits;
+	lazy_pool_creations += other.lazy_pool_creations;
+	invalid_handle_rejections += other.invalid_handle_rejections;
+	return *this;
+}
+
+lecs::Stats lecs::Stats::operator-(const Stats& other) const {
+	Stats result;
+	result.remove_swap_moves = remove_swap_moves - other.remove_swap_moves;
+	result.free_list_hits = free_list_hits - other.free_list_hits;
+	result.lazy_pool_creations = lazy_pool_creations - other.lazy_pool_creations;
+	result.invalid_handle_rejections = invalid_handle_rejections - other.invalid_handle_rejections;
+	return result;
+}
+
+#if defined(LECS_STATS)
+#include <algorithm>
+#include <mutex>
+
+namespace lecs {
+	namespace detail {
+		Stats to_stats(const ThreadStats& thread_stats) {
+			Stats stats;
+			stats.remove_swap_moves = thread_stats.remove_swap_moves.load(std::memory_order_relaxed);
+			stats.free_list_hits = thread_stats.free_list_hits.load(std::memory_order_relaxed);
+			stats.lazy_pool_creations = thread_stats.lazy_pool_creations.load(std::memory_order_relaxed);
+			stats.invalid_handle_rejections = thread_stats.invalid_handle_rejections.load(std::memory_order_relaxed);
+			return stats;
+		}
+
+		// Keeps track of the counters of the live threads, and of the totals of the exited ones.
+		struct StatsRegistry {
+			std::mutex mutex;
+			std::vector<ThreadStats*> live_threads;
+			Stats exited_threads;
+
+			static StatsRegistry& get() {
+				static StatsRegistry registry;
+				return registry;
+			}
+		};
+
+		struct ThreadStatsRegistration {
+			ThreadStats stats;
+
+			ThreadStatsRegistration() {
+				StatsRegistry& registry = StatsRegistry::get();
+				std::lock_guard<std::mutex> lock(registry.mutex);
+				registry.live_threads.push_back(&stats);
+			}
+
+			~ThreadStatsRegistration() {
+				StatsRegistry& registry = StatsRegistry::get();
+				std::lock_guard<std::mutex> lock(registry.mutex);
+				registry.exited_threads += to_stats(stats);
+				registry.live_threads.erase(std::find(registry.live_threads.begin(), registry.live_threads.end(), &stats));
+			}
+		};
+	}
+}
+
+lecs::detail::ThreadStats& lecs::detail::get_thread_stats() {
+	thread_local ThreadStatsRegistration registration;
+	return registration.stats;
+}
+
+lecs::Stats lecs::get_stats() {
+	detail::StatsRegistry& registry = detail::StatsRegistry::get();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	Stats total = registry.exited_threads;
+	for (const detail::ThreadStats* thread_stats : registry.live_threads) {
+		total += detail::to_stats(*thread_stats);
+	}
+	return total;
+}
+#else
+lecs::Stats lecs::get_stats() {
+	return Stats{};
+}
+#endif // defined(LECS_STATS)
+
 //Entity
+const lecs::EntityIndex lecs::Entity::INVALID_INDEX;
+const lecs::EntityGeneration lecs::Entity::MAX_GENERATION;
 const lecs::Entity lecs::Entity::Invalid = { lecs::Entity::INVALID_INDEX, 0 };
 
 lecs::Entity::Entity(EntityIndex index, EntityGeneration generation) {
-	id = (static_cast<IDType>(generation) << 32) | static_cast<IDType>(index);
+	id = (static_cast<IDType>(generation & MAX_GENERATION) << ENTITY_INDEX_BITS) | static_cast<IDType>(index & INVALID_INDEX);
 }
 
 lecs::EntityIndex lecs::Entity::get_index() const {
-	return static_cast<EntityIndex>(id);
+	return static_cast<EntityIndex>(id & INVALID_INDEX);
 }
 
 lecs::EntityGeneration lecs::Entity::get_generation() const {
-	return static_cast<EntityGeneration>(id >> 32);
+	return static_cast<EntityGeneration>(id >> ENTITY_INDEX_BITS);
 }
 
-bool lecs::Entity::is_valid() {
+bool lecs::Entity::is_valid() const {
 	return get_index() != INVALID_INDEX;
 }
 
@@ -35,19 +122,39 @@ lecs::Entity lecs::EntityArray::create_entity() {
 		EntityGeneration new_generation = m_entities[new_index].id.get_generation();
 		new_id = Entity{ new_index, new_generation };
 		m_free_indices_count--;
+		LECS_STATS_INCREMENT(free_list_hits);
 	}
 	else {
 		EntityIndex new_index = static_cast<EntityIndex>(m_entities_count);
-		EntityGeneration new_generation = 0;
+		EntityGeneration new_generation = m_generation_base;
 		new_id = Entity{ new_index, new_generation };
 		m_entities_count++;
 	}
 
+	if (new_id.get_generation() >= m_next_generation_base) {
+		m_next_generation_base = new_id.get_generation() + 1;
+	}
+
 	m_entities[new_id.get_index()] = { new_id, ComponentMask{} };
+	m_disabled[new_id.get_index()] = false;
 
 	return new_id;
 }
 
+bool lecs::EntityArray::create_entities(size_t count, std::vector<Entity>& out_entities) {
+	const size_t available = static_cast<size_t>(MAX_ENTITIES) - m_entities_count + m_free_indices_count;
+	if (count > available) {
+		return false;
+	}
+
+	out_entities.reserve(out_entities.size() + count);
+	for (size_t i = 0; i < count; ++i) {
+		out_entities.push_back(create_entity());
+	}
+
+	return true;
+}
+
 void lecs::EntityArray::remove_entity(Entity entity) {
 	// Invalidate Entity handle at position and increase generation
 	EntityGeneration old_gen = entity.get_generation();
@@ -61,6 +168,13 @@ void lecs::EntityArray::remove_entity(Entity entity) {
 	m_free_indices_count++;
 }
 
+void lecs::EntityArray::clear() {
+	// The entries past the count are left as they are, they are overwritten when their index is used again.
+	m_entities_count = 0;
+	m_free_indices_count = 0;
+	m_generation_base = m_next_generation_base;
+}
+
 lecs::ComponentMask& lecs::EntityArray::get_component_mask(EntityIndex entity_index) {
 	return m_entities[entity_index].mask;
 }
@@ -75,17 +189,97 @@ int32_t lecs::EntityArray::get_count() const {
 
 // ECS
 lecs::Entity lecs::ECS::create_entity() {
-	return m_entities.create_entity();
+	const Entity entity = m_entities.create_entity();
+	LECS_TRACE_OPERATION(*this, on_entity_created(entity));
+	return entity;
 }
 
 void lecs::ECS::remove_entity(Entity entity) {
 	if (is_entity_handle_active(entity)) {
+		LECS_TRACE_OPERATION(*this, on_entity_removed(entity));
+		const ComponentMask& mask = m_entities.get_component_mask(entity.get_index());
+		for (ComponentID::IDType component_id = 0; component_id < MAX_COMPONENTS; ++component_id) {
+			if (mask.test(component_id)) {
+				notify_component_removed(component_id, entity);
+			}
+		}
+
 		for (auto& component_array : m_components) {
 			if (component_array) component_array->on_entity_removed(entity.get_index());
 		}
 
 		m_entities.remove_entity(entity);
 	}
+	else {
+		LECS_STATS_INCREMENT(invalid_handle_rejections);
+	}
+}
+
+void lecs::ECS::remove_entities(const std::vector<Entity>& entities) {
+	// The entities are notified and released first, while their data is still there, then the pools drop them all at once.
+	std::vector<EntityIndex> removed_indices;
+	removed_indices.reserve(entities.size());
+	ComponentMask removed_components;
+	for (Entity entity : entities) {
+		// Also skips the entities listed twice, they are already released.
+		if (!is_entity_handle_active(entity)) {
+			LECS_STATS_INCREMENT(invalid_handle_rejections);
+			continue;
+		}
+
+		LECS_TRACE_OPERATION(*this, on_entity_removed(entity));
+		const ComponentMask& mask = m_entities.get_component_mask(entity.get_index());
+		for (ComponentID::IDType component_id = 0; component_id < MAX_COMPONENTS; ++component_id) {
+			if (mask.test(component_id)) {
+				notify_component_removed(component_id, entity);
+			}
+		}
+
+		removed_components |= mask;
+		removed_indices.push_back(entity.get_index());
+		m_entities.remove_entity(entity);
+	}
+
+	for (ComponentID::IDType component_id = 0; component_id < MAX_COMPONENTS; ++component_id) {
+		if (removed_components.test(component_id) && m_components[component_id]) {
+			m_components[component_id]->on_entities_removed(removed_indices);
+		}
+	}
+}
+
+void lecs::ECS::clear() {
+	bool is_observed = false;
+	for (const ComponentObservers& observers : m_observers) {
+		is_observed = is_observed || !observers.empty();
+	}
+#if defined(LECS_TRACE)
+	is_observed = is_observed || m_operation_recorder != nullptr;
+#endif // defined(LECS_TRACE)
+
+	// Only the observers and the recorder need the entities one by one, before anything is gone.
+	if (is_observed) {
+		const EntityIndex entity_count = static_cast<EntityIndex>(m_entities.get_count());
+		for (EntityIndex entity_index = 0; entity_index < entity_count; ++entity_index) {
+			const Entity entity = m_entities.get_id(entity_index);
+			if (!entity.is_valid()) {
+				continue;
+			}
+
+			LECS_TRACE_OPERATION(*this, on_entity_removed(entity));
+			const ComponentMask& mask = m_entities.get_component_mask(entity_index);
+			for (ComponentID::IDType component_id = 0; component_id < MAX_COMPONENTS; ++component_id) {
+				if (mask.test(component_id)) {
+					notify_component_removed(component_id, entity);
+				}
+			}
+		}
+	}
+
+	for (auto& component_array : m_components) {
+		if (component_array) component_array->clear();
+	}
+
+	m_entities.clear();
 }
 
 lecs::ComponentMask lecs::ECS::get_component_mask_from_index(EntityIndex entity_index) {
@@ -93,22 +287,202 @@ lecs::ComponentMask lecs::ECS::get_component_mask_from_index(EntityIndex entity_
 }
 
 lecs::ComponentMask lecs::ECS::get_component_mask_from_entity(Entity entity) {
-	return is_entity_handle_active(entity) ? get_component_mask_from_index(entity.get_index()) : ComponentMask{};
+	if (!is_entity_handle_active(entity)) {
+		LECS_STATS_INCREMENT(invalid_handle_rejections);
+		return ComponentMask{};
+	}
+
+	return get_component_mask_from_index(entity.get_index());
 }
 
 int32_t lecs::ECS::get_entity_count() const {
 	return m_entities.get_count();
 }
 
+int32_t lecs::ECS::get_alive_entity_count() const {
+	return m_entities.get_count() - m_entities.get_free_count();
+}
+
+const lecs::IComponentArray* lecs::ECS::find_component_array(ComponentID::IDType component_id) const {
+	return component_id < MAX_COMPONENTS ? m_components[component_id].get() : nullptr;
+}
+
 lecs::Entity lecs::ECS::get_entity_from_index(EntityIndex entity_index) const {
 	return m_entities.get_id(entity_index);
 }
 
 bool lecs::ECS::is_entity_handle_active(Entity entity) const {
-	return entity.is_valid() &&
+	// Past the count, the entries are left from before a clear.
+	return entity.is_valid() && entity.get_index() < static_cast<EntityIndex>(m_entities.get_count()) &&
 		m_entities.get_id(entity.get_index()) == entity;
 }
 
+bool lecs::ECS::set_entity_enabled(Entity entity, bool enabled) {
+	if (!is_entity_handle_active(entity)) {
+		LECS_STATS_INCREMENT(invalid_handle_rejections);
+		return false;
+	}
+
+	m_entities.set_enabled(entity.get_index(), enabled);
+	return true;
+}
+
+bool lecs::ECS::is_entity_enabled(Entity entity) const {
+	return is_entity_handle_active(entity) && m_entities.is_enabled(entity.get_index());
+}
+
+bool lecs::ECS::is_entity_enabled_from_index(EntityIndex entity_index) const {
+	return m_entities.is_enabled(entity_index);
+}
+
+void lecs::ECS::notify_component_added(ComponentID::IDType component_id, Entity entity) {
+	for (IComponentObserver* observer : m_observers[component_id]) {
+		observer->on_component_added(entity);
+	}
+}
+
+bool lecs::ECS::begin_add_component(Entity entity, ComponentID::IDType component_id) {
+	if (!is_entity_handle_active(entity)) {
+		LECS_STATS_INCREMENT(invalid_handle_rejections);
+		return false;
+	}
+
+	ComponentMask& mask = m_entities.get_component_mask(entity.get_index());
+	if (mask.test(component_id)) {
+		return false;
+	}
+
+	mask.set(component_id, true);
+	LECS_TRACE_OPERATION(*this, on_component_added(component_id, entity));
+	return true;
+}
+
+void lecs::ECS::notify_component_removed(ComponentID::IDType component_id, Entity entity) {
+	for (IComponentObserver* observer : m_observers[component_id]) {
+		observer->on_component_removed(entity);
+	}
+}
+
+// EntityRemap
+const uint32_t lecs::EntityRemap::INVALID_POSITION;
+
+lecs::Entity lecs::EntityRemap::get(Entity source_entity) const {
+	if (!source_entity.is_valid() || source_entity.get_index() >= m_position_by_source_index.size()) {
+		return Entity::Invalid;
+	}
+
+	const uint32_t position = m_position_by_source_index[source_entity.get_index()];
+	if (position == INVALID_POSITION || !(m_source_entities[position] == source_entity)) {
+		return Entity::Invalid;
+	}
+
+	return m_destination_entities[position];
+}
+
+lecs::Entity lecs::EntityRemap::get_from_source_index(EntityIndex source_index) const {
+	if (source_index >= m_position_by_source_index.size() || m_position_by_source_index[source_index] == INVALID_POSITION) {
+		return Entity::Invalid;
+	}
+
+	return m_destination_entities[m_position_by_source_index[source_index]];
+}
+
+bool lecs::move_entities(ECS& source, ECS& destination, const std::vector<Entity>& selection, EntityRemap& out_remap) {
+	out_remap = EntityRemap{};
+	if (&source == &destination) {
+		return false;
+	}
+
+	out_remap.m_position_by_source_index.assign(static_cast<size_t>(source.get_entity_count()), EntityRemap::INVALID_POSITION);
+	ComponentMask moved_components;
+	for (Entity entity : selection) {
+		if (!source.is_entity_handle_active(entity)) {
+			LECS_STATS_INCREMENT(invalid_handle_rejections);
+			continue;
+		}
+
+		uint32_t& position = out_remap.m_position_by_source_index[entity.get_index()];
+		if (position == EntityRemap::INVALID_POSITION) {
+			position = static_cast<uint32_t>(out_remap.m_source_entities.size());
+			out_remap.m_source_entities.push_back(entity);
+			moved_components |= source.m_entities.get_component_mask(entity.get_index());
+		}
+	}
+
+	if (!destination.m_entities.create_entities(out_remap.m_source_entities.size(), out_remap.m_destination_entities)) {
+		out_remap = EntityRemap{};
+		return false;
+	}
+
+	for (ComponentID::IDType component_id = 0; component_id < MAX_COMPONENTS; ++component_id) {
+		if (!moved_components.test(component_id) || source.m_observers[component_id].empty()) {
+			continue;
+		}
+
+		for (Entity entity : out_remap.m_source_entities) {
+			if (source.m_entities.get_component_mask(entity.get_index()).test(component_id)) {
+				source.notify_component_removed(component_id, entity);
+			}
+		}
+	}
+
+	for (size_t i = 0; i < out_remap.m_source_entities.size(); ++i) {
+		const EntityIndex source_index = out_remap.m_source_entities[i].get_index();
+		const EntityIndex destination_index = out_remap.m_destination_entities[i].get_index();
+		destination.m_entities.get_component_mask(destination_index) = source.m_entities.get_component_mask(source_index);
+		destination.m_entities.set_enabled(destination_index, source.m_entities.is_enabled(source_index));
+	}
+
+	for (ComponentID::IDType component_id = 0; component_id < MAX_COMPONENTS; ++component_id) {
+		if (!moved_components.test(component_id)) {
+			continue;
+		}
+
+		if (destination.m_components[component_id] == nullptr) {
+			destination.m_components[component_id] = source.m_components[component_id]->create_empty();
+			LECS_STATS_INCREMENT(lazy_pool_creations);
+		}
+		source.m_components[component_id]->move_data(*destination.m_components[component_id], out_remap);
+	}
+
+	// The components are gone already, only the handles are left to free.
+	for (Entity entity : out_remap.m_source_entities) {
+		LECS_TRACE_OPERATION(source, on_entity_removed(entity));
+		source.m_entities.remove_entity(entity);
+	}
+
+#if defined(LECS_TRACE)
+	// Recorded like entities created one by one, then given their components.
+	if (destination.m_operation_recorder != nullptr) {
+		for (Entity entity : out_remap.m_destination_entities) {
+			destination.m_operation_recorder->on_entity_created(entity);
+			const ComponentMask& mask = destination.m_entities.get_component_mask(entity.get_index());
+			for (ComponentID::IDType component_id = 0; component_id < MAX_COMPONENTS; ++component_id) {
+				if (mask.test(component_id)) {
+					destination.m_operation_recorder->on_component_added(component_id, entity);
+				}
+			}
+		}
+	}
+#endif // defined(LECS_TRACE)
+
+	for (ComponentID::IDType component_id = 0; component_id < MAX_COMPONENTS; ++component_id) {
+		if (!moved_components.test(component_id)) {
+			continue;
+		}
+
+		for (IComponentObserver* observer : destination.m_observers[component_id]) {
+			for (Entity entity : out_remap.m_destination_entities) {
+				if (destination.m_entities.get_component_mask(entity.get_index()).test(component_id)) {
+					observer->on_component_added(entity);
+				}
+			}
+		}
+	}
+
+	return true;
+}
+
 //MIT License
 //
 //Copyright(c) 2020 Marco Vallario
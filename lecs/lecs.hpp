@@ -24,6 +24,12 @@
 // or
 // my_ecs.remove_component_from_entity<Transform>(entity);
 //
+// Or construct them with their values right away:
+// Transform* transform = my_ecs.emplace_component<Transform>(entity, position, rotation);
+// my_ecs.add_components(entity, Transform{ position, rotation }, Velocity{ speed });
+// Writing a component in place, and notifying the observers, is a patch:
+// my_ecs.patch_component<Transform>(entity, [](Transform& transform) { transform.position[0] += 1.0f; });
+//
 // You can retrieve component data like this:
 // auto component_data = ecs.get_component<Transform>(entity);
 // component_data->position[0] = 1.0f;
@@ -31,6 +37,11 @@
 // You can also check if an entity has a component:
 // bool has_transform = ecs.has_component<Transform>(entity));
 //
+// To go through the components of a single type, ComponentView walks its compact array instead of the entity table.
+// Both let you remove the current entity (or its components) inside the loop, see ComponentView.
+// DenseView and DenseEntityView are random access instead, for the standard (parallel) algorithms and std::ranges.
+// DenseEntityView yields entities by value, so before C++20 the algorithms only see an input iterator: index its elements instead.
+//
 // Systems are just free functions or callable objects, you can choose:
 // void velocity_system_update(lecs::ECS& ecs_instance, float delta_time) {
 //		for (lecs::Entity entity : lecs::EntityIterator<Transform, Velocity>(ecs_instance)) {
@@ -43,8 +54,42 @@
 // Then you can call system updates from wherever you like, usually your main loop, but this gives you flexibility to how you organize your update:
 // velocity_system_update(my_ecs, delta_time);
 //
+// Other code can follow the changes of a component type by implementing IComponentObserver eg.:
+// my_ecs.add_component_observer<Transform>(&my_observer);
+// Structural changes are notified automatically. Writes through a pointer are not, so either use set_component or notify them:
+// my_ecs.set_component<Transform>(entity, new_transform);
+// or
+// my_ecs.get_component<Transform>(entity)->position[0] = 1.0f;
+// my_ecs.notify_component_changed<Transform>(entity);
+//
+// Entities can be put to sleep without touching their components, queries skip them until they are enabled again:
+// my_ecs.set_entity_enabled(entity, false);
+// for (lecs::Entity entity : lecs::EntityIterator<Transform>(my_ecs, lecs::EntityFilter::IncludeDisabled)) { /* ... */ } // to visit them anyway
+//
+// If you #define LECS_STATS (before including lecs.hpp, everywhere) the hot paths count what they do, per thread.
+// Counters only grow, take the difference of two snapshots to get the numbers of a frame:
+// lecs::Stats frame_stats = lecs::get_stats() - last_frame_stats;
+// Without LECS_STATS nothing is counted and get_stats() returns zeros.
+// lecs_inspector.hpp publishes them, with the pool sizes, to other processes.
+//
+// If you #define LECS_TRACE (everywhere as well) the structural operations and the queries of an ECS can be recorded
+// by an IOperationRecorder, see lecs_trace.hpp. Without it the hooks compile to nothing.
+//
+// Big components that are added and removed often, or that very few entities have, can live out of the compact array,
+// and components whose last frame values are read while the new ones are written can be double buffered,
+// see ComponentStorageOf.
+//
+// Content built in another ECS (eg. a loading or editor world) can be moved in at once:
+// lecs::EntityRemap remap;
+// lecs::move_entities(side_ecs, my_ecs, selection, remap);
+// lecs::Entity moved = remap.get(old_entity);
+// Components that refer to other entities need a remapper, registered in the destination:
+// my_ecs.set_entity_remapper<Parent>([](Parent& parent, const lecs::EntityRemap& remap) { parent.entity = remap.get(parent.entity); });
+//
 // Of course do not forget to remove any entity you don't need:
 // my_ecs.remove_entity(entity);
+// Or all of them at once, when a level is unloaded eg.:
+// my_ecs.clear();
 //
 // References:
 // https://austinmorlan.com/posts/entity_component_system/
@@ -60,10 +105,29 @@
 
 #include <array>
 #include <bitset>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <iterator>
 #include <memory>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
+#if defined(LECS_STATS)
+#include <atomic>
+#endif // defined(LECS_STATS)
+
+#if defined(__has_include)
+#if __has_include(<version>)
+#include <version>
+#endif
+#endif
+
+#if defined(__cpp_lib_ranges)
+#include <ranges>
+#endif // defined(__cpp_lib_ranges)
+
 // Config
 // You can define these before including lecs.h
 #ifndef LECS_MAX_COMPONENTS
@@ -74,7 +138,70 @@
 #define LECS_MAX_ENTITIES 5000
 #endif // LECS_MAX_ENTITIES
 
+// Bits of the index and of the generation in an Entity handle. Handles are 32 bits if they fit, 64 otherwise.
+// eg. 24 and 8 give 32 bits handles for up to 16M entities, but a generation that wraps after 256 reuses of an index.
+#ifndef LECS_ENTITY_INDEX_BITS
+#define LECS_ENTITY_INDEX_BITS 32
+#endif // LECS_ENTITY_INDEX_BITS
+
+#ifndef LECS_ENTITY_GENERATION_BITS
+#define LECS_ENTITY_GENERATION_BITS 32
+#endif // LECS_ENTITY_GENERATION_BITS
+
+// Bits of the component indices that every component array keeps for each possible entity: 16, 32 or 64.
+#ifndef LECS_COMPONENT_INDEX_BITS
+#define LECS_COMPONENT_INDEX_BITS 32
+#endif // LECS_COMPONENT_INDEX_BITS
+
+#if defined(LECS_STATS)
+#define LECS_STATS_INCREMENT(counter) ::lecs::detail::increment_counter(::lecs::detail::get_thread_stats().counter)
+#else
+#define LECS_STATS_INCREMENT(counter) ((void)0)
+#endif // defined(LECS_STATS)
+
+#if defined(LECS_TRACE)
+#define LECS_TRACE_OPERATION(ecs, call) do { if ((ecs).get_operation_recorder() != nullptr) { (ecs).get_operation_recorder()->call; } } while (false)
+#else
+#define LECS_TRACE_OPERATION(ecs, call) ((void)0)
+#endif // defined(LECS_TRACE)
+
 namespace lecs {
+	// Counters of the structural operations, see LECS_STATS.
+	struct Stats {
+		// Components moved by remove_data to fill the hole left by a removed one.
+		uint64_t remove_swap_moves{ 0 };
+		// Entities created reusing an index from the free list.
+		uint64_t free_list_hits{ 0 };
+		// Component arrays created the first time a component type was used.
+		uint64_t lazy_pool_creations{ 0 };
+		// Operations refused because the entity handle was invalid or stale.
+		uint64_t invalid_handle_rejections{ 0 };
+
+		Stats& operator+=(const Stats& other);
+		Stats operator-(const Stats& other) const;
+	};
+
+	// Sums the counters of all the threads, including the ones that already exited.
+	Stats get_stats();
+
+#if defined(LECS_STATS)
+	namespace detail {
+		// Only the owning thread writes its counters, so they don't need read-modify-write operations.
+		struct ThreadStats {
+			std::atomic<uint64_t> remove_swap_moves{ 0 };
+			std::atomic<uint64_t> free_list_hits{ 0 };
+			std::atomic<uint64_t> lazy_pool_creations{ 0 };
+			std::atomic<uint64_t> invalid_handle_rejections{ 0 };
+		};
+
+		ThreadStats& get_thread_stats();
+
+		inline void increment_counter(std::atomic<uint64_t>& counter) {
+			counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		}
+	}
+#endif // defined(LECS_STATS)
+
 	// Provides an unique ID for components eg.:
 	// int32_t transform_id = ComponentID::get<Transform>();
 	// TODO: add a TAG to this, so we can have multiple ones for different ECSs (eg. template <int TAG> struct ComponentID ...)
@@ -96,18 +223,30 @@ namespace lecs {
 	const int32_t MAX_COMPONENTS = LECS_MAX_COMPONENTS;
 	const int32_t MAX_ENTITIES = LECS_MAX_ENTITIES;
 
+	const uint32_t ENTITY_INDEX_BITS = LECS_ENTITY_INDEX_BITS;
+	const uint32_t ENTITY_GENERATION_BITS = LECS_ENTITY_GENERATION_BITS;
+	const uint32_t COMPONENT_INDEX_BITS = LECS_COMPONENT_INDEX_BITS;
+
+	static_assert(ENTITY_INDEX_BITS >= 1 && ENTITY_INDEX_BITS <= 32, "LECS_ENTITY_INDEX_BITS must be between 1 and 32");
+	static_assert(ENTITY_GENERATION_BITS >= 1 && ENTITY_GENERATION_BITS <= 32, "LECS_ENTITY_GENERATION_BITS must be between 1 and 32");
+	// The last index is the invalid one.
+	static_assert(static_cast<uint64_t>(MAX_ENTITIES) < (uint64_t(1) << ENTITY_INDEX_BITS), "LECS_MAX_ENTITIES doesn't fit in LECS_ENTITY_INDEX_BITS");
+	static_assert(COMPONENT_INDEX_BITS == 16 || COMPONENT_INDEX_BITS == 32 || COMPONENT_INDEX_BITS == 64, "LECS_COMPONENT_INDEX_BITS must be 16, 32 or 64");
+
 	// Implementation
 	using EntityIndex = uint32_t;
 	using EntityGeneration = uint32_t;
 	// Entity is a combination of index and generation
-	// EntityGeneration (32bits) | EntityIndex (32bits) = Entity (64Bits)
-	//using Entity = uint64_t; // TODO: currently this is not ok, as in create_entity we use the vector's size (size t) which can result into a narrowing conversion. 
+	// EntityGeneration (ENTITY_GENERATION_BITS) | EntityIndex (ENTITY_INDEX_BITS) = Entity (32 or 64 bits)
 
 	struct Entity
 	{
-		static const EntityIndex INVALID_INDEX = -1;
+		using IDType = typename std::conditional<ENTITY_INDEX_BITS + ENTITY_GENERATION_BITS <= 32, uint32_t, uint64_t>::type;
+
+		static const EntityIndex INVALID_INDEX = static_cast<EntityIndex>((uint64_t(1) << ENTITY_INDEX_BITS) - 1);
+		// Generations wrap around to 0 after this.
+		static const EntityGeneration MAX_GENERATION = static_cast<EntityGeneration>((uint64_t(1) << ENTITY_GENERATION_BITS) - 1);
 
-		using IDType = uint64_t;
 		IDType id;
 
 		Entity() : id{ Invalid.id } {}
@@ -120,7 +259,7 @@ namespace lecs {
 
 		EntityGeneration get_generation() const;
 
-		bool is_valid();
+		bool is_valid() const;
 
 		bool operator==(const Entity& other) const {
 			return id == other.id;
@@ -131,11 +270,95 @@ namespace lecs {
 
 	using ComponentMask = std::bitset<MAX_COMPONENTS>;
 
+	// Which entities queries visit, see ECS::set_entity_enabled.
+	enum class EntityFilter {
+		EnabledOnly,
+		IncludeDisabled
+	};
+
+	class ECS;
+
+	// Tells where move_entities moved each entity.
+	class EntityRemap {
+	public:
+		// Returns Entity::Invalid if the entity was not moved.
+		Entity get(Entity source_entity) const;
+		Entity get_from_source_index(EntityIndex source_index) const;
+
+		// The moved entities in the order of the selection, and where each one went.
+		const std::vector<Entity>& get_source_entities() const { return m_source_entities; }
+		const std::vector<Entity>& get_destination_entities() const { return m_destination_entities; }
+
+	private:
+		friend bool move_entities(ECS& source, ECS& destination, const std::vector<Entity>& selection, EntityRemap& out_remap);
+
+		static const uint32_t INVALID_POSITION = -1;
+
+		// Position in the lists above, by source entity index.
+		std::vector<uint32_t> m_position_by_source_index;
+		std::vector<Entity> m_source_entities;
+		std::vector<Entity> m_destination_entities;
+	};
+
+	// Patches the Entity fields of a component moved to another ECS, see ECS::set_entity_remapper.
+	template <typename T>
+	using EntityRemapper = void (*)(T& component, const EntityRemap& remap);
+
 	class IComponentArray {
 	public:
 		virtual ~IComponentArray() = default;
 		virtual void on_entity_removed(EntityIndex entity_index) = 0;
+		// Same for several entities, with a single virtual call.
+		virtual void on_entities_removed(const std::vector<EntityIndex>& entity_indices) = 0;
+
+		// Creates an empty array of the same component type.
+		virtual std::unique_ptr<IComponentArray> create_empty() const = 0;
+
+		// Moves the components of the remapped entities to the end of the destination, which holds the same component type.
+		virtual void move_data(IComponentArray& destination, const EntityRemap& remap) = 0;
+
+		// Removes all of the components. The masks of the entities are not touched.
+		virtual void clear() = 0;
+
+		virtual size_t get_component_count() const = 0;
+		// The array itself and what it allocated, in bytes.
+		virtual size_t get_memory_use() const = 0;
+	};
+
+	// Receives the changes of one component type, see ECS::add_component_observer.
+	class IComponentObserver {
+	public:
+		virtual ~IComponentObserver() = default;
+
+		// Called after the component is added to the entity.
+		virtual void on_component_added(Entity entity) = 0;
+
+		// Called before the component is removed (also when the whole entity is removed), so the data can still be read.
+		virtual void on_component_removed(Entity entity) = 0;
+
+		// Called by set_component and notify_component_changed.
+		virtual void on_component_changed(Entity entity) = 0;
+	};
+
+#if defined(LECS_TRACE)
+	// Sees every structural operation of an ECS, and the queries run on it, see ECS::set_operation_recorder.
+	class IOperationRecorder {
+	public:
+		virtual ~IOperationRecorder() = default;
+
+		virtual void on_entity_created(Entity entity) = 0;
+		// Called before the entity is removed.
+		virtual void on_entity_removed(Entity entity) = 0;
+		virtual void on_component_added(ComponentID::IDType component_id, Entity entity) = 0;
+		// Called before the component is removed, but not for the components of a removed entity.
+		virtual void on_component_removed(ComponentID::IDType component_id, Entity entity) = 0;
+		// Called when an EntityIterator or a ComponentView is created, with the components it asks for.
+		virtual void on_query(const ComponentMask& mask) = 0;
+		// Called after each run of a TimeSlicedQuery, with the entity indices it scanned: index_count of them from
+		// first_index, going back to 0 at the end of the entity table.
+		virtual void on_sliced_query(const ComponentMask& mask, EntityIndex first_index, EntityIndex index_count) = 0;
 	};
+#endif // defined(LECS_TRACE)
 
 	template <typename T>
 	class ComponentArray;
@@ -146,13 +369,24 @@ namespace lecs {
 
 		Entity create_entity();
 
+		// Returns false, creating nothing, if there is no room for all of them.
+		bool create_entities(size_t count, std::vector<Entity>& out_entities);
+
 		void remove_entity(Entity entity);
 
+		// Forgets all of the entities at once. The next handles start after the generations given so far, so the old
+		// handles stay invalid (until the generations wrap, like any reused index).
+		void clear();
+
 		ComponentMask& get_component_mask(EntityIndex entity_index);
 
+		void set_enabled(EntityIndex entity_index, bool enabled) { m_disabled[entity_index] = !enabled; }
+		bool is_enabled(EntityIndex entity_index) const { return !m_disabled[entity_index]; }
+
 		Entity get_id(EntityIndex entity_index) const;
 
 		int32_t get_count() const;
+		int32_t get_free_count() const { return static_cast<int32_t>(m_free_indices_count); }
 
 	private:
 		struct Entry {
@@ -171,6 +405,13 @@ namespace lecs {
 
 		EntityIndexArrayType m_free_indices;
 		EntityIndexArraySizeType m_free_indices_count = 0;
+
+		// Generation of the new indices, and the one after every handle created so far.
+		EntityGeneration m_generation_base = 0;
+		EntityGeneration m_next_generation_base = 0;
+
+		// Kept apart from the entries, so toggling touches a single bit. Set bits are the disabled entities, so new ones start enabled.
+		std::bitset<MAX_ENTITIES> m_disabled;
 	};
 
 	class ECS {
@@ -179,6 +420,19 @@ namespace lecs {
 
 		void remove_entity(Entity entity);
 
+		// Like remove_entity for each of them, but each pool is only visited once, and only the pools of the components
+		// these entities have. Invalid handles are skipped. Use it to remove many entities at once (eg. unloading a cell).
+		void remove_entities(const std::vector<Entity>& entities);
+
+		// Removes all of the entities, for a level change eg.. The entity table and the pools are reset in place, destructors
+		// only run for components that have one, and no entity is visited unless something observes or records this ECS.
+		// Old handles stay invalid.
+		void clear();
+
+		// Removes the component from all of the entities that have it.
+		template <typename T>
+		void clear();
+
 		// Returns true if succeeded. False, if the entity already had this component, or if the entity passed was invalid.
 		template <typename T>
 		bool add_component_to_entity(Entity entity);
@@ -190,11 +444,46 @@ namespace lecs {
 		template <typename T>
 		bool has_component(Entity entity);
 
+		// Constructs the component in place from the arguments (with braces for aggregates), and returns it.
+		// Returns nullptr if the entity already had this component, or if the entity passed was invalid.
+		template <typename T, typename... Args>
+		T* emplace_component(Entity entity, Args&&... args);
+
+		// Adds several components at once eg. add_components(entity, Transform{ ... }, Velocity{ ... }).
+		// The entity is validated, and its mask updated, only once. Observers are notified when all of them are added.
+		// Returns false, adding nothing, if the entity is invalid or already has one of them.
+		template <typename... Ts>
+		bool add_components(Entity entity, Ts&&... components);
+
+		// Like add_component_to_entity, without zeroing trivial components first: write all of it before reading it.
+		// DoubleBuffered components are zeroed anyway, as their previous value can be read before any write.
+		// Observers are notified before you write it, so prefer emplace_component for observed components.
+		// Returns nullptr if the entity already had this component, or if the entity passed was invalid.
+		template <typename T>
+		T* add_component_uninitialized(Entity entity);
+
+		// Calls func(T&) and notifies the observers of the change. Returns false if the entity doesn't have this component.
+		template <typename T, typename Func>
+		bool patch_component(Entity entity, Func&& func);
+
 		// If there is no component of this type, returns a nullptr
 		template <typename T>
 		T* get_component(Entity entity);
 		template <typename T> const T* get_component(Entity entity) const;
 
+		// For ComponentStorage::DoubleBuffered components: the value before the last swap_buffers<T>.
+		// Reading it while other threads write the current values through get_component is safe.
+		// If there is no component of this type, returns a nullptr
+		template <typename T>
+		const T* get_previous_component(Entity entity) const;
+
+		// For ComponentStorage::DoubleBuffered components: in O(1), the current values become the previous ones.
+		// Call it once per frame, when no system is reading or writing T.
+		// The arrays are swapped, not copied: get_component then returns the values from two swaps ago, so a system that
+		// updates them in place, or that skips some entities, works on stale data. Write all of them from get_previous_component.
+		template <typename T>
+		void swap_buffers();
+
 		// Unsafe as it doesn't check if the entity is valid.
 		ComponentMask get_component_mask_from_index(EntityIndex entity_index);
 
@@ -203,37 +492,232 @@ namespace lecs {
 
 		// TODO: use better type
 		int32_t get_entity_count() const;
+		// get_entity_count() includes the removed entities whose index is not reused yet, this doesn't.
+		int32_t get_alive_entity_count() const;
 
 		// TODO: return an std::optional if the Entity index is out of range?
 		Entity get_entity_from_index(EntityIndex entity_index) const;
 
 		bool is_entity_handle_active(Entity entity) const;
 
+		// Disabled entities keep their components, but queries skip them unless asked otherwise.
+		// Toggling is O(1) and doesn't move any component. Returns false if the entity is invalid.
+		bool set_entity_enabled(Entity entity, bool enabled);
+		// False for invalid entities as well.
+		bool is_entity_enabled(Entity entity) const;
+		// Unsafe as it doesn't check if the entity is valid.
+		bool is_entity_enabled_from_index(EntityIndex entity_index) const;
+
+		// Writes the component and notifies the observers. Returns false if the entity doesn't have this component.
+		template <typename T>
+		bool set_component(Entity entity, const T& value);
+
+		// Call it after writing a component through the pointer returned by get_component, if something observes it.
+		// Returns false if the entity doesn't have this component.
+		template <typename T>
+		bool notify_component_changed(Entity entity);
+
+		// The observer is not owned, remove it before destroying it.
+		template <typename T>
+		void add_component_observer(IComponentObserver* observer);
+
+		template <typename T>
+		void remove_component_observer(IComponentObserver* observer);
+
+		// Direct access to the compact array of a component type, eg. to go through all of its data.
+		template <typename T>
+		ComponentArray<T>& get_component_array();
+
+		// For code that doesn't know the component types. Returns nullptr if the array was not created yet.
+		const IComponentArray* find_component_array(ComponentID::IDType component_id) const;
+
+		// Used when components of this type are moved in this ECS by move_entities.
+		template <typename T>
+		void set_entity_remapper(EntityRemapper<T> remapper);
+
+#if defined(LECS_TRACE)
+		// The recorder is not owned, pass nullptr to stop recording.
+		void set_operation_recorder(IOperationRecorder* recorder) { m_operation_recorder = recorder; }
+		IOperationRecorder* get_operation_recorder() const { return m_operation_recorder; }
+#endif // defined(LECS_TRACE)
+
 	private:
+		friend bool move_entities(ECS& source, ECS& destination, const std::vector<Entity>& selection, EntityRemap& out_remap);
+
 		struct EntityEntry {
 			Entity id;
 			ComponentMask mask;
 		};
 
 		using IComponentArrayPtr = std::unique_ptr<IComponentArray>;
+		using ComponentObservers = std::vector<IComponentObserver*>;
 
 		// Lazily initialize component arrays, so we don't waste memory if we don't need to
 		template <typename T>
 		ComponentArray<T>& get_component_array_by_component_id(ComponentID::IDType component_id);
 
-		template <typename T>
-		ComponentArray<T>& get_component_array();
+		void notify_component_added(ComponentID::IDType component_id, Entity entity);
+		void notify_component_removed(ComponentID::IDType component_id, Entity entity);
+
+		// Returns false if the entity is invalid or already has the component, otherwise marks it in the mask.
+		bool begin_add_component(Entity entity, ComponentID::IDType component_id);
 
 		EntityArray m_entities;
 		std::array<IComponentArrayPtr, MAX_COMPONENTS> m_components;
+		std::array<ComponentObservers, MAX_COMPONENTS> m_observers;
+
+#if defined(LECS_TRACE)
+		IOperationRecorder* m_operation_recorder{ nullptr };
+#endif // defined(LECS_TRACE)
 	};
 
+	// Moves the selected entities, with all of their components, from source to destination.
+	// Components are moved pool by pool in one pass, and the destination handles are allocated together.
+	// Components holding Entity values are patched by the remappers registered in the destination.
+	// Invalid and repeated handles in the selection are skipped. Observers of both worlds are notified.
+	// Returns false, moving nothing, if the destination doesn't have room for the entities or it is the source.
+	bool move_entities(ECS& source, ECS& destination, const std::vector<Entity>& selection, EntityRemap& out_remap);
+
+	// Where a ComponentArray keeps its components.
+	// Inline: in the compact array itself, this is the default.
+	// Indirect: the compact array only holds pointers, the components live in the fixed slots of a slab. Removing a component
+	// then moves a pointer instead of the whole component, and the pointers of a big component still fit in few cache lines.
+	// Iterating goes through the pointers, so keep it for big components that are added and removed often.
+	// Rare: like Indirect, but the arrays grow with the components and entities find theirs in a hash map, instead of
+	// arrays of LECS_MAX_ENTITIES elements. For components that only a handful of entities have (eg. Boss, DebugLabel).
+	// DoubleBuffered: like Inline, in two arrays sharing the index maps. The usual accessors write the current values,
+	// get_previous_component reads the values from before the last ECS::swap_buffers<T>, so systems reading the previous
+	// values can run in parallel with the ones writing the current values. Takes twice the memory of Inline.
+	// After a swap the current values are the ones from two swaps ago: every frame, write all of them from the previous
+	// values, never read-modify-write them through get_component.
+	enum class ComponentStorage {
+		Inline,
+		Indirect,
+		Rare,
+		DoubleBuffered
+	};
+
+	// Specialize it to choose the storage of a component type eg.:
+	// template <>
+	// struct lecs::ComponentStorageOf<Terrain> {
+	//		static const lecs::ComponentStorage value = lecs::ComponentStorage::Indirect;
+	// };
+	template <typename T>
+	struct ComponentStorageOf {
+		static const ComponentStorage value = ComponentStorage::Inline;
+	};
+
+	namespace detail {
+		// Fixed size slots for the components of one indirect ComponentArray, allocated in chunks.
+		// Free slots are reused first, chunks are released with the slab.
+		template <typename T>
+		class ComponentSlab {
+		public:
+			ComponentSlab() = default;
+			ComponentSlab(const ComponentSlab&) = delete;
+			ComponentSlab& operator=(const ComponentSlab&) = delete;
+
+			void* allocate();
+			void deallocate(void* slot);
+			// Releases every slot at once, the components must be destroyed already.
+			void clear();
+
+			size_t get_allocated_bytes() const { return m_chunks.size() * SLOTS_PER_CHUNK * sizeof(Slot); }
+
+		private:
+			union Slot {
+				Slot* next_free;
+				alignas(T) char bytes[sizeof(T)];
+			};
+
+			static const size_t SLOTS_PER_CHUNK = 64;
+
+			std::vector<std::unique_ptr<Slot[]>> m_chunks;
+			size_t m_chunk_used{ SLOTS_PER_CHUNK };
+			Slot* m_free_slots{ nullptr };
+		};
+
+		// Heap memory of the arrays of a ComponentArray: none for the fixed size ones.
+		template <typename U, size_t N>
+		size_t get_allocated_bytes(const std::array<U, N>&) { return 0; }
+
+		template <typename U>
+		size_t get_allocated_bytes(const std::vector<U>& values) { return values.capacity() * sizeof(U); }
+
+		// The component index of every entity index, INVALID_INDEX if the entity doesn't have the component.
+		template <typename IndexType>
+		class DenseComponentIndexMap {
+		public:
+			static const IndexType INVALID_INDEX = static_cast<IndexType>(-1);
+
+			DenseComponentIndexMap() { m_indices.fill(INVALID_INDEX); }
+
+			IndexType get(EntityIndex entity_index) const { return m_indices[entity_index]; }
+			void set(EntityIndex entity_index, IndexType index) { m_indices[entity_index] = index; }
+			void erase(EntityIndex entity_index) { m_indices[entity_index] = INVALID_INDEX; }
+
+			size_t get_allocated_bytes() const { return 0; }
+
+		private:
+			std::array<IndexType, MAX_ENTITIES> m_indices;
+		};
+
+		// Same interface, but only the entities with the component are stored, in an open addressing hash map (linear probing).
+		// It is kept at most half full, and grows by doubling.
+		template <typename IndexType>
+		class HashComponentIndexMap {
+		public:
+			static const IndexType INVALID_INDEX = static_cast<IndexType>(-1);
+
+			IndexType get(EntityIndex entity_index) const;
+			void set(EntityIndex entity_index, IndexType index);
+			void erase(EntityIndex entity_index);
+
+			size_t get_allocated_bytes() const { return m_entries.capacity() * sizeof(Entry); }
+
+		private:
+			struct Entry {
+				// Entity::INVALID_INDEX if the entry is empty.
+				EntityIndex entity_index;
+				IndexType index;
+			};
+
+			size_t get_home_slot(EntityIndex entity_index) const {
+				return static_cast<size_t>((entity_index * UINT64_C(0x9E3779B97F4A7C15)) >> m_shift);
+			}
+
+			void grow();
+
+			std::vector<Entry> m_entries;
+			size_t m_count{ 0 };
+			// 64 - log2 of the capacity.
+			uint32_t m_shift{ 64 };
+		};
+	}
+
 	// This is a compact array for components.
 	// Internally it maps entities to array indices, to keep components close to each other and improve cache efficiency.
 	template <typename T>
 	class ComponentArray : public IComponentArray {
+	private:
+		struct alignas(T) ComponentAsBytesBuffer {
+			char bytes[sizeof(T)];
+		};
+
+		using IsIndirect = std::integral_constant<bool, ComponentStorageOf<T>::value == ComponentStorage::Indirect ||
+			ComponentStorageOf<T>::value == ComponentStorage::Rare>;
+		using IsRare = std::integral_constant<bool, ComponentStorageOf<T>::value == ComponentStorage::Rare>;
+		using IsDoubleBuffered = std::integral_constant<bool, ComponentStorageOf<T>::value == ComponentStorage::DoubleBuffered>;
+		// Indirect components are in m_slab, see ComponentStorage.
+		using ComponentSlot = typename std::conditional<IsIndirect::value, T*, ComponentAsBytesBuffer>::type;
+		using ComponentArrayType = typename std::conditional<IsRare::value, std::vector<ComponentSlot>, std::array<ComponentSlot, MAX_ENTITIES>>::type;
+		using EntityIndexArrayType = typename std::conditional<IsRare::value, std::vector<EntityIndex>, std::array<EntityIndex, MAX_ENTITIES>>::type;
+
 	public:
-		ComponentArray() : m_component_array(), m_size(0) {}
+		using ComponentArraySizeType = typename ComponentArrayType::size_type;
+
+		// The slots are left uninitialized, only the ones below get_size() are ever read.
+		ComponentArray() : m_size(0) {}
 		~ComponentArray();
 
 		void insert_data(EntityIndex entity_index, T component) {
@@ -248,14 +732,55 @@ namespace lecs {
 			T* new_component = construct_at_index(new_index);
 		}
 
+		// Constructs the component from the arguments, with braces if there is no matching constructor (eg. aggregates).
+		template <typename... Args>
+		T& emplace_data(EntityIndex entity_index, Args&&... args) {
+			auto new_index = assign_new_index(entity_index);
+			return *construct_at_index_from(new_index, std::is_constructible<T, Args...>{}, std::forward<Args>(args)...);
+		}
+
+		// Default initialization: trivial components are left uninitialized.
+		// DoubleBuffered ones are value initialized instead, so that the previous value is never garbage.
+		T& insert_data_uninitialized(EntityIndex entity_index) {
+			auto new_index = assign_new_index(entity_index);
+			return *construct_at_index_uninitialized(new_index, IsDoubleBuffered{});
+		}
+
 		void remove_data(EntityIndex entity_index);
 
 		bool has_data(EntityIndex entity_index) {
-			return m_entity_to_index_map[entity_index].index != ComponentIndex::INVALID_INDEX;
+			return m_entity_to_index_map.get(entity_index) != ComponentIndexMap::INVALID_INDEX;
 		}
 
 		T& get_data_from_entity_index(EntityIndex entity_index) {
-			return get_data_from_component_index(m_entity_to_index_map[entity_index].index);
+			return get_data_from_component_index(m_entity_to_index_map.get(entity_index));
+		}
+
+		// Component indices go from 0 to get_size() - 1, the data is compact but its order changes when components are removed.
+		ComponentArraySizeType get_size() const { return m_size; }
+
+		T& get_data_from_component_index(ComponentArraySizeType component_index);
+
+		// Of DoubleBuffered components only: the value before the last swap_buffers.
+		// A component added or moved since then has the same previous and current value.
+		const T& get_previous_data_from_component_index(ComponentArraySizeType component_index) const {
+			static_assert(IsDoubleBuffered::value, "Only DoubleBuffered components have a previous value");
+			return *reinterpret_cast<const T*>(&m_component_arrays[m_current_array ^ 1][component_index].bytes[0]);
+		}
+
+		const T& get_previous_data_from_entity_index(EntityIndex entity_index) const {
+			return get_previous_data_from_component_index(m_entity_to_index_map.get(entity_index));
+		}
+
+		// Of DoubleBuffered components only: in O(1), the current values become the previous ones, and the previous ones
+		// become the current ones. These are then two swaps old, write all of them again from the previous ones.
+		void swap_buffers() {
+			static_assert(IsDoubleBuffered::value, "Only DoubleBuffered components can swap buffers");
+			m_current_array ^= 1;
+		}
+
+		EntityIndex get_entity_index_from_component_index(ComponentArraySizeType component_index) const {
+			return m_index_to_entity_map[component_index];
 		}
 
 		virtual void on_entity_removed(EntityIndex entity_index) override {
@@ -264,51 +789,206 @@ namespace lecs {
 			}
 		}
 
-	private:
-		struct alignas(T) ComponentAsBytesBuffer {
-			char bytes[sizeof(T)];
-		};
+		virtual void on_entities_removed(const std::vector<EntityIndex>& entity_indices) override {
+			for (EntityIndex entity_index : entity_indices) {
+				if (has_data(entity_index)) {
+					remove_data(entity_index);
+				}
+			}
+		}
 
-		using ComponentArrayType = std::array<ComponentAsBytesBuffer, MAX_ENTITIES>;
-		using ComponentArraySizeType = typename ComponentArrayType::size_type;
+		virtual std::unique_ptr<IComponentArray> create_empty() const override {
+			return std::make_unique<ComponentArray<T>>();
+		}
 
-		struct ComponentIndex {	
-			static const ComponentArraySizeType INVALID_INDEX = -1;
-			ComponentArraySizeType index;
+		virtual void move_data(IComponentArray& destination, const EntityRemap& remap) override;
 
-			ComponentIndex() : index(INVALID_INDEX) {}
-		};
+		virtual void clear() override;
+
+		virtual size_t get_component_count() const override { return m_size; }
+
+		virtual size_t get_memory_use() const override {
+			return sizeof(*this) + m_slab.get_allocated_bytes() + m_entity_to_index_map.get_allocated_bytes() +
+				detail::get_allocated_bytes(m_component_arrays[0]) + detail::get_allocated_bytes(m_index_to_entity_map);
+		}
+
+		void set_entity_remapper(EntityRemapper<T> remapper) { m_entity_remapper = remapper; }
+
+	private:
+		// Narrower than ComponentArraySizeType, see LECS_COMPONENT_INDEX_BITS: there is one for every possible entity.
+		using ComponentIndex = typename std::conditional<COMPONENT_INDEX_BITS == 16, uint16_t,
+			typename std::conditional<COMPONENT_INDEX_BITS == 32, uint32_t, uint64_t>::type>::type;
+		using ComponentIndexMap = typename std::conditional<IsRare::value,
+			detail::HashComponentIndexMap<ComponentIndex>, detail::DenseComponentIndexMap<ComponentIndex>>::type;
+		static_assert(static_cast<uint64_t>(MAX_ENTITIES) <= ComponentIndexMap::INVALID_INDEX, "LECS_MAX_ENTITIES doesn't fit in LECS_COMPONENT_INDEX_BITS");
 
 		ComponentArraySizeType assign_new_index(EntityIndex entity_index);
 
-		T& get_data_from_component_index(ComponentArraySizeType component_index);
+		// The rare arrays follow the number of components, the others are always full size.
+		void resize_arrays(ComponentArraySizeType size) {
+			resize_arrays(size, IsRare{});
+		}
+
+		void resize_arrays(ComponentArraySizeType, std::false_type) {}
+
+		void resize_arrays(ComponentArraySizeType size, std::true_type) {
+			get_current_array().resize(size);
+			m_index_to_entity_map.resize(size);
+		}
+
+		// Returns the memory for a new component at component_index.
+		void* allocate_at_index(ComponentArraySizeType component_index) {
+			return allocate_at_index(component_index, IsIndirect{});
+		}
+
+		void* allocate_at_index(ComponentArraySizeType component_index, std::false_type) {
+			return &get_current_array()[component_index].bytes[0];
+		}
+
+		void* allocate_at_index(ComponentArraySizeType component_index, std::true_type) {
+			void* slot = m_slab.allocate();
+			get_current_array()[component_index] = static_cast<T*>(slot);
+			return slot;
+		}
 
 		T* construct_at_index(ComponentArraySizeType component_index) {
-			return new (&m_component_array[component_index].bytes[0]) T{};
+			return copy_to_previous(component_index, new (allocate_at_index(component_index)) T{}, IsDoubleBuffered{});
 		}
 
 		T* construct_at_index(ComponentArraySizeType component_index, T&& other) {
-			return new (&m_component_array[component_index].bytes[0]) T(std::move(other));
+			return copy_to_previous(component_index, new (allocate_at_index(component_index)) T(std::move(other)), IsDoubleBuffered{});
+		}
+
+		template <typename... Args>
+		T* construct_at_index_from(ComponentArraySizeType component_index, std::true_type, Args&&... args) {
+			return copy_to_previous(component_index, new (allocate_at_index(component_index)) T(std::forward<Args>(args)...), IsDoubleBuffered{});
+		}
+
+		template <typename... Args>
+		T* construct_at_index_from(ComponentArraySizeType component_index, std::false_type, Args&&... args) {
+			return copy_to_previous(component_index, new (allocate_at_index(component_index)) T{ std::forward<Args>(args)... }, IsDoubleBuffered{});
+		}
+
+		// The previous array of DoubleBuffered components follows the current one, see ComponentStorage.
+		// For the other storages these do nothing.
+		ComponentArrayType& get_current_array() {
+			return get_current_array(IsDoubleBuffered{});
+		}
+
+		ComponentArrayType& get_current_array(std::false_type) {
+			return m_component_arrays[0];
+		}
+
+		ComponentArrayType& get_current_array(std::true_type) {
+			return m_component_arrays[m_current_array];
+		}
+
+		T* get_previous_at_index(ComponentArraySizeType component_index) {
+			return reinterpret_cast<T*>(&m_component_arrays[m_current_array ^ 1][component_index].bytes[0]);
+		}
+
+		T* copy_to_previous(ComponentArraySizeType, T* component, std::false_type) {
+			return component;
+		}
+
+		T* copy_to_previous(ComponentArraySizeType component_index, T* component, std::true_type) {
+			new (get_previous_at_index(component_index)) T(*component);
+			return component;
+		}
+
+		T* construct_at_index_uninitialized(ComponentArraySizeType component_index, std::false_type) {
+			return new (allocate_at_index(component_index)) T;
+		}
+
+		T* construct_at_index_uninitialized(ComponentArraySizeType component_index, std::true_type) {
+			return construct_at_index(component_index);
+		}
+
+		// Runs the remapper on both values, the previous one was copied before the current one was remapped.
+		void remap_at_index(ComponentArraySizeType component_index, const EntityRemap& remap, std::false_type) {
+			m_entity_remapper(get_data_from_component_index(component_index), remap);
+		}
+
+		void remap_at_index(ComponentArraySizeType component_index, const EntityRemap& remap, std::true_type) {
+			m_entity_remapper(get_data_from_component_index(component_index), remap);
+			m_entity_remapper(*get_previous_at_index(component_index), remap);
+		}
+
+		void destroy_previous(ComponentArraySizeType, std::false_type) {}
+
+		void destroy_previous(ComponentArraySizeType component_index, std::true_type) {
+			get_previous_at_index(component_index)->~T();
+		}
+
+		void relocate_previous(ComponentArraySizeType, ComponentArraySizeType, std::false_type) {}
+
+		void relocate_previous(ComponentArraySizeType from_index, ComponentArraySizeType to_index, std::true_type) {
+			T* from = get_previous_at_index(from_index);
+			new (get_previous_at_index(to_index)) T(std::move(*from));
+			from->~T();
 		}
 
 		void destroy_at_index(ComponentArraySizeType component_index) {
+			destroy_at_index(component_index, IsIndirect{});
+		}
+
+		void destroy_at_index(ComponentArraySizeType component_index, std::false_type) {
 			get_data_from_component_index(component_index).~T();
+			destroy_previous(component_index, IsDoubleBuffered{});
+		}
+
+		void destroy_at_index(ComponentArraySizeType component_index, std::true_type) {
+			T* component = get_current_array()[component_index];
+			component->~T();
+			m_slab.deallocate(component);
+		}
+
+		// Moves the component at from_index to the free to_index, inside this array.
+		void relocate(ComponentArraySizeType from_index, ComponentArraySizeType to_index) {
+			relocate(from_index, to_index, IsIndirect{});
+		}
+
+		void relocate(ComponentArraySizeType from_index, ComponentArraySizeType to_index, std::false_type) {
+			T& from = get_data_from_component_index(from_index);
+			new (allocate_at_index(to_index)) T(std::move(from));
+			from.~T(); // explicitly call destructor
+			relocate_previous(from_index, to_index, IsDoubleBuffered{});
 		}
 
-		ComponentArrayType m_component_array;
+		void relocate(ComponentArraySizeType from_index, ComponentArraySizeType to_index, std::true_type) {
+			ComponentArrayType& component_array = get_current_array();
+			component_array[to_index] = component_array[from_index];
+		}
+
+		T& get_data_from_component_index(ComponentArraySizeType component_index, std::false_type) {
+			return *reinterpret_cast<T*>(&get_current_array()[component_index].bytes[0]);
+		}
+
+		T& get_data_from_component_index(ComponentArraySizeType component_index, std::true_type) {
+			return *get_current_array()[component_index];
+		}
 
-		std::array<ComponentIndex, MAX_ENTITIES> m_entity_to_index_map;
-		std::array<EntityIndex, MAX_ENTITIES> m_index_to_entity_map;
+		// DoubleBuffered components have a current and a previous array, the others only the current one.
+		ComponentArrayType m_component_arrays[IsDoubleBuffered::value ? 2 : 1];
+		uint32_t m_current_array{ 0 };
+		detail::ComponentSlab<T> m_slab;
+
+		ComponentIndexMap m_entity_to_index_map;
+		EntityIndexArrayType m_index_to_entity_map;
 
 		ComponentArraySizeType m_size;
+
+		EntityRemapper<T> m_entity_remapper{ nullptr };
 	};
 
 	// This is an iterator that lets you iterate through entities matching a particular ComponentMask.
 	// If you don't specify any template Component Types then it will iterate over all of the entities.
+	// Disabled entities are skipped, unless you pass EntityFilter::IncludeDisabled.
+	// Entity indices don't move, so removing entities or components inside the loop is safe. Entities created inside it are not visited.
 	template <typename... ComponentTypes>
 	class EntityIterator {
 	public:
-		EntityIterator(ECS& ecs) : m_ecs(ecs), m_entity_count(ecs.get_entity_count()) {
+		EntityIterator(ECS& ecs, EntityFilter filter = EntityFilter::EnabledOnly) : m_ecs(ecs), m_entity_count(ecs.get_entity_count()), m_filter(filter) {
 			if (sizeof...(ComponentTypes) == 0) {
 				m_all = true;
 			}
@@ -318,21 +998,37 @@ namespace lecs {
 					m_component_mask.set(component_IDs[i], true);
 				}
 			}
+			LECS_TRACE_OPERATION(ecs, on_query(m_component_mask));
 		}
 
+		// A standard forward iterator.
 		struct Iterator {
-			Iterator(ECS& ecs, EntityIndex entity_index, ComponentMask mask, bool all) : m_ecs(ecs), m_entity_count(static_cast<uint32_t>(ecs.get_entity_count())), m_entity_index(entity_index), m_mask(mask), m_all(all) {}
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = Entity;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const Entity*;
+			using reference = Entity;
+
+			Iterator() = default;
+
+			// Moves to the first matching entity from entity_index on.
+			Iterator(ECS& ecs, EntityIndex entity_index, EntityIndex entity_count, ComponentMask mask, bool all, EntityFilter filter)
+				: m_ecs(&ecs), m_entity_count(entity_count), m_entity_index(entity_index), m_mask(mask), m_all(all), m_filter(filter) {
+				if (m_entity_index < m_entity_count && !valid_index(m_entity_index)) {
+					++(*this);
+				}
+			}
 
 			Entity operator*() const {
-				return m_ecs.get_entity_from_index(m_entity_index);;
+				return m_ecs->get_entity_from_index(m_entity_index);
 			}
 
 			bool operator==(const Iterator& other) const {
-				return m_entity_index == other.m_entity_index || m_entity_index == m_entity_count;
+				return m_entity_index == other.m_entity_index;
 			}
 
 			bool operator!=(const Iterator& other) const {
-				return m_entity_index != other.m_entity_index || m_entity_index != m_entity_count;
+				return m_entity_index != other.m_entity_index;
 			}
 
 			Iterator& operator++() {
@@ -343,31 +1039,34 @@ namespace lecs {
 				return *this;
 			}
 
+			Iterator operator++(int) {
+				Iterator previous = *this;
+				++(*this);
+				return previous;
+			}
+
 		private:
 			bool valid_index(EntityIndex entity_index) const {
-				return m_ecs.get_entity_from_index(entity_index).is_valid() &&
-					(m_all || m_mask == (m_mask & m_ecs.get_component_mask_from_index(entity_index)));
+				return m_ecs->get_entity_from_index(entity_index).is_valid() &&
+					(m_filter == EntityFilter::IncludeDisabled || m_ecs->is_entity_enabled_from_index(entity_index)) &&
+					(m_all || m_mask == (m_mask & m_ecs->get_component_mask_from_index(entity_index)));
 			}
 
-			ECS& m_ecs;
-			uint32_t m_entity_count;
-			EntityIndex m_entity_index;
+			ECS* m_ecs{ nullptr };
+			EntityIndex m_entity_count{ 0 };
+			EntityIndex m_entity_index{ 0 };
 			ComponentMask m_mask;
 			bool m_all{ false };
+			EntityFilter m_filter{ EntityFilter::EnabledOnly };
 		};
 
-		const Iterator begin() const {
-			auto first_index = 0;
-			while (first_index < m_entity_count &&
-					m_component_mask != (m_component_mask & m_ecs.get_component_mask_from_index(first_index))) {
-				first_index++;
-			}
-
-			return Iterator(m_ecs, EntityIndex(first_index), m_component_mask, m_all);
+		// Both ends use the entity count of when the EntityIterator was created.
+		Iterator begin() const {
+			return Iterator(m_ecs, EntityIndex(0), EntityIndex(m_entity_count), m_component_mask, m_all, m_filter);
 		}
 
-		const Iterator end() const {
-			return Iterator(m_ecs, EntityIndex(m_entity_count), m_component_mask, m_all);
+		Iterator end() const {
+			return Iterator(m_ecs, EntityIndex(m_entity_count), EntityIndex(m_entity_count), m_component_mask, m_all, m_filter);
 		}
 
 	private:
@@ -375,8 +1074,287 @@ namespace lecs {
 		int32_t m_entity_count;
 		ComponentMask m_component_mask;
 		bool m_all{ false };
+		EntityFilter m_filter;
+	};
+
+	// Iterates the compact array of T, visiting the entities that also have OtherComponentTypes.
+	// It's faster than EntityIterator when few entities have T, as it doesn't walk the whole entity table.
+	// It goes back to front, so removing the current entity (or any of its components) inside the loop is safe:
+	// the component that fills the hole comes from the end of the array, which was already visited eg.:
+	// for (lecs::Entity entity : lecs::ComponentView<Health>(my_ecs)) {
+	//		if (my_ecs.get_component<Health>(entity)->points <= 0) my_ecs.remove_entity(entity);
+	// }
+	// Removing entities that were not visited yet instead can make an entity be visited twice.
+	// Components added inside the loop are not visited.
+	template <typename T, typename... OtherComponentTypes>
+	class ComponentView {
+	public:
+		ComponentView(ECS& ecs, EntityFilter filter = EntityFilter::EnabledOnly) : m_ecs(ecs), m_component_array(ecs.get_component_array<T>()), m_filter(filter) {
+			ComponentID::IDType component_IDs[] = { 0, ComponentID::get<OtherComponentTypes>()... };
+			for (size_t i = 1; i < (sizeof...(OtherComponentTypes) + 1); i++) {
+				m_component_mask.set(component_IDs[i], true);
+			}
+
+			LECS_TRACE_OPERATION(ecs, on_query(ComponentMask(m_component_mask).set(ComponentID::get<T>(), true)));
+		}
+
+		// A standard forward iterator (it can't be random access, it skips the entities that don't match).
+		struct Iterator {
+			using ComponentArraySizeType = typename ComponentArray<T>::ComponentArraySizeType;
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = Entity;
+			using difference_type = std::ptrdiff_t;
+			using pointer = const Entity*;
+			using reference = Entity;
+
+			Iterator() = default;
+
+			// position is one past the component to visit, 0 is the end.
+			Iterator(const ComponentView& view, ComponentArraySizeType position) : m_view(&view), m_position(position) {
+				skip_non_matching();
+			}
+
+			Entity operator*() const {
+				return m_view->m_ecs.get_entity_from_index(m_view->m_component_array.get_entity_index_from_component_index(m_position - 1));
+			}
+
+			bool operator==(const Iterator& other) const {
+				return m_position == other.m_position;
+			}
+
+			bool operator!=(const Iterator& other) const {
+				return m_position != other.m_position;
+			}
+
+			Iterator& operator++() {
+				m_position--;
+				skip_non_matching();
+				return *this;
+			}
+
+			Iterator operator++(int) {
+				Iterator previous = *this;
+				++(*this);
+				return previous;
+			}
+
+		private:
+			void skip_non_matching() {
+				// Removals inside the loop can shrink the array below the position.
+				if (m_position > m_view->m_component_array.get_size()) {
+					m_position = m_view->m_component_array.get_size();
+				}
+
+				while (m_position > 0 && !m_view->matches(m_view->m_component_array.get_entity_index_from_component_index(m_position - 1))) {
+					m_position--;
+				}
+			}
+
+			const ComponentView* m_view{ nullptr };
+			ComponentArraySizeType m_position{ 0 };
+		};
+
+		Iterator begin() const {
+			return Iterator(*this, m_component_array.get_size());
+		}
+
+		Iterator end() const {
+			return Iterator(*this, 0);
+		}
+
+	private:
+		bool matches(EntityIndex entity_index) const {
+			return (m_filter == EntityFilter::IncludeDisabled || m_ecs.is_entity_enabled_from_index(entity_index)) &&
+				m_component_mask == (m_component_mask & m_ecs.get_component_mask_from_index(entity_index));
+		}
+
+		ECS& m_ecs;
+		ComponentArray<T>& m_component_array;
+		ComponentMask m_component_mask;
+		EntityFilter m_filter;
+	};
+
+	namespace detail {
+		// A standard random access iterator over the indices of a compact array, Access turns an index into the element.
+		// It only holds a copy of Access, so it stays valid when the view that made it is gone.
+		// Entities are returned by value, which the legacy categories only allow for input iterators: C++20 ranges still see
+		// iterator_concept, and treat both views as random access.
+		template <typename Access>
+		class DenseIterator {
+		public:
+			using reference = decltype(std::declval<const Access&>()(size_t(0)));
+			using iterator_category = typename std::conditional<std::is_lvalue_reference<reference>::value, std::random_access_iterator_tag, std::input_iterator_tag>::type;
+			using iterator_concept = std::random_access_iterator_tag;
+			using value_type = typename std::remove_cv<typename std::remove_reference<reference>::type>::type;
+			using difference_type = std::ptrdiff_t;
+			using pointer = typename std::add_pointer<reference>::type;
+
+			DenseIterator() = default;
+			DenseIterator(Access access, difference_type index) : m_access(access), m_index(index) {}
+
+			reference operator*() const { return m_access(static_cast<size_t>(m_index)); }
+			reference operator[](difference_type offset) const { return m_access(static_cast<size_t>(m_index + offset)); }
+			// Only for views of components, entities are returned by value.
+			template <typename R = reference, typename = typename std::enable_if<std::is_lvalue_reference<R>::value>::type>
+			pointer operator->() const { return &m_access(static_cast<size_t>(m_index)); }
+
+			DenseIterator& operator++() { ++m_index; return *this; }
+			DenseIterator operator++(int) { DenseIterator previous = *this; ++m_index; return previous; }
+			DenseIterator& operator--() { --m_index; return *this; }
+			DenseIterator operator--(int) { DenseIterator previous = *this; --m_index; return previous; }
+
+			DenseIterator& operator+=(difference_type offset) { m_index += offset; return *this; }
+			DenseIterator& operator-=(difference_type offset) { m_index -= offset; return *this; }
+			DenseIterator operator+(difference_type offset) const { return DenseIterator(m_access, m_index + offset); }
+			DenseIterator operator-(difference_type offset) const { return DenseIterator(m_access, m_index - offset); }
+			friend DenseIterator operator+(difference_type offset, const DenseIterator& iterator) { return iterator + offset; }
+			difference_type operator-(const DenseIterator& other) const { return m_index - other.m_index; }
+
+			bool operator==(const DenseIterator& other) const { return m_index == other.m_index; }
+			bool operator!=(const DenseIterator& other) const { return m_index != other.m_index; }
+			bool operator<(const DenseIterator& other) const { return m_index < other.m_index; }
+			bool operator>(const DenseIterator& other) const { return m_index > other.m_index; }
+			bool operator<=(const DenseIterator& other) const { return m_index <= other.m_index; }
+			bool operator>=(const DenseIterator& other) const { return m_index >= other.m_index; }
+
+		private:
+			Access m_access{};
+			difference_type m_index{ 0 };
+		};
+
+		template <typename T>
+		struct DenseComponentAccess {
+			ComponentArray<T>* component_array;
+
+			T& operator()(size_t component_index) const { return component_array->get_data_from_component_index(component_index); }
+		};
+
+		template <typename T>
+		struct DenseEntityAccess {
+			const ECS* ecs;
+			const ComponentArray<T>* component_array;
+
+			Entity operator()(size_t component_index) const { return ecs->get_entity_from_index(component_array->get_entity_index_from_component_index(component_index)); }
+		};
+
+		// A sized range over the first size elements of a compact array.
+		template <typename Access>
+		class DenseRange {
+		public:
+			using iterator = DenseIterator<Access>;
+			using const_iterator = iterator;
+			using value_type = typename iterator::value_type;
+			using reference = typename iterator::reference;
+			using difference_type = typename iterator::difference_type;
+			using size_type = size_t;
+
+			DenseRange() = default;
+			DenseRange(Access access, size_t size) : m_access(access), m_size(size) {}
+
+			iterator begin() const { return iterator(m_access, 0); }
+			iterator end() const { return iterator(m_access, static_cast<difference_type>(m_size)); }
+
+			size_t size() const { return m_size; }
+			bool empty() const { return m_size == 0; }
+			reference operator[](size_t index) const { return m_access(index); }
+
+		private:
+			Access m_access{};
+			size_t m_size{ 0 };
+		};
+	}
+
+	// Random access, sized views over the compact array of T, in its order (which changes when components are removed).
+	// They work with the standard algorithms, parallel ones included, and with C++20 ranges eg.:
+	// lecs::DenseView<Transform> transforms(my_ecs);
+	// std::for_each(std::execution::par_unseq, transforms.begin(), transforms.end(), [](Transform& transform) { /* ... */ });
+	// lecs::DenseEntityView<Transform> entities(my_ecs); // entities[i] owns transforms[i]
+	// The size is taken when the view is created: don't add or remove components of T while using it.
+	// Every component is visited, disabled entities included.
+	template <typename T>
+	class DenseView : public detail::DenseRange<detail::DenseComponentAccess<T>> {
+	public:
+		DenseView() = default;
+		explicit DenseView(ECS& ecs) : DenseView(ecs.get_component_array<T>()) {}
+		explicit DenseView(ComponentArray<T>& component_array)
+			: detail::DenseRange<detail::DenseComponentAccess<T>>(detail::DenseComponentAccess<T>{ &component_array }, component_array.get_size()) {}
+	};
+
+	template <typename T>
+	class DenseEntityView : public detail::DenseRange<detail::DenseEntityAccess<T>> {
+	public:
+		DenseEntityView() = default;
+		explicit DenseEntityView(ECS& ecs) : DenseEntityView(ecs, ecs.get_component_array<T>()) {}
+		DenseEntityView(const ECS& ecs, const ComponentArray<T>& component_array)
+			: detail::DenseRange<detail::DenseEntityAccess<T>>(detail::DenseEntityAccess<T>{ &ecs, &component_array }, component_array.get_size()) {}
 	};
+
+	// This is a query that spreads the work of visiting entities across multiple calls (usually one per frame).
+	// The cursor walks the entity table, whose indices are stable (the component arrays instead get reordered on removal),
+	// so entities can be created and removed between calls without entities being skipped.
+	// An entity that matches the query for the whole time is visited at least once every ceil(entity_count / max_entities) + 1 calls.
+	// Keep the query alive across frames, eg.:
+	// lecs::TimeSlicedQuery<Transform, AIAgent> replan_query;
+	// ...
+	// replan_query.run(my_ecs, 128, [&](lecs::Entity entity) { /* ... */ });
+	// or, with a time budget:
+	// replan_query.run_for(my_ecs, std::chrono::microseconds(500), [&](lecs::Entity entity) { /* ... */ });
+	template <typename... ComponentTypes>
+	class TimeSlicedQuery {
+	public:
+		// Disabled entities are skipped, unless the filter is EntityFilter::IncludeDisabled.
+		explicit TimeSlicedQuery(EntityFilter filter = EntityFilter::EnabledOnly) : m_filter(filter) {
+			ComponentID::IDType component_IDs[] = { 0, ComponentID::get<ComponentTypes>()... };
+			for (size_t i = 1; i < (sizeof...(ComponentTypes) + 1); i++) {
+				m_component_mask.set(component_IDs[i], true);
+			}
+		}
+
+		// Visits at most max_entities matching entities, resuming from where the previous call stopped.
+		// Returns the number of visited entities.
+		template <typename Func>
+		int32_t run(ECS& ecs, int32_t max_entities, Func&& func);
+
+		// Visits matching entities until the budget is spent. At least one entity is visited per call, so the cursor always moves forward.
+		// Returns the number of visited entities.
+		template <typename Func>
+		int32_t run_for(ECS& ecs, std::chrono::microseconds budget, Func&& func);
+
+		// How many times the cursor went past the end of the entity table.
+		uint32_t get_sweep_count() const { return m_sweep_count; }
+
+		void reset() {
+			m_cursor = 0;
+			m_sweep_count = 0;
+		}
+
+	private:
+		// Scans at most one lap of the entity table, so calls always terminate even if nothing matches.
+		template <typename Func, typename StopPredicate>
+		int32_t run_internal(ECS& ecs, Func& func, StopPredicate should_stop);
+
+		EntityIndex m_cursor{ 0 };
+		uint32_t m_sweep_count{ 0 };
+		ComponentMask m_component_mask;
+		EntityFilter m_filter;
+	};
+}
+
+#if defined(__cpp_lib_ranges)
+// Dense views are cheap to copy, and their iterators don't point into them, so they compose with std::views as they are.
+namespace std {
+	namespace ranges {
+		template <typename T>
+		inline constexpr bool enable_view<lecs::DenseView<T>> = true;
+		template <typename T>
+		inline constexpr bool enable_borrowed_range<lecs::DenseView<T>> = true;
+		template <typename T>
+		inline constexpr bool enable_view<lecs::DenseEntityView<T>> = true;
+		template <typename T>
+		inline constexpr bool enable_borrowed_range<lecs::DenseEntityView<T>> = true;
+	}
 }
+#endif // defined(__cpp_lib_ranges)
 
 // Inline definitions file
 #include "lecs.inl"
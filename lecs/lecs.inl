@@ -8,15 +8,88 @@
 template <typename T>
 bool lecs::ECS::add_component_to_entity(Entity entity) {
 	auto component_id = ComponentID::get<T>();
+	if (!begin_add_component(entity, component_id)) {
+		return false;
+	}
+
+	auto& component_array = get_component_array_by_component_id<T>(component_id);
+	component_array.insert_data_default_initialized(entity.get_index());
+	notify_component_added(component_id, entity);
+
+	return true;
+}
+
+template <typename T, typename... Args>
+T* lecs::ECS::emplace_component(Entity entity, Args&&... args) {
+	auto component_id = ComponentID::get<T>();
+	if (!begin_add_component(entity, component_id)) {
+		return nullptr;
+	}
+
+	auto& component_array = get_component_array_by_component_id<T>(component_id);
+	T& component = component_array.emplace_data(entity.get_index(), std::forward<Args>(args)...);
+	notify_component_added(component_id, entity);
+
+	return &component;
+}
+
+template <typename... Ts>
+bool lecs::ECS::add_components(Entity entity, Ts&&... components) {
+	if (!is_entity_handle_active(entity)) {
+		LECS_STATS_INCREMENT(invalid_handle_rejections);
+		return false;
+	}
+
+	ComponentID::IDType component_IDs[] = { 0, ComponentID::get<typename std::decay<Ts>::type>()... };
+	ComponentMask added_mask;
+	for (size_t i = 1; i < (sizeof...(Ts) + 1); i++) {
+		added_mask.set(component_IDs[i], true);
+	}
 
 	const EntityIndex entity_index = entity.get_index();
-	if (!is_entity_handle_active(entity) || m_entities.get_component_mask(entity_index).test(component_id)) {
+	ComponentMask& mask = m_entities.get_component_mask(entity_index);
+	if ((mask & added_mask).any() || added_mask.count() != sizeof...(Ts)) {
+		// Already there, or the same type passed twice.
 		return false;
 	}
 
+	int emplaced[] = { 0, (get_component_array<typename std::decay<Ts>::type>().emplace_data(entity_index, std::forward<Ts>(components)), 0)... };
+	(void)emplaced;
+	mask |= added_mask;
+
+	for (size_t i = 1; i < (sizeof...(Ts) + 1); i++) {
+		LECS_TRACE_OPERATION(*this, on_component_added(component_IDs[i], entity));
+		notify_component_added(component_IDs[i], entity);
+	}
+
+	return true;
+}
+
+template <typename T>
+T* lecs::ECS::add_component_uninitialized(Entity entity) {
+	auto component_id = ComponentID::get<T>();
+	if (!begin_add_component(entity, component_id)) {
+		return nullptr;
+	}
+
 	auto& component_array = get_component_array_by_component_id<T>(component_id);
-	component_array.insert_data_default_initialized(entity_index);
-	m_entities.get_component_mask(entity_index).set(component_id, true);
+	T& component = component_array.insert_data_uninitialized(entity.get_index());
+	notify_component_added(component_id, entity);
+
+	return &component;
+}
+
+template <typename T, typename Func>
+bool lecs::ECS::patch_component(Entity entity, Func&& func) {
+	T* component = get_component<T>(entity);
+	if (component == nullptr) {
+		return false;
+	}
+
+	func(*component);
+	for (IComponentObserver* observer : m_observers[ComponentID::get<T>()]) {
+		observer->on_component_changed(entity);
+	}
 
 	return true;
 }
@@ -25,12 +98,20 @@ template <typename T>
 bool lecs::ECS::remove_component_from_entity(Entity entity) {
 	auto component_id = ComponentID::get<T>();
 
+	if (!is_entity_handle_active(entity)) {
+		LECS_STATS_INCREMENT(invalid_handle_rejections);
+		return false;
+	}
+
 	const EntityIndex entity_index = entity.get_index();
-	if (!is_entity_handle_active(entity) || m_entities.get_component_mask(entity_index).test(component_id) == false) {
+	if (m_entities.get_component_mask(entity_index).test(component_id) == false) {
 		// The entity doesn't have this component!
 		return false;
 	}
 
+	LECS_TRACE_OPERATION(*this, on_component_removed(component_id, entity));
+	notify_component_removed(component_id, entity);
+
 	auto& component_array = get_component_array_by_component_id<T>(component_id);
 	component_array.remove_data(entity_index);
 	m_entities.get_component_mask(entity_index).set(component_id, false);
@@ -38,9 +119,29 @@ bool lecs::ECS::remove_component_from_entity(Entity entity) {
 	return true;
 }
 
+template <typename T>
+void lecs::ECS::clear() {
+	const ComponentID::IDType component_id = ComponentID::get<T>();
+	if (!m_components[component_id]) {
+		return;
+	}
+
+	auto& component_array = get_component_array_by_component_id<T>(component_id);
+	for (typename ComponentArray<T>::ComponentArraySizeType i = 0; i < component_array.get_size(); ++i) {
+		const EntityIndex entity_index = component_array.get_entity_index_from_component_index(i);
+		const Entity entity = m_entities.get_id(entity_index);
+		LECS_TRACE_OPERATION(*this, on_component_removed(component_id, entity));
+		notify_component_removed(component_id, entity);
+		m_entities.get_component_mask(entity_index).set(component_id, false);
+	}
+
+	component_array.clear();
+}
+
 template <typename T>
 bool lecs::ECS::has_component(Entity entity) {
 	if (!is_entity_handle_active(entity)) {
+		LECS_STATS_INCREMENT(invalid_handle_rejections);
 		return false;
 	}
 
@@ -61,15 +162,74 @@ T* lecs::ECS::get_component(Entity entity) {
 
 template<typename T> const T* lecs::ECS::get_component(Entity entity) const
 {
-	return get_component(entity);
+	return const_cast<ECS*>(this)->get_component<T>(entity);
+}
+
+template <typename T>
+const T* lecs::ECS::get_previous_component(Entity entity) const {
+	ECS& ecs = const_cast<ECS&>(*this);
+	if (!ecs.has_component<T>(entity)) {
+		return nullptr;
+	}
+
+	return &ecs.get_component_array<T>().get_previous_data_from_entity_index(entity.get_index());
+}
+
+template <typename T>
+void lecs::ECS::swap_buffers() {
+	get_component_array<T>().swap_buffers();
+}
+
+template <typename T>
+bool lecs::ECS::set_component(Entity entity, const T& value) {
+	T* component = get_component<T>(entity);
+	if (component == nullptr) {
+		return false;
+	}
+
+	*component = value;
+	for (IComponentObserver* observer : m_observers[ComponentID::get<T>()]) {
+		observer->on_component_changed(entity);
+	}
+
+	return true;
+}
+
+template <typename T>
+bool lecs::ECS::notify_component_changed(Entity entity) {
+	if (!has_component<T>(entity)) {
+		return false;
+	}
+
+	for (IComponentObserver* observer : m_observers[ComponentID::get<T>()]) {
+		observer->on_component_changed(entity);
+	}
+
+	return true;
+}
+
+template <typename T>
+void lecs::ECS::add_component_observer(IComponentObserver* observer) {
+	m_observers[ComponentID::get<T>()].push_back(observer);
 }
 
+template <typename T>
+void lecs::ECS::remove_component_observer(IComponentObserver* observer) {
+	ComponentObservers& observers = m_observers[ComponentID::get<T>()];
+	for (auto it = observers.begin(); it != observers.end(); ++it) {
+		if (*it == observer) {
+			observers.erase(it);
+			return;
+		}
+	}
+}
 
 template <typename T>
 lecs::ComponentArray<T>
 & lecs::ECS::get_component_array_by_component_id(ComponentID::IDType component_id) {
 	if (m_components[component_id] == nullptr) {
 		m_components[component_id] = std::make_unique<ComponentArray<T>>();
+		LECS_STATS_INCREMENT(lazy_pool_creations);
 	}
 
 	return *(static_cast<ComponentArray<T>*>(m_components[component_id].get()));
@@ -83,6 +243,133 @@ lecs::ComponentArray<T>
 	return get_component_array_by_component_id<T>(component_id);
 }
 
+template <typename T>
+void lecs::ECS::set_entity_remapper(EntityRemapper<T> remapper) {
+	get_component_array<T>().set_entity_remapper(remapper);
+}
+
+// ComponentSlab<T>
+template <typename T>
+void* lecs::detail::ComponentSlab<T>::allocate() {
+	if (m_free_slots != nullptr) {
+		Slot* slot = m_free_slots;
+		m_free_slots = slot->next_free;
+		return slot;
+	}
+
+	if (m_chunk_used == SLOTS_PER_CHUNK) {
+		m_chunks.push_back(std::unique_ptr<Slot[]>(new Slot[SLOTS_PER_CHUNK]));
+		m_chunk_used = 0;
+	}
+
+	return &m_chunks.back()[m_chunk_used++];
+}
+
+template <typename T>
+void lecs::detail::ComponentSlab<T>::deallocate(void* slot) {
+	Slot* free_slot = static_cast<Slot*>(slot);
+	free_slot->next_free = m_free_slots;
+	m_free_slots = free_slot;
+}
+
+template <typename T>
+void lecs::detail::ComponentSlab<T>::clear() {
+	m_chunks.clear();
+	m_chunk_used = SLOTS_PER_CHUNK;
+	m_free_slots = nullptr;
+}
+
+// DenseComponentIndexMap<IndexType>
+template <typename IndexType>
+const IndexType lecs::detail::DenseComponentIndexMap<IndexType>::INVALID_INDEX;
+
+// HashComponentIndexMap<IndexType>
+template <typename IndexType>
+const IndexType lecs::detail::HashComponentIndexMap<IndexType>::INVALID_INDEX;
+
+template <typename IndexType>
+IndexType lecs::detail::HashComponentIndexMap<IndexType>::get(EntityIndex entity_index) const {
+	if (m_count == 0) {
+		return INVALID_INDEX;
+	}
+
+	const size_t mask = m_entries.size() - 1;
+	for (size_t slot = get_home_slot(entity_index); ; slot = (slot + 1) & mask) {
+		const Entry& entry = m_entries[slot];
+		if (entry.entity_index == entity_index) {
+			return entry.index;
+		}
+		if (entry.entity_index == Entity::INVALID_INDEX) {
+			return INVALID_INDEX;
+		}
+	}
+}
+
+template <typename IndexType>
+void lecs::detail::HashComponentIndexMap<IndexType>::set(EntityIndex entity_index, IndexType index) {
+	if ((m_count + 1) * 2 > m_entries.size()) {
+		grow();
+	}
+
+	const size_t mask = m_entries.size() - 1;
+	for (size_t slot = get_home_slot(entity_index); ; slot = (slot + 1) & mask) {
+		Entry& entry = m_entries[slot];
+		if (entry.entity_index == entity_index) {
+			entry.index = index;
+			return;
+		}
+		if (entry.entity_index == Entity::INVALID_INDEX) {
+			entry = Entry{ entity_index, index };
+			m_count++;
+			return;
+		}
+	}
+}
+
+template <typename IndexType>
+void lecs::detail::HashComponentIndexMap<IndexType>::erase(EntityIndex entity_index) {
+	if (m_count == 0) {
+		return;
+	}
+
+	const size_t mask = m_entries.size() - 1;
+	size_t slot = get_home_slot(entity_index);
+	while (m_entries[slot].entity_index != entity_index) {
+		if (m_entries[slot].entity_index == Entity::INVALID_INDEX) {
+			return;
+		}
+		slot = (slot + 1) & mask;
+	}
+
+	// Backward shift: the entries after the hole move into it, unless they already are between their home slot and the hole.
+	for (size_t next = (slot + 1) & mask; m_entries[next].entity_index != Entity::INVALID_INDEX; next = (next + 1) & mask) {
+		const size_t home = get_home_slot(m_entries[next].entity_index);
+		if (((next - home) & mask) >= ((next - slot) & mask)) {
+			m_entries[slot] = m_entries[next];
+			slot = next;
+		}
+	}
+	m_entries[slot].entity_index = Entity::INVALID_INDEX;
+	m_count--;
+}
+
+template <typename IndexType>
+void lecs::detail::HashComponentIndexMap<IndexType>::grow() {
+	std::vector<Entry> entries(m_entries.empty() ? 8 : m_entries.size() * 2, Entry{ Entity::INVALID_INDEX, INVALID_INDEX });
+	m_entries.swap(entries);
+	m_shift = 64;
+	for (size_t capacity = m_entries.size(); capacity > 1; capacity >>= 1) {
+		m_shift--;
+	}
+
+	m_count = 0;
+	for (const Entry& entry : entries) {
+		if (entry.entity_index != Entity::INVALID_INDEX) {
+			set(entry.entity_index, entry.index);
+		}
+	}
+}
+
 // ComponentArray<T>
 template <typename T>
 lecs::ComponentArray<T>::~ComponentArray() {
@@ -94,28 +381,88 @@ lecs::ComponentArray<T>::~ComponentArray() {
 template <typename T>
 void lecs::ComponentArray<T>::remove_data(EntityIndex entity_index) {
 	// Copy the last element of the array into the removed component's place. This keeps the array compact.
-	ComponentArraySizeType index_of_removed_entity = m_entity_to_index_map[entity_index].index;
+	ComponentArraySizeType index_of_removed_entity = m_entity_to_index_map.get(entity_index);
 	ComponentArraySizeType index_of_last_element = m_size - 1;
 	destroy_at_index(index_of_removed_entity); // explicitly call destructor
-	construct_at_index(index_of_removed_entity, std::move(get_data_from_component_index(index_of_last_element)));
-	destroy_at_index(index_of_last_element); // explicitly call destructor
+	if (index_of_removed_entity != index_of_last_element) {
+		relocate(index_of_last_element, index_of_removed_entity);
+		LECS_STATS_INCREMENT(remove_swap_moves);
+	}
 
 	// Update the indices for the maps
 	EntityIndex entity_index_of_last_element = m_index_to_entity_map[index_of_last_element];
-	m_entity_to_index_map[entity_index_of_last_element].index = index_of_removed_entity;
+	m_entity_to_index_map.set(entity_index_of_last_element, static_cast<ComponentIndex>(index_of_removed_entity));
 	m_index_to_entity_map[index_of_removed_entity] = entity_index_of_last_element;
 
 	// Remove deprecated entries
-	m_entity_to_index_map[entity_index].index = ComponentIndex::INVALID_INDEX;
+	m_entity_to_index_map.erase(entity_index);
 	m_index_to_entity_map[index_of_last_element] = Entity::INVALID_INDEX;
 
 	--m_size;
+	resize_arrays(m_size);
+}
+
+template <typename T>
+void lecs::ComponentArray<T>::move_data(IComponentArray& destination, const EntityRemap& remap) {
+	auto& destination_array = static_cast<ComponentArray<T>&>(destination);
+	const ComponentArraySizeType first_moved_index = destination_array.m_size;
+
+	// One pass over the compact array: moved components are appended to the destination,
+	// the others slide down over the holes, so they keep their order.
+	ComponentArraySizeType kept_count = 0;
+	for (ComponentArraySizeType component_index = 0; component_index < m_size; ++component_index) {
+		const EntityIndex entity_index = m_index_to_entity_map[component_index];
+		const Entity destination_entity = remap.get_from_source_index(entity_index);
+		if (destination_entity.is_valid()) {
+			ComponentArraySizeType new_index = destination_array.assign_new_index(destination_entity.get_index());
+			destination_array.construct_at_index(new_index, std::move(get_data_from_component_index(component_index)));
+			destroy_at_index(component_index);
+			m_entity_to_index_map.erase(entity_index);
+		}
+		else {
+			if (kept_count != component_index) {
+				relocate(component_index, kept_count);
+				m_entity_to_index_map.set(entity_index, static_cast<ComponentIndex>(kept_count));
+				m_index_to_entity_map[kept_count] = entity_index;
+			}
+			kept_count++;
+		}
+	}
+
+	for (ComponentArraySizeType component_index = kept_count; component_index < m_size; ++component_index) {
+		m_index_to_entity_map[component_index] = Entity::INVALID_INDEX;
+	}
+	m_size = kept_count;
+	resize_arrays(m_size);
+
+	if (destination_array.m_entity_remapper != nullptr) {
+		for (ComponentArraySizeType component_index = first_moved_index; component_index < destination_array.m_size; ++component_index) {
+			destination_array.remap_at_index(component_index, remap, IsDoubleBuffered{});
+		}
+	}
+}
+
+template <typename T>
+void lecs::ComponentArray<T>::clear() {
+	for (ComponentArraySizeType component_index = 0; component_index < m_size; ++component_index) {
+		if (!std::is_trivially_destructible<T>::value) {
+			get_data_from_component_index(component_index).~T(); // explicitly call destructor
+			destroy_previous(component_index, IsDoubleBuffered{});
+		}
+		m_entity_to_index_map.erase(m_index_to_entity_map[component_index]);
+		m_index_to_entity_map[component_index] = Entity::INVALID_INDEX;
+	}
+
+	m_slab.clear();
+	m_size = 0;
+	resize_arrays(m_size);
 }
 
 template <typename T>
 typename lecs::ComponentArray<T>::ComponentArraySizeType lecs::ComponentArray<T>::assign_new_index(EntityIndex entity_index) {
 	ComponentArraySizeType new_index = m_size;
-	m_entity_to_index_map[entity_index].index = new_index;
+	resize_arrays(new_index + 1);
+	m_entity_to_index_map.set(entity_index, static_cast<ComponentIndex>(new_index));
 	m_index_to_entity_map[new_index] = entity_index;
 
 	m_size++;
@@ -125,9 +472,54 @@ typename lecs::ComponentArray<T>::ComponentArraySizeType lecs::ComponentArray<T>
 
 template <typename T>
 T& lecs::ComponentArray<T>::get_data_from_component_index(ComponentArraySizeType component_index) {
-	auto& bytes = m_component_array[component_index].bytes;
-	T* component = reinterpret_cast<T*>(&bytes[0]);
-	return *component;
+	return get_data_from_component_index(component_index, IsIndirect{});
+}
+
+// TimeSlicedQuery<ComponentTypes...>
+template <typename... ComponentTypes>
+template <typename Func>
+int32_t lecs::TimeSlicedQuery<ComponentTypes...>::run(ECS& ecs, int32_t max_entities, Func&& func) {
+	return run_internal(ecs, func, [max_entities](int32_t visited_count) {
+		return visited_count >= max_entities;
+	});
+}
+
+template <typename... ComponentTypes>
+template <typename Func>
+int32_t lecs::TimeSlicedQuery<ComponentTypes...>::run_for(ECS& ecs, std::chrono::microseconds budget, Func&& func) {
+	using clock = std::chrono::steady_clock;
+	const clock::time_point deadline = clock::now() + budget;
+	return run_internal(ecs, func, [deadline](int32_t visited_count) {
+		return visited_count > 0 && clock::now() >= deadline;
+	});
+}
+
+template <typename... ComponentTypes>
+template <typename Func, typename StopPredicate>
+int32_t lecs::TimeSlicedQuery<ComponentTypes...>::run_internal(ECS& ecs, Func& func, StopPredicate should_stop) {
+	const EntityIndex entity_count = static_cast<EntityIndex>(ecs.get_entity_count());
+	const EntityIndex first_index = m_cursor;
+	int32_t visited_count = 0;
+
+	EntityIndex scanned = 0;
+	for (; scanned < entity_count && !should_stop(visited_count); ++scanned) {
+		if (m_cursor >= entity_count) {
+			m_cursor = 0;
+			m_sweep_count++;
+		}
+
+		const EntityIndex entity_index = m_cursor++;
+		Entity entity = ecs.get_entity_from_index(entity_index);
+		if (entity.is_valid() && (m_filter == EntityFilter::IncludeDisabled || ecs.is_entity_enabled_from_index(entity_index)) &&
+			m_component_mask == (m_component_mask & ecs.get_component_mask_from_index(entity_index))) {
+			func(entity);
+			visited_count++;
+		}
+	}
+
+	LECS_TRACE_OPERATION(ecs, on_sliced_query(m_component_mask, first_index, scanned));
+	(void)first_index;
+	return visited_count;
 }
 
 //MIT License
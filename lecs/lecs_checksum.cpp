@@ -0,0 +1,146 @@
+// LECS (Lightweight Entity Component System) world checksum implementation file
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+
+#include <algorithm>
+
+// WorldChecksum
+uint64_t lecs::WorldChecksum::get_digest() const {
+	uint64_t digest = 0;
+	for (const auto& pool : m_pools) {
+		digest = detail::mix_hash(digest ^ detail::mix_hash(pool->pool_key) ^ pool->hash);
+	}
+
+	return digest;
+}
+
+void lecs::WorldChecksum::get_pool_digests(std::vector<PoolDigest>& out_digests) const {
+	out_digests.clear();
+	for (const auto& pool : m_pools) {
+		out_digests.push_back({ pool->pool_key, pool->hash });
+	}
+}
+
+bool lecs::WorldChecksum::get_entity_hashes(uint32_t pool_key, std::vector<EntityHash>& out_hashes) const {
+	out_hashes.clear();
+	for (const auto& pool : m_pools) {
+		if (pool->pool_key == pool_key) {
+			pool->get_entity_hashes(m_ecs, out_hashes);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void lecs::WorldChecksum::recompute() {
+	for (auto& pool : m_pools) {
+		pool->recompute();
+	}
+}
+
+bool lecs::WorldChecksum::find_first_differing_pool(const std::vector<PoolDigest>& a, const std::vector<PoolDigest>& b, uint32_t& out_pool_key) {
+	size_t i = 0;
+	size_t j = 0;
+	while (i < a.size() && j < b.size()) {
+		if (a[i].pool_key != b[j].pool_key) {
+			out_pool_key = std::min(a[i].pool_key, b[j].pool_key);
+			return true;
+		}
+		if (a[i].hash != b[j].hash) {
+			out_pool_key = a[i].pool_key;
+			return true;
+		}
+		i++;
+		j++;
+	}
+
+	if (i < a.size() || j < b.size()) {
+		out_pool_key = i < a.size() ? a[i].pool_key : b[j].pool_key;
+		return true;
+	}
+
+	return false;
+}
+
+bool lecs::WorldChecksum::find_first_differing_entity(const std::vector<EntityHash>& a, const std::vector<EntityHash>& b, Entity& out_entity) {
+	size_t i = 0;
+	size_t j = 0;
+	while (i < a.size() && j < b.size()) {
+		if (a[i].entity.id != b[j].entity.id) {
+			out_entity = a[i].entity.id < b[j].entity.id ? a[i].entity : b[j].entity;
+			return true;
+		}
+		if (a[i].hash != b[j].hash) {
+			out_entity = a[i].entity;
+			return true;
+		}
+		i++;
+		j++;
+	}
+
+	if (i < a.size() || j < b.size()) {
+		out_entity = i < a.size() ? a[i].entity : b[j].entity;
+		return true;
+	}
+
+	return false;
+}
+
+// WorldChecksum::IPoolChecksum
+void lecs::WorldChecksum::IPoolChecksum::get_entity_hashes(ECS& ecs, std::vector<EntityHash>& out_hashes) const {
+	for (size_t entity_index = 0; entity_index < m_present.size(); ++entity_index) {
+		if (m_present[entity_index]) {
+			out_hashes.push_back({ ecs.get_entity_from_index(static_cast<EntityIndex>(entity_index)), m_entity_hashes[entity_index] });
+		}
+	}
+
+	std::sort(out_hashes.begin(), out_hashes.end(), [](const EntityHash& a, const EntityHash& b) { return a.entity.id < b.entity.id; });
+}
+
+void lecs::WorldChecksum::IPoolChecksum::set_entity_hash(EntityIndex entity_index, uint64_t entity_hash) {
+	if (entity_index >= m_present.size()) {
+		m_present.resize(static_cast<size_t>(entity_index) + 1, false);
+		m_entity_hashes.resize(static_cast<size_t>(entity_index) + 1, 0);
+	}
+
+	if (m_present[entity_index]) {
+		hash -= m_entity_hashes[entity_index];
+	}
+
+	m_entity_hashes[entity_index] = entity_hash;
+	m_present[entity_index] = true;
+	hash += entity_hash;
+}
+
+void lecs::WorldChecksum::IPoolChecksum::clear_entity_hash(EntityIndex entity_index) {
+	if (entity_index < m_present.size() && m_present[entity_index]) {
+		hash -= m_entity_hashes[entity_index];
+		m_present[entity_index] = false;
+	}
+}
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
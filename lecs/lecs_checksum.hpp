@@ -0,0 +1,239 @@
+// LECS (Lightweight Entity Component System) world checksum
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+// USAGE:
+// This is optional. If you use it, include this file in the same .cpp where you #define LECS_IMPLEMENTATION as well.
+//
+// A WorldChecksum keeps a hash of the tracked components up to date as they change, so comparing two worlds
+// (eg. two lockstep peers) costs a few integer comparisons instead of a scan of the whole world.
+// Every component type is tracked under a key of your choice, which must be the same on all the peers:
+// lecs::WorldChecksum checksum(my_ecs);
+// checksum.track<Transform>(1);
+// checksum.track<Health>(2);
+// ...
+// uint64_t digest = checksum.get_digest(); // send it to the other peers
+//
+// Adding and removing components (or entities) is tracked automatically. When you write a component,
+// use set_component or notify_component_changed, as with any other observer.
+//
+// When two digests disagree, drill down: exchange the pool digests to find the pool, then the entity hashes of that pool:
+// uint32_t pool_key;
+// lecs::WorldChecksum::find_first_differing_pool(my_pool_digests, their_pool_digests, pool_key);
+// checksum.get_entity_hashes(pool_key, my_entity_hashes);
+// lecs::Entity entity;
+// lecs::WorldChecksum::find_first_differing_entity(my_entity_hashes, their_entity_hashes, entity);
+//
+// Components are hashed by ComponentHash<T>. The default hashes their bytes, which is only correct for trivially copyable
+// components whose padding is always zero (eg. they are always value initialized). Specialize it otherwise.
+
+#pragma once
+
+#include "lecs.hpp"
+
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace lecs {
+	namespace detail {
+		// splitmix64 finalizer.
+		inline uint64_t mix_hash(uint64_t value) {
+			value ^= value >> 30;
+			value *= 0xBF58476D1CE4E5B9ull;
+			value ^= value >> 27;
+			value *= 0x94D049BB133111EBull;
+			value ^= value >> 31;
+			return value;
+		}
+
+		inline uint64_t hash_bytes(const void* data, size_t size, uint64_t seed) {
+			const unsigned char* bytes = static_cast<const unsigned char*>(data);
+			uint64_t hash = mix_hash(seed ^ (size * 0x9E3779B97F4A7C15ull));
+
+			size_t offset = 0;
+			for (; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t)) {
+				uint64_t chunk;
+				std::memcpy(&chunk, bytes + offset, sizeof(chunk));
+				hash = mix_hash(hash ^ chunk);
+			}
+
+			if (offset < size) {
+				uint64_t chunk = 0;
+				std::memcpy(&chunk, bytes + offset, size - offset);
+				hash = mix_hash(hash ^ chunk);
+			}
+
+			return hash;
+		}
+	}
+
+	template <typename T>
+	struct ComponentHash {
+		static_assert(std::is_trivially_copyable<T>::value, "Specialize lecs::ComponentHash for components that are not trivially copyable.");
+
+		uint64_t operator()(const T& component) const {
+			return detail::hash_bytes(&component, sizeof(T), 0);
+		}
+	};
+
+	class WorldChecksum {
+	public:
+		struct PoolDigest {
+			uint32_t pool_key;
+			uint64_t hash;
+		};
+
+		struct EntityHash {
+			Entity entity;
+			uint64_t hash;
+		};
+
+		explicit WorldChecksum(ECS& ecs) : m_ecs(ecs) {}
+
+		WorldChecksum(const WorldChecksum&) = delete;
+		WorldChecksum& operator=(const WorldChecksum&) = delete;
+
+		// Starts tracking a component type. The components it already has are hashed right away.
+		// Returns false if the key or the type is already tracked.
+		template <typename T>
+		bool track(uint32_t pool_key);
+
+		// Combines the hashes of all the tracked pools.
+		uint64_t get_digest() const;
+
+		// Sorted by pool key.
+		void get_pool_digests(std::vector<PoolDigest>& out_digests) const;
+
+		// Sorted by entity id. Returns false if the key is not tracked.
+		bool get_entity_hashes(uint32_t pool_key, std::vector<EntityHash>& out_hashes) const;
+
+		// Hashes everything again, eg. after writing components without notifying the ECS.
+		void recompute();
+
+		// Both lists must be sorted by pool key (as get_pool_digests returns them).
+		// Returns false if they are the same, otherwise the key of the first pool that differs (or is missing on one side).
+		static bool find_first_differing_pool(const std::vector<PoolDigest>& a, const std::vector<PoolDigest>& b, uint32_t& out_pool_key);
+
+		// Both lists must be sorted by entity id (as get_entity_hashes returns them).
+		// Returns false if they are the same, otherwise the first entity that differs (or is missing on one side).
+		static bool find_first_differing_entity(const std::vector<EntityHash>& a, const std::vector<EntityHash>& b, Entity& out_entity);
+
+	private:
+		class IPoolChecksum : public IComponentObserver {
+		public:
+			IPoolChecksum(uint32_t pool_key, ComponentID::IDType component_id) : pool_key(pool_key), component_id(component_id) {}
+
+			virtual void recompute() = 0;
+
+			void get_entity_hashes(ECS& ecs, std::vector<EntityHash>& out_hashes) const;
+
+			const uint32_t pool_key;
+			const ComponentID::IDType component_id;
+			uint64_t hash{ 0 };
+
+		protected:
+			// The pool hash is the wrapping sum of these, so it doesn't depend on the order of the components,
+			// and each change only subtracts the old hash of the entity and adds the new one.
+			void set_entity_hash(EntityIndex entity_index, uint64_t entity_hash);
+			void clear_entity_hash(EntityIndex entity_index);
+
+			std::vector<uint64_t> m_entity_hashes;
+			std::vector<bool> m_present;
+		};
+
+		template <typename T>
+		class PoolChecksum : public IPoolChecksum {
+		public:
+			PoolChecksum(ECS& ecs, uint32_t pool_key) : IPoolChecksum(pool_key, ComponentID::get<T>()), m_ecs(ecs) {
+				m_ecs.add_component_observer<T>(this);
+				recompute();
+			}
+
+			~PoolChecksum() override {
+				m_ecs.remove_component_observer<T>(this);
+			}
+
+			void on_component_added(Entity entity) override {
+				set_entity_hash(entity.get_index(), hash_entity(entity, *m_ecs.get_component<T>(entity)));
+			}
+
+			void on_component_removed(Entity entity) override {
+				clear_entity_hash(entity.get_index());
+			}
+
+			void on_component_changed(Entity entity) override {
+				set_entity_hash(entity.get_index(), hash_entity(entity, *m_ecs.get_component<T>(entity)));
+			}
+
+			void recompute() override {
+				hash = 0;
+				m_entity_hashes.clear();
+				m_present.clear();
+
+				auto& component_array = m_ecs.get_component_array<T>();
+				for (size_t i = 0; i < component_array.get_size(); ++i) {
+					const EntityIndex entity_index = component_array.get_entity_index_from_component_index(i);
+					set_entity_hash(entity_index, hash_entity(m_ecs.get_entity_from_index(entity_index), component_array.get_data_from_component_index(i)));
+				}
+			}
+
+		private:
+			static uint64_t hash_entity(Entity entity, const T& component) {
+				return detail::mix_hash(entity.id ^ ComponentHash<T>{}(component));
+			}
+
+			ECS& m_ecs;
+		};
+
+		ECS& m_ecs;
+		// Sorted by pool key.
+		std::vector<std::unique_ptr<IPoolChecksum>> m_pools;
+	};
+}
+
+template <typename T>
+bool lecs::WorldChecksum::track(uint32_t pool_key) {
+	const ComponentID::IDType component_id = ComponentID::get<T>();
+	auto position = m_pools.begin();
+	for (auto it = m_pools.begin(); it != m_pools.end(); ++it) {
+		if ((*it)->pool_key == pool_key || (*it)->component_id == component_id) {
+			return false;
+		}
+		if ((*it)->pool_key < pool_key) {
+			position = it + 1;
+		}
+	}
+
+	m_pools.insert(position, std::make_unique<PoolChecksum<T>>(m_ecs, pool_key));
+	return true;
+}
+
+#if defined(LECS_IMPLEMENTATION)
+#include "lecs_checksum.cpp"
+#endif // defined(LECS_IMPLEMENTATION)
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
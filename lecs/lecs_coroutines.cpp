@@ -0,0 +1,152 @@
+// LECS (Lightweight Entity Component System) coroutine systems implementation file
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+
+#if defined(LECS_HAS_COROUTINES)
+
+#include <new>
+
+// CoroutineArena
+void* lecs::CoroutineArena::allocate(size_t size) {
+	const size_t size_class = (size + SIZE_CLASS_BYTES - 1) / SIZE_CLASS_BYTES;
+	const size_t block_size = size_class * SIZE_CLASS_BYTES;
+	if (block_size > m_chunk_size) {
+		return ::operator new(size);
+	}
+
+	if (size_class < m_free_blocks.size() && m_free_blocks[size_class] != nullptr) {
+		FreeBlock* block = m_free_blocks[size_class];
+		m_free_blocks[size_class] = block->next;
+		return block;
+	}
+
+	if (m_chunks.empty() || m_chunk_used + block_size > m_chunk_size) {
+		m_chunks.push_back(std::unique_ptr<unsigned char[]>(new unsigned char[m_chunk_size]));
+		m_chunk_used = 0;
+	}
+
+	// Block sizes are multiples of SIZE_CLASS_BYTES, so every block stays aligned like the chunk.
+	void* block = m_chunks.back().get() + m_chunk_used;
+	m_chunk_used += block_size;
+	return block;
+}
+
+void lecs::CoroutineArena::deallocate(void* block, size_t size) {
+	const size_t size_class = (size + SIZE_CLASS_BYTES - 1) / SIZE_CLASS_BYTES;
+	if (size_class * SIZE_CLASS_BYTES > m_chunk_size) {
+		::operator delete(block);
+		return;
+	}
+
+	if (size_class >= m_free_blocks.size()) {
+		m_free_blocks.resize(size_class + 1, nullptr);
+	}
+
+	FreeBlock* free_block = static_cast<FreeBlock*>(block);
+	free_block->next = m_free_blocks[size_class];
+	m_free_blocks[size_class] = free_block;
+}
+
+// CoroutineSystem
+void* lecs::CoroutineSystem::promise_type::operator new(size_t size) {
+	unsigned char* block = static_cast<unsigned char*>(::operator new(size + detail::COROUTINE_FRAME_HEADER_SIZE));
+	*reinterpret_cast<CoroutineArena**>(block) = nullptr;
+	return block + detail::COROUTINE_FRAME_HEADER_SIZE;
+}
+
+void lecs::CoroutineSystem::promise_type::operator delete(void* memory, size_t size) {
+	unsigned char* block = static_cast<unsigned char*>(memory) - detail::COROUTINE_FRAME_HEADER_SIZE;
+	CoroutineArena* arena = *reinterpret_cast<CoroutineArena**>(block);
+	if (arena != nullptr) {
+		arena->deallocate(block, size + detail::COROUTINE_FRAME_HEADER_SIZE);
+	}
+	else {
+		::operator delete(block);
+	}
+}
+
+lecs::CoroutineSystem::~CoroutineSystem() {
+	// Only coroutines that never reached a runner are still owned here.
+	if (m_handle) {
+		m_handle.destroy();
+	}
+}
+
+// CoroutineContext
+void lecs::CoroutineContext::submit(JobPool::Job job, JobCounter& counter) {
+	if (m_job_pool != nullptr) {
+		m_job_pool->submit(std::move(job), &counter);
+	}
+	else {
+		job();
+	}
+}
+
+// CoroutineRunner
+lecs::CoroutineRunner::~CoroutineRunner() {
+	for (CoroutineSystem::Handle handle : m_coroutines) {
+		JobCounter* counter = handle.promise().waiting_for_jobs;
+		if (counter != nullptr && m_context.m_job_pool != nullptr) {
+			m_context.m_job_pool->wait(*counter);
+		}
+		handle.destroy();
+	}
+}
+
+void lecs::CoroutineRunner::update(ECS& ecs, float delta_time) {
+	m_context.m_ecs = &ecs;
+	m_context.m_delta_time = delta_time;
+	m_context.m_frame++;
+
+	size_t i = 0;
+	while (i < m_coroutines.size()) {
+		CoroutineSystem::Handle handle = m_coroutines[i];
+		CoroutineSystem::promise_type& promise = handle.promise();
+
+		const bool is_ready = promise.waiting_for_jobs != nullptr ? promise.waiting_for_jobs->is_done() : promise.resume_frame <= m_context.m_frame;
+		if (is_ready) {
+			promise.waiting_for_jobs = nullptr;
+			handle.resume();
+		}
+
+		if (handle.done()) {
+			handle.destroy();
+			m_coroutines[i] = m_coroutines.back();
+			m_coroutines.pop_back();
+		}
+		else {
+			i++;
+		}
+	}
+}
+
+void lecs::CoroutineRunner::add(CoroutineSystem coroutine) {
+	m_coroutines.push_back(std::exchange(coroutine.m_handle, nullptr));
+}
+
+#endif // defined(LECS_HAS_COROUTINES)
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
@@ -0,0 +1,285 @@
+// LECS (Lightweight Entity Component System) coroutine systems
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+// USAGE:
+// This is optional and needs C++20 coroutines, without them this file is empty (check LECS_HAS_COROUTINES).
+// If you use it, include this file in the same .cpp where you #define LECS_IMPLEMENTATION as well.
+//
+// Logic that spans frames or waits for jobs can be written as a coroutine instead of a state machine.
+// Coroutine systems take the context of a CoroutineRunner as their first parameter:
+// lecs::CoroutineSystem throw_grenade(lecs::CoroutineContext& context, lecs::Entity thrower) {
+//		co_await context.parallel_for(ray_count, 64, [&](int32_t begin, int32_t end) { /* raycasts */ });
+//		// ... apply the results ...
+//		for (int i = 0; i < 30; i++) {
+//			co_await context.next_frame();
+//		}
+//		// ... explode, context.get_ecs() is the world being updated ...
+// }
+//
+// lecs::CoroutineRunner runner(&job_pool);
+// runner.start(throw_grenade, thrower);
+// ...
+// runner.update(my_ecs, delta_time); // once per frame, or as a system of a SystemGroup
+//
+// Nothing blocks: update resumes the coroutines whose frame came or whose jobs are done, the others are skipped.
+// Coroutines always run on the thread calling update, only the jobs they submit run on the job pool.
+// Coroutine frames are allocated from an arena owned by the runner, so starting coroutines doesn't touch the heap
+// once the arena has grown enough.
+
+#pragma once
+
+#include "lecs.hpp"
+#include "lecs_jobs.hpp"
+
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define LECS_HAS_COROUTINES 1
+#endif
+#endif
+
+#if defined(LECS_HAS_COROUTINES)
+
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace lecs {
+	// Recycles memory blocks by size class. It is not thread safe: coroutines are created and destroyed by the thread calling update.
+	class CoroutineArena {
+	public:
+		explicit CoroutineArena(size_t chunk_size = 64 * 1024) : m_chunk_size(chunk_size) {}
+
+		CoroutineArena(const CoroutineArena&) = delete;
+		CoroutineArena& operator=(const CoroutineArena&) = delete;
+
+		// Blocks bigger than a chunk come from the heap.
+		void* allocate(size_t size);
+		void deallocate(void* block, size_t size);
+
+	private:
+		struct FreeBlock {
+			FreeBlock* next;
+		};
+
+		static const size_t SIZE_CLASS_BYTES = 64;
+
+		const size_t m_chunk_size;
+		std::vector<std::unique_ptr<unsigned char[]>> m_chunks;
+		size_t m_chunk_used{ 0 };
+		// One list per size class.
+		std::vector<FreeBlock*> m_free_blocks;
+	};
+
+	class CoroutineContext;
+
+	// The return type of coroutine systems.
+	class CoroutineSystem {
+	public:
+		struct promise_type {
+			// Set by the awaiters, tell update when to resume the coroutine.
+			JobCounter* waiting_for_jobs{ nullptr };
+			uint64_t resume_frame{ 0 };
+
+			// The first parameter of the coroutine is the context, its arena provides the frame.
+			template <typename... Args>
+			static void* operator new(size_t size, CoroutineContext& context, Args&...);
+			// Used by coroutines that don't take the context first (eg. member functions).
+			static void* operator new(size_t size);
+			static void operator delete(void* memory, size_t size);
+
+			CoroutineSystem get_return_object() { return CoroutineSystem(std::coroutine_handle<promise_type>::from_promise(*this)); }
+			// Coroutines start in the first update after they are started.
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			// The runner destroys them.
+			std::suspend_always final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { std::terminate(); }
+		};
+
+		using Handle = std::coroutine_handle<promise_type>;
+
+		CoroutineSystem(CoroutineSystem&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+		CoroutineSystem(const CoroutineSystem&) = delete;
+		CoroutineSystem& operator=(const CoroutineSystem&) = delete;
+		~CoroutineSystem();
+
+	private:
+		friend class CoroutineRunner;
+
+		explicit CoroutineSystem(Handle handle) : m_handle(handle) {}
+
+		Handle m_handle;
+	};
+
+	class CoroutineContext {
+	public:
+		struct NextFrameAwaiter {
+			CoroutineContext& context;
+
+			bool await_ready() const { return false; }
+			void await_suspend(CoroutineSystem::Handle handle) { handle.promise().resume_frame = context.m_frame + 1; }
+			void await_resume() {}
+		};
+
+		// Waits for jobs the coroutine submitted itself with submit.
+		struct JobsAwaiter {
+			JobCounter& counter;
+
+			bool await_ready() const { return counter.is_done(); }
+			void await_suspend(CoroutineSystem::Handle handle) { handle.promise().waiting_for_jobs = &counter; }
+			void await_resume() {}
+		};
+
+		template <typename Func>
+		struct ParallelForAwaiter {
+			ParallelForAwaiter(CoroutineContext& context, int32_t count, int32_t batch_size, Func&& func)
+				: context(context), count(count), batch_size(batch_size > 0 ? batch_size : 1), func(std::forward<Func>(func)) {}
+
+			// Without a job pool the batches run right away, and the coroutine doesn't suspend.
+			bool await_ready();
+			void await_suspend(CoroutineSystem::Handle handle);
+			void await_resume() {}
+
+			CoroutineContext& context;
+			int32_t count;
+			int32_t batch_size;
+			Func func;
+			// Lives in the coroutine frame while the jobs run.
+			JobCounter counter;
+		};
+
+		ECS& get_ecs() const { return *m_ecs; }
+		float get_delta_time() const { return m_delta_time; }
+		// Counts the updates of the runner.
+		uint64_t get_frame() const { return m_frame; }
+		JobPool* get_job_pool() const { return m_job_pool; }
+
+		// Suspends the coroutine until the next update.
+		NextFrameAwaiter next_frame() { return NextFrameAwaiter{ *this }; }
+
+		// Runs the job on the job pool (or right away, without one). co_await wait(counter) to sync with it.
+		void submit(JobPool::Job job, JobCounter& counter);
+		JobsAwaiter wait(JobCounter& counter) { return JobsAwaiter{ counter }; }
+
+		// Calls func(begin, end) on batches of [0, count) on the job pool, the coroutine is resumed once all of them are done.
+		// func must stay valid until then, eg. capture the locals of the coroutine by reference.
+		template <typename Func>
+		ParallelForAwaiter<Func> parallel_for(int32_t count, int32_t batch_size, Func&& func) {
+			return ParallelForAwaiter<Func>(*this, count, batch_size, std::forward<Func>(func));
+		}
+
+	private:
+		friend class CoroutineRunner;
+		friend struct CoroutineSystem::promise_type;
+
+		ECS* m_ecs{ nullptr };
+		float m_delta_time{ 0.0f };
+		uint64_t m_frame{ 0 };
+		JobPool* m_job_pool{ nullptr };
+		CoroutineArena m_arena;
+	};
+
+	class CoroutineRunner {
+	public:
+		// Without a job pool, the jobs of the coroutines run on the thread calling update.
+		explicit CoroutineRunner(JobPool* job_pool = nullptr) { m_context.m_job_pool = job_pool; }
+
+		// Waits for the jobs of the coroutines still running, then destroys them.
+		~CoroutineRunner();
+
+		CoroutineRunner(const CoroutineRunner&) = delete;
+		CoroutineRunner& operator=(const CoroutineRunner&) = delete;
+
+		// Calls func(context, args...), the coroutine starts running in the next update.
+		template <typename Func, typename... Args>
+		void start(Func&& func, Args&&... args) {
+			add(std::forward<Func>(func)(m_context, std::forward<Args>(args)...));
+		}
+
+		// Resumes the coroutines that are ready, and destroys the ones that finished.
+		void update(ECS& ecs, float delta_time);
+
+		size_t get_running_count() const { return m_coroutines.size(); }
+
+		CoroutineContext& get_context() { return m_context; }
+
+	private:
+		void add(CoroutineSystem coroutine);
+
+		// Declared first, so it's destroyed after the coroutines allocated from its arena.
+		CoroutineContext m_context;
+		std::vector<CoroutineSystem::Handle> m_coroutines;
+	};
+}
+
+namespace lecs {
+	namespace detail {
+		// Coroutine frames start with the arena that allocated them (nullptr for the heap), padded to keep the frame aligned.
+		static const size_t COROUTINE_FRAME_HEADER_SIZE = alignof(std::max_align_t);
+	}
+}
+
+template <typename... Args>
+void* lecs::CoroutineSystem::promise_type::operator new(size_t size, CoroutineContext& context, Args&...) {
+	unsigned char* block = static_cast<unsigned char*>(context.m_arena.allocate(size + detail::COROUTINE_FRAME_HEADER_SIZE));
+	*reinterpret_cast<CoroutineArena**>(block) = &context.m_arena;
+	return block + detail::COROUTINE_FRAME_HEADER_SIZE;
+}
+
+template <typename Func>
+bool lecs::CoroutineContext::ParallelForAwaiter<Func>::await_ready() {
+	if (count <= 0) {
+		return true;
+	}
+
+	if (context.m_job_pool == nullptr) {
+		func(0, count);
+		return true;
+	}
+
+	return false;
+}
+
+template <typename Func>
+void lecs::CoroutineContext::ParallelForAwaiter<Func>::await_suspend(CoroutineSystem::Handle handle) {
+	for (int32_t begin = 0; begin < count; begin += batch_size) {
+		const int32_t end = begin + batch_size < count ? begin + batch_size : count;
+		context.m_job_pool->submit([this, begin, end]() { func(begin, end); }, &counter);
+	}
+
+	handle.promise().waiting_for_jobs = &counter;
+}
+
+#endif // defined(LECS_HAS_COROUTINES)
+
+#if defined(LECS_IMPLEMENTATION)
+#include "lecs_coroutines.cpp"
+#endif // defined(LECS_IMPLEMENTATION)
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
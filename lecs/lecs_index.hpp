@@ -0,0 +1,451 @@
+// LECS (Lightweight Entity Component System) secondary indexes
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+// USAGE:
+// This is optional, and header only.
+//
+// Indexes let you find entities by the value of a component field, without going through all the components eg.:
+// struct NetworkId { uint32_t value; };
+// lecs::HashIndex<NetworkId, uint32_t> network_ids(my_ecs, &NetworkId::value);
+// lecs::Entity entity = network_ids.find(1234); // lecs::Entity::Invalid if there is none
+//
+// An OrderedIndex also answers range and top-k queries:
+// struct Score { int32_t points; };
+// lecs::OrderedIndex<Score, int32_t> scores(my_ecs, &Score::points);
+// std::vector<lecs::Entity> leaders;
+// scores.find_largest(10, leaders);
+// scores.find_range(100, 200, leaders); // bounds included
+//
+// Disabled entities are left out of the results, unless the filter is lecs::EntityFilter::IncludeDisabled.
+//
+// Indexes observe the component, so adding and removing it keeps them up to date.
+// When the field changes, use set_component or notify_component_changed so the index can move the entity.
+//
+// Results can feed a view, which only yields the ones that (still) have all the listed components eg.:
+// for (lecs::Entity entity : lecs::EntityListIterator<Transform>(my_ecs, leaders)) { ... }
+
+#pragma once
+
+#include "lecs.hpp"
+
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+namespace lecs {
+	// Equality lookups in O(1).
+	template <typename Component, typename Key, typename Hash = std::hash<Key>>
+	class HashIndex : public IComponentObserver {
+	public:
+		HashIndex(ECS& ecs, Key Component::* field);
+		~HashIndex() override;
+
+		HashIndex(const HashIndex&) = delete;
+		HashIndex& operator=(const HashIndex&) = delete;
+
+		void on_component_added(Entity entity) override;
+		void on_component_removed(Entity entity) override;
+		void on_component_changed(Entity entity) override;
+
+		// Returns one of the entities with this key, or Entity::Invalid.
+		Entity find(const Key& key, EntityFilter filter = EntityFilter::EnabledOnly) const;
+
+		// Appends all the entities with this key.
+		void find_all(const Key& key, std::vector<Entity>& out_entities, EntityFilter filter = EntityFilter::EnabledOnly) const;
+
+		// Counts the disabled entities too.
+		size_t count(const Key& key) const;
+
+	private:
+		struct Slot {
+			Key key{};
+			uint32_t index_in_bucket{ 0 };
+			bool present{ false };
+		};
+
+		void insert(EntityIndex entity_index, const Key& key);
+		void erase(EntityIndex entity_index);
+
+		bool passes(EntityIndex entity_index, EntityFilter filter) const {
+			return filter == EntityFilter::IncludeDisabled || m_ecs.is_entity_enabled_from_index(entity_index);
+		}
+
+		ECS& m_ecs;
+		Key Component::* m_field;
+		std::unordered_map<Key, std::vector<EntityIndex>, Hash> m_buckets;
+		// By entity index: the key the entity is stored under, as the component may already hold a new one.
+		std::vector<Slot> m_slots;
+	};
+
+	// Equality, range and top-k lookups in O(log n).
+	template <typename Component, typename Key, typename Compare = std::less<Key>>
+	class OrderedIndex : public IComponentObserver {
+	public:
+		OrderedIndex(ECS& ecs, Key Component::* field);
+		~OrderedIndex() override;
+
+		OrderedIndex(const OrderedIndex&) = delete;
+		OrderedIndex& operator=(const OrderedIndex&) = delete;
+
+		void on_component_added(Entity entity) override;
+		void on_component_removed(Entity entity) override;
+		void on_component_changed(Entity entity) override;
+
+		// Returns one of the entities with this key, or Entity::Invalid.
+		Entity find(const Key& key, EntityFilter filter = EntityFilter::EnabledOnly) const;
+
+		// Appends all the entities with this key.
+		void find_all(const Key& key, std::vector<Entity>& out_entities, EntityFilter filter = EntityFilter::EnabledOnly) const;
+
+		// Appends the entities with min <= key <= max, in key order.
+		void find_range(const Key& min, const Key& max, std::vector<Entity>& out_entities, EntityFilter filter = EntityFilter::EnabledOnly) const;
+
+		// Appends the (up to) count entities with the smallest keys, the smallest first.
+		void find_smallest(size_t count, std::vector<Entity>& out_entities, EntityFilter filter = EntityFilter::EnabledOnly) const;
+
+		// Appends the (up to) count entities with the largest keys, the largest first.
+		void find_largest(size_t count, std::vector<Entity>& out_entities, EntityFilter filter = EntityFilter::EnabledOnly) const;
+
+		// Counts the disabled entities too.
+		size_t count(const Key& key) const { return m_entries.count(key); }
+
+		size_t size() const { return m_entries.size(); }
+
+	private:
+		using EntryMap = std::multimap<Key, EntityIndex, Compare>;
+
+		struct Slot {
+			typename EntryMap::iterator entry;
+			bool present{ false };
+		};
+
+		void insert(EntityIndex entity_index, const Key& key);
+		void erase(EntityIndex entity_index);
+
+		bool passes(EntityIndex entity_index, EntityFilter filter) const {
+			return filter == EntityFilter::IncludeDisabled || m_ecs.is_entity_enabled_from_index(entity_index);
+		}
+
+		ECS& m_ecs;
+		Key Component::* m_field;
+		EntryMap m_entries;
+		std::vector<Slot> m_slots;
+	};
+
+	// Iterates a list of entities (eg. the result of an index query), skipping the ones that were removed
+	// or that don't have all the component types listed.
+	template <typename... ComponentTypes>
+	class EntityListIterator {
+	public:
+		// Disabled entities are skipped, unless the filter is EntityFilter::IncludeDisabled.
+		EntityListIterator(ECS& ecs, const std::vector<Entity>& entities, EntityFilter filter = EntityFilter::EnabledOnly) : m_ecs(ecs), m_entities(entities), m_filter(filter) {
+			ComponentID::IDType component_IDs[] = { 0, ComponentID::get<ComponentTypes>()... };
+			for (size_t i = 1; i < (sizeof...(ComponentTypes) + 1); i++) {
+				m_component_mask.set(component_IDs[i], true);
+			}
+		}
+
+		// The list is not copied, so it must outlive the iterator: a temporary would be gone before the loop starts.
+		EntityListIterator(ECS& ecs, std::vector<Entity>&& entities, EntityFilter filter = EntityFilter::EnabledOnly) = delete;
+
+		struct Iterator {
+			Iterator(const EntityListIterator& owner, size_t position) : m_owner(owner), m_position(position) {
+				skip_invalid();
+			}
+
+			Entity operator*() const {
+				return m_owner.m_entities[m_position];
+			}
+
+			bool operator==(const Iterator& other) const {
+				return m_position == other.m_position;
+			}
+
+			bool operator!=(const Iterator& other) const {
+				return m_position != other.m_position;
+			}
+
+			Iterator& operator++() {
+				m_position++;
+				skip_invalid();
+				return *this;
+			}
+
+		private:
+			void skip_invalid() {
+				while (m_position < m_owner.m_entities.size() && !m_owner.matches(m_owner.m_entities[m_position])) {
+					m_position++;
+				}
+			}
+
+			const EntityListIterator& m_owner;
+			size_t m_position;
+		};
+
+		Iterator begin() const {
+			return Iterator(*this, 0);
+		}
+
+		Iterator end() const {
+			return Iterator(*this, m_entities.size());
+		}
+
+	private:
+		bool matches(Entity entity) const {
+			return m_ecs.is_entity_handle_active(entity) &&
+				(m_filter == EntityFilter::IncludeDisabled || m_ecs.is_entity_enabled_from_index(entity.get_index())) &&
+				m_component_mask == (m_component_mask & m_ecs.get_component_mask_from_index(entity.get_index()));
+		}
+
+		ECS& m_ecs;
+		const std::vector<Entity>& m_entities;
+		ComponentMask m_component_mask;
+		EntityFilter m_filter;
+	};
+}
+
+// HashIndex<Component, Key, Hash>
+template <typename Component, typename Key, typename Hash>
+lecs::HashIndex<Component, Key, Hash>::HashIndex(ECS& ecs, Key Component::* field) : m_ecs(ecs), m_field(field) {
+	m_ecs.add_component_observer<Component>(this);
+
+	auto& component_array = m_ecs.get_component_array<Component>();
+	for (size_t i = 0; i < component_array.get_size(); ++i) {
+		insert(component_array.get_entity_index_from_component_index(i), component_array.get_data_from_component_index(i).*m_field);
+	}
+}
+
+template <typename Component, typename Key, typename Hash>
+lecs::HashIndex<Component, Key, Hash>::~HashIndex() {
+	m_ecs.remove_component_observer<Component>(this);
+}
+
+template <typename Component, typename Key, typename Hash>
+void lecs::HashIndex<Component, Key, Hash>::on_component_added(Entity entity) {
+	insert(entity.get_index(), m_ecs.get_component<Component>(entity)->*m_field);
+}
+
+template <typename Component, typename Key, typename Hash>
+void lecs::HashIndex<Component, Key, Hash>::on_component_removed(Entity entity) {
+	erase(entity.get_index());
+}
+
+template <typename Component, typename Key, typename Hash>
+void lecs::HashIndex<Component, Key, Hash>::on_component_changed(Entity entity) {
+	const Key& key = m_ecs.get_component<Component>(entity)->*m_field;
+	const EntityIndex entity_index = entity.get_index();
+	if (entity_index < m_slots.size() && m_slots[entity_index].present && m_slots[entity_index].key == key) {
+		return;
+	}
+
+	erase(entity_index);
+	insert(entity_index, key);
+}
+
+template <typename Component, typename Key, typename Hash>
+lecs::Entity lecs::HashIndex<Component, Key, Hash>::find(const Key& key, EntityFilter filter) const {
+	auto found = m_buckets.find(key);
+	if (found != m_buckets.end()) {
+		for (EntityIndex entity_index : found->second) {
+			if (passes(entity_index, filter)) {
+				return m_ecs.get_entity_from_index(entity_index);
+			}
+		}
+	}
+	return Entity::Invalid;
+}
+
+template <typename Component, typename Key, typename Hash>
+void lecs::HashIndex<Component, Key, Hash>::find_all(const Key& key, std::vector<Entity>& out_entities, EntityFilter filter) const {
+	auto found = m_buckets.find(key);
+	if (found != m_buckets.end()) {
+		for (EntityIndex entity_index : found->second) {
+			if (passes(entity_index, filter)) {
+				out_entities.push_back(m_ecs.get_entity_from_index(entity_index));
+			}
+		}
+	}
+}
+
+template <typename Component, typename Key, typename Hash>
+size_t lecs::HashIndex<Component, Key, Hash>::count(const Key& key) const {
+	auto found = m_buckets.find(key);
+	return found != m_buckets.end() ? found->second.size() : 0;
+}
+
+template <typename Component, typename Key, typename Hash>
+void lecs::HashIndex<Component, Key, Hash>::insert(EntityIndex entity_index, const Key& key) {
+	if (entity_index >= m_slots.size()) {
+		m_slots.resize(static_cast<size_t>(entity_index) + 1);
+	}
+
+	std::vector<EntityIndex>& bucket = m_buckets[key];
+	Slot& slot = m_slots[entity_index];
+	slot.key = key;
+	slot.index_in_bucket = static_cast<uint32_t>(bucket.size());
+	slot.present = true;
+	bucket.push_back(entity_index);
+}
+
+template <typename Component, typename Key, typename Hash>
+void lecs::HashIndex<Component, Key, Hash>::erase(EntityIndex entity_index) {
+	if (entity_index >= m_slots.size() || !m_slots[entity_index].present) {
+		return;
+	}
+
+	// Swap and pop, like the component arrays do.
+	Slot& slot = m_slots[entity_index];
+	auto found = m_buckets.find(slot.key);
+	std::vector<EntityIndex>& bucket = found->second;
+	const EntityIndex moved_entity_index = bucket.back();
+	bucket[slot.index_in_bucket] = moved_entity_index;
+	m_slots[moved_entity_index].index_in_bucket = slot.index_in_bucket;
+	bucket.pop_back();
+
+	if (bucket.empty()) {
+		m_buckets.erase(found);
+	}
+
+	slot.present = false;
+}
+
+// OrderedIndex<Component, Key, Compare>
+template <typename Component, typename Key, typename Compare>
+lecs::OrderedIndex<Component, Key, Compare>::OrderedIndex(ECS& ecs, Key Component::* field) : m_ecs(ecs), m_field(field) {
+	m_ecs.add_component_observer<Component>(this);
+
+	auto& component_array = m_ecs.get_component_array<Component>();
+	for (size_t i = 0; i < component_array.get_size(); ++i) {
+		insert(component_array.get_entity_index_from_component_index(i), component_array.get_data_from_component_index(i).*m_field);
+	}
+}
+
+template <typename Component, typename Key, typename Compare>
+lecs::OrderedIndex<Component, Key, Compare>::~OrderedIndex() {
+	m_ecs.remove_component_observer<Component>(this);
+}
+
+template <typename Component, typename Key, typename Compare>
+void lecs::OrderedIndex<Component, Key, Compare>::on_component_added(Entity entity) {
+	insert(entity.get_index(), m_ecs.get_component<Component>(entity)->*m_field);
+}
+
+template <typename Component, typename Key, typename Compare>
+void lecs::OrderedIndex<Component, Key, Compare>::on_component_removed(Entity entity) {
+	erase(entity.get_index());
+}
+
+template <typename Component, typename Key, typename Compare>
+void lecs::OrderedIndex<Component, Key, Compare>::on_component_changed(Entity entity) {
+	const Key& key = m_ecs.get_component<Component>(entity)->*m_field;
+	const EntityIndex entity_index = entity.get_index();
+	if (entity_index < m_slots.size() && m_slots[entity_index].present) {
+		const Key& indexed_key = m_slots[entity_index].entry->first;
+		const Compare& compare = m_entries.key_comp();
+		if (!compare(key, indexed_key) && !compare(indexed_key, key)) {
+			return;
+		}
+	}
+
+	erase(entity_index);
+	insert(entity_index, key);
+}
+
+template <typename Component, typename Key, typename Compare>
+lecs::Entity lecs::OrderedIndex<Component, Key, Compare>::find(const Key& key, EntityFilter filter) const {
+	auto range = m_entries.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (passes(it->second, filter)) {
+			return m_ecs.get_entity_from_index(it->second);
+		}
+	}
+	return Entity::Invalid;
+}
+
+template <typename Component, typename Key, typename Compare>
+void lecs::OrderedIndex<Component, Key, Compare>::find_all(const Key& key, std::vector<Entity>& out_entities, EntityFilter filter) const {
+	auto range = m_entries.equal_range(key);
+	for (auto it = range.first; it != range.second; ++it) {
+		if (passes(it->second, filter)) {
+			out_entities.push_back(m_ecs.get_entity_from_index(it->second));
+		}
+	}
+}
+
+template <typename Component, typename Key, typename Compare>
+void lecs::OrderedIndex<Component, Key, Compare>::find_range(const Key& min, const Key& max, std::vector<Entity>& out_entities, EntityFilter filter) const {
+	const auto end = m_entries.upper_bound(max);
+	for (auto it = m_entries.lower_bound(min); it != end; ++it) {
+		if (passes(it->second, filter)) {
+			out_entities.push_back(m_ecs.get_entity_from_index(it->second));
+		}
+	}
+}
+
+template <typename Component, typename Key, typename Compare>
+void lecs::OrderedIndex<Component, Key, Compare>::find_smallest(size_t count, std::vector<Entity>& out_entities, EntityFilter filter) const {
+	for (auto it = m_entries.begin(); it != m_entries.end() && count > 0; ++it) {
+		if (passes(it->second, filter)) {
+			out_entities.push_back(m_ecs.get_entity_from_index(it->second));
+			count--;
+		}
+	}
+}
+
+template <typename Component, typename Key, typename Compare>
+void lecs::OrderedIndex<Component, Key, Compare>::find_largest(size_t count, std::vector<Entity>& out_entities, EntityFilter filter) const {
+	for (auto it = m_entries.rbegin(); it != m_entries.rend() && count > 0; ++it) {
+		if (passes(it->second, filter)) {
+			out_entities.push_back(m_ecs.get_entity_from_index(it->second));
+			count--;
+		}
+	}
+}
+
+template <typename Component, typename Key, typename Compare>
+void lecs::OrderedIndex<Component, Key, Compare>::insert(EntityIndex entity_index, const Key& key) {
+	if (entity_index >= m_slots.size()) {
+		m_slots.resize(static_cast<size_t>(entity_index) + 1);
+	}
+
+	Slot& slot = m_slots[entity_index];
+	slot.entry = m_entries.emplace(key, entity_index);
+	slot.present = true;
+}
+
+template <typename Component, typename Key, typename Compare>
+void lecs::OrderedIndex<Component, Key, Compare>::erase(EntityIndex entity_index) {
+	if (entity_index >= m_slots.size() || !m_slots[entity_index].present) {
+		return;
+	}
+
+	Slot& slot = m_slots[entity_index];
+	m_entries.erase(slot.entry);
+	slot.present = false;
+}
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
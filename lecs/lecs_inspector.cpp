@@ -0,0 +1,182 @@
+// LECS (Lightweight Entity Component System) live inspector implementation file
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+
+#include <cstring>
+#include <new>
+#include <thread>
+#include <type_traits>
+
+namespace lecs {
+	namespace detail {
+		static const uint32_t INSPECTOR_MAGIC = 0x4943454Cu; // "LECI"
+		static const uint32_t INSPECTOR_VERSION = 1;
+		static const size_t INSPECTOR_WORD_COUNT = sizeof(InspectorSnapshot) / sizeof(uint64_t);
+
+		static_assert(std::is_trivially_copyable<InspectorSnapshot>::value, "InspectorSnapshot is copied as raw bytes");
+		static_assert(sizeof(InspectorSnapshot) % sizeof(uint64_t) == 0, "InspectorSnapshot is copied in 64 bit words");
+		static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "Atomics shared between processes must be lock free");
+
+		// The layout of the segment. The snapshot is copied word by word with relaxed atomics, so a reader overlapping
+		// a publish reads torn but well defined values, and the sequence tells it to copy again.
+		struct InspectorSegment {
+			// Written before the first publish.
+			uint32_t magic;
+			uint32_t version;
+			// Odd while a publish is writing the words, 0 before the first one.
+			std::atomic<uint64_t> sequence;
+			std::atomic<uint64_t> words[INSPECTOR_WORD_COUNT];
+		};
+
+		inline void copy_inspector_name(char (&destination)[InspectorSnapshot::MAX_NAME_LENGTH], const char* source) {
+			std::strncpy(destination, source, InspectorSnapshot::MAX_NAME_LENGTH - 1);
+			destination[InspectorSnapshot::MAX_NAME_LENGTH - 1] = '\0';
+		}
+	}
+}
+
+// InspectorPublisher
+bool lecs::InspectorPublisher::open(const std::string& name) {
+	if (!m_segment.create(name, sizeof(detail::InspectorSegment))) {
+		return false;
+	}
+
+	detail::InspectorSegment* segment = new (m_segment.get_data()) detail::InspectorSegment;
+	segment->magic = detail::INSPECTOR_MAGIC;
+	segment->version = detail::INSPECTOR_VERSION;
+	segment->sequence.store(0, std::memory_order_relaxed);
+	m_snapshot = InspectorSnapshot{};
+	return true;
+}
+
+void lecs::InspectorPublisher::close() {
+	m_segment.close();
+}
+
+void lecs::InspectorPublisher::set_timing(const char* name, std::chrono::nanoseconds time) {
+	char truncated_name[InspectorSnapshot::MAX_NAME_LENGTH];
+	detail::copy_inspector_name(truncated_name, name);
+
+	for (uint32_t i = 0; i < m_snapshot.timing_count; ++i) {
+		if (std::strcmp(m_snapshot.timings[i].name, truncated_name) == 0) {
+			m_snapshot.timings[i].nanoseconds = time.count();
+			return;
+		}
+	}
+
+	if (m_snapshot.timing_count < InspectorSnapshot::MAX_TIMINGS) {
+		InspectorSnapshot::Timing& timing = m_snapshot.timings[m_snapshot.timing_count++];
+		std::memcpy(timing.name, truncated_name, sizeof(truncated_name));
+		timing.nanoseconds = time.count();
+	}
+}
+
+void lecs::InspectorPublisher::publish(const ECS& ecs, std::chrono::nanoseconds frame_time) {
+	if (!m_segment.is_open()) {
+		return;
+	}
+
+	InspectorSnapshot& snapshot = m_snapshot;
+	snapshot.frame_number++;
+	snapshot.frame_time_nanoseconds = frame_time.count();
+	snapshot.alive_entity_count = static_cast<uint64_t>(ecs.get_alive_entity_count());
+	snapshot.entity_count = static_cast<uint64_t>(ecs.get_entity_count());
+	snapshot.max_entities = static_cast<uint64_t>(MAX_ENTITIES);
+	snapshot.stats = get_stats();
+	snapshot.memory_use = sizeof(ECS);
+	snapshot.pool_count = 0;
+	for (ComponentID::IDType component_id = 0; component_id < MAX_COMPONENTS; ++component_id) {
+		const IComponentArray* component_array = ecs.find_component_array(component_id);
+		if (component_array == nullptr) {
+			continue;
+		}
+
+		const size_t memory_use = component_array->get_memory_use();
+		snapshot.memory_use += memory_use;
+		if (snapshot.pool_count == InspectorSnapshot::MAX_POOLS) {
+			continue;
+		}
+
+		InspectorSnapshot::Pool& pool = snapshot.pools[snapshot.pool_count++];
+		pool = InspectorSnapshot::Pool{};
+		pool.component_id = static_cast<uint32_t>(component_id);
+		pool.component_count = component_array->get_component_count();
+		pool.memory_use = memory_use;
+		const ComponentType* type = m_registry != nullptr ? m_registry->find_by_component_id(component_id) : nullptr;
+		if (type != nullptr) {
+			detail::copy_inspector_name(pool.name, type->name.c_str());
+		}
+	}
+
+	uint64_t words[detail::INSPECTOR_WORD_COUNT];
+	std::memcpy(words, &snapshot, sizeof(snapshot));
+
+	// Odd first, so a reader that starts now or saw the previous sequence knows its copy may be torn.
+	detail::InspectorSegment& segment = *static_cast<detail::InspectorSegment*>(m_segment.get_data());
+	const uint64_t sequence = segment.sequence.load(std::memory_order_relaxed);
+	segment.sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	for (size_t i = 0; i < detail::INSPECTOR_WORD_COUNT; ++i) {
+		segment.words[i].store(words[i], std::memory_order_relaxed);
+	}
+	segment.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool lecs::read_inspector_snapshot(const std::string& name, InspectorSnapshot& out_snapshot, uint32_t max_attempts) {
+	SharedMemory shared_memory;
+	if (!shared_memory.open(name, sizeof(detail::InspectorSegment), false)) {
+		return false;
+	}
+
+	const detail::InspectorSegment& segment = *static_cast<const detail::InspectorSegment*>(shared_memory.get_data());
+	uint64_t words[detail::INSPECTOR_WORD_COUNT];
+	for (uint32_t attempt = 0; attempt < max_attempts; ++attempt) {
+		const uint64_t sequence = segment.sequence.load(std::memory_order_acquire);
+		if (sequence == 0) {
+			return false;
+		}
+		if (segment.magic != detail::INSPECTOR_MAGIC || segment.version != detail::INSPECTOR_VERSION) {
+			return false;
+		}
+		if (sequence % 2 != 0) {
+			std::this_thread::yield();
+			continue;
+		}
+
+		for (size_t i = 0; i < detail::INSPECTOR_WORD_COUNT; ++i) {
+			words[i] = segment.words[i].load(std::memory_order_relaxed);
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (segment.sequence.load(std::memory_order_relaxed) == sequence) {
+			std::memcpy(&out_snapshot, words, sizeof(out_snapshot));
+			return true;
+		}
+	}
+
+	return false;
+}
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
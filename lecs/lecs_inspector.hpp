@@ -0,0 +1,128 @@
+// LECS (Lightweight Entity Component System) live inspector
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+// USAGE:
+// This is optional. It uses SharedMemory and the ComponentRegistry, include lecs_inspector.hpp, lecs_shared_memory.hpp
+// and lecs_registry.hpp in the same .cpp where you #define LECS_IMPLEMENTATION.
+//
+// The publisher writes the stats of a world (entity count, pool sizes and memory, the LECS_STATS counters, and the
+// timings you give it) into a named shared memory segment, once per frame:
+// lecs::InspectorPublisher inspector(&registry); // the registry names the pools, it can be nullptr
+// inspector.open("/my_server");
+// ...
+// inspector.set_timing("physics", physics_time);
+// inspector.publish(my_ecs, frame_time);
+//
+// Any other process can read it at any time, eg. with tools/lecs_inspect.cpp:
+// lecs::InspectorSnapshot snapshot;
+// if (lecs::read_inspector_snapshot("/my_server", snapshot)) { /* ... */ }
+//
+// The segment is a seqlock: publish never waits for the readers, and a reader that overlaps a publish copies again.
+// Readers only map the segment while they copy it, so they can come and go without the simulation noticing.
+
+#pragma once
+
+#include "lecs.hpp"
+#include "lecs_registry.hpp"
+#include "lecs_shared_memory.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace lecs {
+	// What the publisher writes, and the readers copy. Only fixed size plain data, so it's the same in every process.
+	struct InspectorSnapshot {
+		static const uint32_t MAX_POOLS = 64;
+		static const uint32_t MAX_TIMINGS = 32;
+		static const uint32_t MAX_NAME_LENGTH = 32;
+
+		struct Pool {
+			uint32_t component_id;
+			uint32_t padding;
+			uint64_t component_count;
+			uint64_t memory_use;
+			// From the registry, or empty. Always null terminated.
+			char name[MAX_NAME_LENGTH];
+		};
+
+		struct Timing {
+			char name[MAX_NAME_LENGTH];
+			int64_t nanoseconds;
+		};
+
+		// Counts the publishes, starting from 1.
+		uint64_t frame_number;
+		int64_t frame_time_nanoseconds;
+		uint64_t alive_entity_count;
+		uint64_t entity_count;
+		uint64_t max_entities;
+		// The ECS and all of its pools, in bytes.
+		uint64_t memory_use;
+		// Zeros without LECS_STATS.
+		Stats stats;
+		uint32_t pool_count;
+		uint32_t timing_count;
+		Pool pools[MAX_POOLS];
+		Timing timings[MAX_TIMINGS];
+	};
+
+	class InspectorPublisher {
+	public:
+		explicit InspectorPublisher(const ComponentRegistry* registry = nullptr) : m_registry(registry) {}
+
+		InspectorPublisher(const InspectorPublisher&) = delete;
+		InspectorPublisher& operator=(const InspectorPublisher&) = delete;
+
+		// Creates the segment, see SharedMemory::create. It's removed when the publisher closes or is destroyed.
+		bool open(const std::string& name);
+		void close();
+		bool is_open() const { return m_segment.is_open(); }
+
+		// Sets a timing of the next publishes, eg. of a system or a query. Timings past MAX_TIMINGS are dropped.
+		void set_timing(const char* name, std::chrono::nanoseconds time);
+
+		// Writes the stats of the world into the segment. It never blocks, whatever the readers are doing.
+		// The pools past MAX_POOLS are left out, but still counted in memory_use.
+		void publish(const ECS& ecs, std::chrono::nanoseconds frame_time);
+
+	private:
+		const ComponentRegistry* m_registry;
+		SharedMemory m_segment;
+		// Built here, then copied into the segment.
+		InspectorSnapshot m_snapshot{};
+	};
+
+	// Maps the segment, copies a consistent snapshot and unmaps it. A copy that overlapped a publish is tried again,
+	// up to max_attempts times. Returns false if nothing was published with that name, or no copy was consistent.
+	bool read_inspector_snapshot(const std::string& name, InspectorSnapshot& out_snapshot, uint32_t max_attempts = 100);
+}
+
+#if defined(LECS_IMPLEMENTATION)
+#include "lecs_inspector.cpp"
+#endif // defined(LECS_IMPLEMENTATION)
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
@@ -0,0 +1,145 @@
+// LECS (Lightweight Entity Component System) job pool implementation file
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+
+namespace lecs {
+	namespace detail {
+		thread_local int32_t t_job_thread_index = 0;
+	}
+}
+
+lecs::JobPool::JobPool(int32_t worker_count) {
+	if (worker_count <= 0) {
+		const int32_t hardware_threads = static_cast<int32_t>(std::thread::hardware_concurrency());
+		worker_count = hardware_threads > 1 ? hardware_threads - 1 : 1;
+	}
+
+	m_workers.reserve(worker_count);
+	for (int32_t i = 0; i < worker_count; ++i) {
+		m_workers.emplace_back([this, i]() { worker_loop(i + 1); });
+	}
+}
+
+lecs::JobPool::~JobPool() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wake_condition.notify_all();
+
+	for (auto& worker : m_workers) {
+		worker.join();
+	}
+}
+
+void lecs::JobPool::submit(Job job, JobCounter* counter) {
+	if (counter) {
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_queue.push_back({ std::move(job), counter });
+	}
+	m_wake_condition.notify_one();
+}
+
+void lecs::JobPool::wait(JobCounter& counter) {
+	while (!counter.is_done()) {
+		if (try_run_one()) {
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_wake_condition.wait(lock, [this, &counter]() { return !m_queue.empty() || counter.is_done(); });
+	}
+}
+
+void lecs::JobPool::parallel_for(int32_t count, int32_t batch_size, const std::function<void(int32_t, int32_t)>& func) {
+	if (batch_size <= 0) {
+		batch_size = 1;
+	}
+
+	JobCounter counter;
+	for (int32_t begin = 0; begin < count; begin += batch_size) {
+		const int32_t end = count - begin > batch_size ? begin + batch_size : count;
+		submit([&func, begin, end]() { func(begin, end); }, &counter);
+	}
+
+	wait(counter);
+}
+
+int32_t lecs::JobPool::get_current_thread_index() {
+	return detail::t_job_thread_index;
+}
+
+void lecs::JobPool::worker_loop(int32_t thread_index) {
+	detail::t_job_thread_index = thread_index;
+
+	while (true) {
+		QueuedJob queued_job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_wake_condition.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+			if (m_queue.empty()) {
+				return; // stopping, and nothing left to run
+			}
+
+			queued_job = std::move(m_queue.front());
+			m_queue.pop_front();
+		}
+
+		run(queued_job);
+	}
+}
+
+bool lecs::JobPool::try_run_one() {
+	QueuedJob queued_job;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_queue.empty()) {
+			return false;
+		}
+
+		queued_job = std::move(m_queue.front());
+		m_queue.pop_front();
+	}
+
+	run(queued_job);
+	return true;
+}
+
+void lecs::JobPool::run(QueuedJob& queued_job) {
+	queued_job.job();
+
+	if (queued_job.counter && queued_job.counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		// Waiters check the counter while holding the lock, so take it to not miss their wake up.
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_wake_condition.notify_all();
+	}
+}
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
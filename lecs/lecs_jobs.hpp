@@ -0,0 +1,111 @@
+// LECS (Lightweight Entity Component System) job pool
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+// USAGE:
+// This is optional. If you use it, include this file in the same .cpp where you #define LECS_IMPLEMENTATION as well.
+//
+// A JobPool owns a few worker threads that run the jobs you submit eg.:
+// lecs::JobPool job_pool; // one worker per hardware thread, minus the calling one
+// lecs::JobCounter counter;
+// job_pool.submit([&]() { /* ... */ }, &counter);
+// job_pool.wait(counter); // the calling thread runs jobs too while it waits
+//
+// Or split a range of work in batches:
+// job_pool.parallel_for(count, 256, [&](int32_t begin, int32_t end) { /* ... */ });
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lecs {
+	// Counts the jobs that still have to finish. Wait on it with JobPool::wait.
+	struct JobCounter {
+		std::atomic<int32_t> pending{ 0 };
+
+		bool is_done() const { return pending.load(std::memory_order_acquire) == 0; }
+	};
+
+	class JobPool {
+	public:
+		using Job = std::function<void()>;
+
+		// A worker_count of 0 (or less) means one worker per hardware thread, minus the calling one.
+		explicit JobPool(int32_t worker_count = 0);
+		~JobPool();
+
+		JobPool(const JobPool&) = delete;
+		JobPool& operator=(const JobPool&) = delete;
+
+		// Jobs can submit other jobs. If a counter is passed, it is decremented once the job is done.
+		void submit(Job job, JobCounter* counter = nullptr);
+
+		// Runs pending jobs on the calling thread until the counter reaches zero.
+		void wait(JobCounter& counter);
+
+		// Calls func(begin, end) on batches of [0, count) and returns when all of them are done.
+		void parallel_for(int32_t count, int32_t batch_size, const std::function<void(int32_t, int32_t)>& func);
+
+		int32_t get_worker_count() const { return static_cast<int32_t>(m_workers.size()); }
+
+		// Threads that can run jobs: the workers plus the thread waiting on them.
+		int32_t get_thread_count() const { return get_worker_count() + 1; }
+
+		// 1..worker_count on the workers of any pool, 0 on any other thread.
+		static int32_t get_current_thread_index();
+
+	private:
+		struct QueuedJob {
+			Job job;
+			JobCounter* counter;
+		};
+
+		void worker_loop(int32_t thread_index);
+
+		// Returns false if there was nothing to run.
+		bool try_run_one();
+
+		void run(QueuedJob& queued_job);
+
+		std::vector<std::thread> m_workers;
+		std::deque<QueuedJob> m_queue;
+		std::mutex m_mutex;
+		std::condition_variable m_wake_condition;
+		bool m_stopping{ false };
+	};
+}
+
+#if defined(LECS_IMPLEMENTATION)
+#include "lecs_jobs.cpp"
+#endif // defined(LECS_IMPLEMENTATION)
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
@@ -0,0 +1,49 @@
+// LECS (Lightweight Entity Component System) component registry implementation file
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+
+// ComponentRegistry
+const lecs::ComponentType* lecs::ComponentRegistry::find_by_key(uint32_t key) const {
+	for (const ComponentType& type : m_types) {
+		if (type.key == key) {
+			return &type;
+		}
+	}
+
+	return nullptr;
+}
+
+const lecs::ComponentType* lecs::ComponentRegistry::find_by_component_id(ComponentID::IDType component_id) const {
+	for (const ComponentType& type : m_types) {
+		if (type.component_id == component_id) {
+			return &type;
+		}
+	}
+
+	return nullptr;
+}
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
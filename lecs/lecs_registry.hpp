@@ -0,0 +1,145 @@
+// LECS (Lightweight Entity Component System) component registry
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+// USAGE:
+// This is optional. If you use it, include this file in the same .cpp where you #define LECS_IMPLEMENTATION as well.
+//
+// ComponentID values depend on the order component types are first used, so they can differ between builds and runs.
+// Anything that stores components outside of the process (files, network) identifies them through a registry instead,
+// with keys of your choice that never change:
+// lecs::ComponentRegistry registry;
+// registry.register_component<Transform>(1, "Transform");
+// registry.register_component<Health>(2, "Health");
+//
+// The registry also lets that code work on components without knowing their type.
+
+#pragma once
+
+#include "lecs.hpp"
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace lecs {
+	struct ComponentType {
+		uint32_t key;
+		std::string name;
+		ComponentID::IDType component_id;
+		uint32_t size;
+		// Only these can be stored as raw bytes.
+		bool trivially_copyable;
+
+		// Returns nullptr if the entity doesn't have the component.
+		const void* (*get_component)(ECS& ecs, Entity entity);
+		// Every component of this type and the index of its entity, in the order of the compact array, visited once.
+		void (*get_components)(ECS& ecs, std::vector<EntityIndex>& out_entity_indices, std::vector<const void*>& out_components);
+		// Adds a default initialized component. Returns false if it could not be added.
+		bool (*add_component)(ECS& ecs, Entity entity);
+		// Adds the component, copying its value from the bytes. Returns false if it could not be added.
+		bool (*add_component_from_bytes)(ECS& ecs, Entity entity, const void* bytes);
+		// Overwrites the component the entity already has. Returns false if it doesn't have it.
+		bool (*set_component_from_bytes)(ECS& ecs, Entity entity, const void* bytes);
+		bool (*remove_component)(ECS& ecs, Entity entity);
+	};
+
+	class ComponentRegistry {
+	public:
+		// Returns false if the key or the type were already registered.
+		template <typename T>
+		bool register_component(uint32_t key, const char* name);
+
+		// Return nullptr if nothing was registered with that key (or type).
+		const ComponentType* find_by_key(uint32_t key) const;
+		const ComponentType* find_by_component_id(ComponentID::IDType component_id) const;
+
+		template <typename T>
+		const ComponentType* find() const { return find_by_component_id(ComponentID::get<T>()); }
+
+		const std::vector<ComponentType>& get_types() const { return m_types; }
+
+	private:
+		std::vector<ComponentType> m_types;
+	};
+}
+
+template <typename T>
+bool lecs::ComponentRegistry::register_component(uint32_t key, const char* name) {
+	const ComponentID::IDType component_id = ComponentID::get<T>();
+	if (find_by_key(key) != nullptr || find_by_component_id(component_id) != nullptr) {
+		return false;
+	}
+
+	ComponentType type;
+	type.key = key;
+	type.name = name;
+	type.component_id = component_id;
+	type.size = static_cast<uint32_t>(sizeof(T));
+	type.trivially_copyable = std::is_trivially_copyable<T>::value;
+
+	type.get_component = [](ECS& ecs, Entity entity) -> const void* {
+		return ecs.get_component<T>(entity);
+	};
+
+	type.get_components = [](ECS& ecs, std::vector<EntityIndex>& out_entity_indices, std::vector<const void*>& out_components) {
+		ComponentArray<T>& component_array = ecs.get_component_array<T>();
+		const size_t count = component_array.get_size();
+		out_entity_indices.resize(count);
+		out_components.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			out_entity_indices[i] = component_array.get_entity_index_from_component_index(i);
+			out_components[i] = &component_array.get_data_from_component_index(i);
+		}
+	};
+
+	type.add_component = [](ECS& ecs, Entity entity) -> bool {
+		return ecs.add_component_to_entity<T>(entity);
+	};
+
+	type.add_component_from_bytes = [](ECS& ecs, Entity entity, const void* bytes) -> bool {
+		// Constructed from the bytes directly, so the observers are only notified once, with the final value.
+		// Non trivially copyable types never get here from raw storage, as they are not written as bytes in the first place.
+		return ecs.emplace_component<T>(entity, *static_cast<const T*>(bytes)) != nullptr;
+	};
+
+	type.set_component_from_bytes = [](ECS& ecs, Entity entity, const void* bytes) -> bool {
+		return ecs.set_component<T>(entity, *static_cast<const T*>(bytes));
+	};
+
+	type.remove_component = [](ECS& ecs, Entity entity) -> bool {
+		return ecs.remove_component_from_entity<T>(entity);
+	};
+
+	m_types.push_back(std::move(type));
+	return true;
+}
+
+#if defined(LECS_IMPLEMENTATION)
+#include "lecs_registry.cpp"
+#endif // defined(LECS_IMPLEMENTATION)
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
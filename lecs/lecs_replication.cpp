@@ -0,0 +1,379 @@
+// LECS (Lightweight Entity Component System) replication implementation file
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+
+#include <cmath>
+#include <cstring>
+
+namespace lecs {
+	namespace detail {
+		inline uint32_t get_bit_mask(uint32_t bit_count) {
+			return bit_count >= 32 ? 0xFFFFFFFFu : (1u << bit_count) - 1;
+		}
+
+		inline uint32_t get_bits_for(uint32_t max_value) {
+			uint32_t bit_count = 1;
+			while (bit_count < 32 && (max_value >> bit_count) != 0) {
+				bit_count++;
+			}
+			return bit_count;
+		}
+
+		static const uint32_t REPLICATED_ENTITY_INDEX_BITS = get_bits_for(static_cast<uint32_t>(MAX_ENTITIES - 1));
+	}
+}
+
+// BitWriter
+void lecs::BitWriter::write(uint32_t value, uint32_t bit_count) {
+	m_scratch |= static_cast<uint64_t>(value & detail::get_bit_mask(bit_count)) << m_scratch_bits;
+	m_scratch_bits += bit_count;
+	while (m_scratch_bits >= 8) {
+		m_bytes.push_back(static_cast<uint8_t>(m_scratch));
+		m_scratch >>= 8;
+		m_scratch_bits -= 8;
+	}
+}
+
+void lecs::BitWriter::write_varint(uint64_t value) {
+	while (value >= 0x80) {
+		write(static_cast<uint32_t>(value & 0x7F) | 0x80, 8);
+		value >>= 7;
+	}
+	write(static_cast<uint32_t>(value), 8);
+}
+
+void lecs::BitWriter::flush() {
+	if (m_scratch_bits > 0) {
+		m_bytes.push_back(static_cast<uint8_t>(m_scratch));
+		m_scratch = 0;
+		m_scratch_bits = 0;
+	}
+}
+
+void lecs::BitWriter::clear() {
+	m_bytes.clear();
+	m_scratch = 0;
+	m_scratch_bits = 0;
+}
+
+// BitReader
+bool lecs::BitReader::read(uint32_t bit_count, uint32_t& out_value) {
+	while (!m_failed && m_scratch_bits < bit_count) {
+		if (m_position >= m_size) {
+			m_failed = true;
+			break;
+		}
+		m_scratch |= static_cast<uint64_t>(m_data[m_position++]) << m_scratch_bits;
+		m_scratch_bits += 8;
+	}
+
+	if (m_failed) {
+		out_value = 0;
+		return false;
+	}
+
+	out_value = static_cast<uint32_t>(m_scratch) & detail::get_bit_mask(bit_count);
+	m_scratch >>= bit_count;
+	m_scratch_bits -= bit_count;
+	return true;
+}
+
+bool lecs::BitReader::read_bool(bool& out_value) {
+	uint32_t value;
+	const bool succeeded = read(1, value);
+	out_value = value != 0;
+	return succeeded;
+}
+
+bool lecs::BitReader::read_varint(uint64_t& out_value) {
+	out_value = 0;
+	for (uint32_t shift = 0; shift < 64; shift += 7) {
+		uint32_t byte;
+		if (!read(8, byte)) {
+			return false;
+		}
+
+		out_value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return true;
+		}
+	}
+
+	m_failed = true;
+	return false;
+}
+
+// ReplicatedField
+uint32_t lecs::ReplicatedField::quantize(const unsigned char* component) const {
+	const uint32_t mask = detail::get_bit_mask(bit_count);
+	switch (kind) {
+	case Kind::Unsigned: {
+		uint32_t value;
+		std::memcpy(&value, component + offset, sizeof(value));
+		return value & mask;
+	}
+	case Kind::Signed: {
+		int32_t value;
+		std::memcpy(&value, component + offset, sizeof(value));
+		const uint32_t zigzag = (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+		return zigzag & mask;
+	}
+	case Kind::Float: {
+		float value;
+		std::memcpy(&value, component + offset, sizeof(value));
+		if (!(value > min)) { // NaN goes to min as well
+			return 0;
+		}
+		if (value >= max) {
+			return mask;
+		}
+		return static_cast<uint32_t>(std::floor((static_cast<double>(value) - min) / (static_cast<double>(max) - min) * mask + 0.5));
+	}
+	case Kind::Bool: {
+		bool value;
+		std::memcpy(&value, component + offset, sizeof(value));
+		return value ? 1u : 0u;
+	}
+	}
+
+	return 0;
+}
+
+void lecs::ReplicatedField::dequantize(uint32_t value, unsigned char* component) const {
+	switch (kind) {
+	case Kind::Unsigned: {
+		std::memcpy(component + offset, &value, sizeof(value));
+		break;
+	}
+	case Kind::Signed: {
+		const int32_t signed_value = static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+		std::memcpy(component + offset, &signed_value, sizeof(signed_value));
+		break;
+	}
+	case Kind::Float: {
+		const float float_value = static_cast<float>(min + (static_cast<double>(max) - min) * value / detail::get_bit_mask(bit_count));
+		std::memcpy(component + offset, &float_value, sizeof(float_value));
+		break;
+	}
+	case Kind::Bool: {
+		const bool bool_value = value != 0;
+		std::memcpy(component + offset, &bool_value, sizeof(bool_value));
+		break;
+	}
+	}
+}
+
+// ReplicationEncoder
+// Packet format:
+// - removed entities: (1, entity)... 0
+// - for each component of the schema, in order:
+//   - changed components: (1, entity, for each field: (1, value) or 0)... 0
+//   - removed components: (1, entity)... 0
+// Entities are sent as their server handle: index, then generation as a varint.
+void lecs::ReplicationEncoder::encode(ECS& ecs, const std::vector<Entity>& selection, std::vector<uint8_t>& out_packet) {
+	const auto& components = m_schema.get_components();
+	m_pools.resize(components.size());
+	m_encode_count++;
+	m_writer.clear();
+
+	const size_t entity_count = static_cast<size_t>(ecs.get_entity_count());
+	m_selected.assign(entity_count, false);
+	for (Entity entity : selection) {
+		if (ecs.is_entity_handle_active(entity)) {
+			m_selected[entity.get_index()] = true;
+		}
+	}
+
+	if (m_known_entities.size() < entity_count) {
+		m_known_entities.resize(entity_count, Entity::Invalid);
+	}
+
+	for (size_t entity_index = 0; entity_index < m_known_entities.size(); ++entity_index) {
+		const Entity known_entity = m_known_entities[entity_index];
+		if (!known_entity.is_valid() || (entity_index < entity_count && m_selected[entity_index] && ecs.is_entity_handle_active(known_entity))) {
+			continue;
+		}
+
+		m_writer.write_bool(true);
+		write_entity(known_entity);
+		m_known_entities[entity_index] = Entity::Invalid;
+		for (PoolBaseline& pool : m_pools) {
+			if (entity_index < pool.present.size()) {
+				pool.present[entity_index] = false;
+			}
+		}
+	}
+	m_writer.write_bool(false);
+
+	for (size_t pool_index = 0; pool_index < components.size(); ++pool_index) {
+		components[pool_index]->encode(ecs, *this, pool_index);
+		m_writer.write_bool(false);
+
+		// Components the client has, that were not seen in this pass, were removed.
+		PoolBaseline& pool = m_pools[pool_index];
+		for (size_t entity_index = 0; entity_index < pool.present.size(); ++entity_index) {
+			if (pool.present[entity_index] && pool.seen[entity_index] != m_encode_count) {
+				m_writer.write_bool(true);
+				write_entity(m_known_entities[entity_index]);
+				pool.present[entity_index] = false;
+			}
+		}
+		m_writer.write_bool(false);
+	}
+
+	m_writer.flush();
+	out_packet = m_writer.get_bytes();
+}
+
+void lecs::ReplicationEncoder::reset() {
+	m_pools.clear();
+	m_known_entities.clear();
+}
+
+void lecs::ReplicationEncoder::encode_component(size_t pool_index, Entity entity, const unsigned char* component) {
+	const std::vector<ReplicatedField>& fields = m_schema.get_components()[pool_index]->get_fields();
+	const EntityIndex entity_index = entity.get_index();
+	PoolBaseline& pool = m_pools[pool_index];
+	if (pool.present.size() <= entity_index) {
+		pool.present.resize(static_cast<size_t>(entity_index) + 1, false);
+		pool.seen.resize(static_cast<size_t>(entity_index) + 1, 0);
+		pool.values.resize((static_cast<size_t>(entity_index) + 1) * fields.size(), 0);
+	}
+	pool.seen[entity_index] = m_encode_count;
+
+	m_quantized.resize(fields.size());
+	uint32_t* sent_values = pool.values.data() + static_cast<size_t>(entity_index) * fields.size();
+	bool changed = !pool.present[entity_index];
+	for (size_t i = 0; i < fields.size(); ++i) {
+		m_quantized[i] = fields[i].quantize(component);
+		changed |= m_quantized[i] != sent_values[i];
+	}
+
+	if (!changed) {
+		return;
+	}
+
+	m_writer.write_bool(true);
+	write_entity(entity);
+	for (size_t i = 0; i < fields.size(); ++i) {
+		const bool field_changed = !pool.present[entity_index] || m_quantized[i] != sent_values[i];
+		m_writer.write_bool(field_changed);
+		if (field_changed) {
+			m_writer.write(m_quantized[i], fields[i].bit_count);
+			sent_values[i] = m_quantized[i];
+		}
+	}
+
+	pool.present[entity_index] = true;
+	m_known_entities[entity_index] = entity;
+}
+
+void lecs::ReplicationEncoder::write_entity(Entity entity) {
+	m_writer.write(entity.get_index(), detail::REPLICATED_ENTITY_INDEX_BITS);
+	m_writer.write_varint(entity.get_generation());
+}
+
+// ReplicationDecoder
+bool lecs::ReplicationDecoder::decode(const std::vector<uint8_t>& packet, ECS& ecs) {
+	BitReader reader(packet.data(), packet.size());
+	bool more;
+	Entity remote_entity;
+
+	while (reader.read_bool(more) && more) {
+		if (!read_entity(reader, remote_entity)) {
+			return false;
+		}
+
+		auto it = m_local_entities.find(remote_entity.id);
+		if (it != m_local_entities.end()) {
+			ecs.remove_entity(it->second);
+			m_local_entities.erase(it);
+		}
+	}
+
+	for (const auto& component : m_schema.get_components()) {
+		const std::vector<ReplicatedField>& fields = component->get_fields();
+		while (reader.read_bool(more) && more) {
+			if (!read_entity(reader, remote_entity)) {
+				return false;
+			}
+
+			auto it = m_local_entities.find(remote_entity.id);
+			if (it == m_local_entities.end()) {
+				it = m_local_entities.emplace(remote_entity.id, ecs.create_entity()).first;
+			}
+
+			const bool is_written = component->write(ecs, it->second, [&](unsigned char* data) {
+				for (const ReplicatedField& field : fields) {
+					bool field_changed;
+					uint32_t value;
+					if (!reader.read_bool(field_changed) || (field_changed && !reader.read(field.bit_count, value))) {
+						return false;
+					}
+					if (field_changed) {
+						field.dequantize(value, data);
+					}
+				}
+				return true;
+			});
+			if (!is_written) {
+				return false;
+			}
+		}
+
+		while (reader.read_bool(more) && more) {
+			if (!read_entity(reader, remote_entity)) {
+				return false;
+			}
+
+			auto it = m_local_entities.find(remote_entity.id);
+			if (it != m_local_entities.end()) {
+				component->remove(ecs, it->second);
+			}
+		}
+	}
+
+	return !reader.has_failed();
+}
+
+lecs::Entity lecs::ReplicationDecoder::get_local_entity(Entity remote_entity) const {
+	auto it = m_local_entities.find(remote_entity.id);
+	return it != m_local_entities.end() ? it->second : Entity::Invalid;
+}
+
+bool lecs::ReplicationDecoder::read_entity(BitReader& reader, Entity& out_remote_entity) const {
+	uint32_t index;
+	uint64_t generation;
+	if (!reader.read(detail::REPLICATED_ENTITY_INDEX_BITS, index) || !reader.read_varint(generation) ||
+		index >= static_cast<uint32_t>(MAX_ENTITIES) || generation > 0xFFFFFFFFu) {
+		return false;
+	}
+
+	out_remote_entity = Entity{ index, static_cast<EntityGeneration>(generation) };
+	return true;
+}
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
@@ -0,0 +1,294 @@
+// LECS (Lightweight Entity Component System) replication
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+// USAGE:
+// This is optional. If you use it, include this file in the same .cpp where you #define LECS_IMPLEMENTATION as well.
+//
+// Replicated components describe their fields, with the bits to use for each one (and the range of floats, which are quantized).
+// The server and the clients must build the same schema, in the same order:
+// lecs::ReplicationSchema schema;
+// schema.add_component<Transform>()
+//		->add_field(&Transform::x, -1024.0f, 1024.0f, 16)
+//		.add_field(&Transform::y, -1024.0f, 1024.0f, 16);
+// schema.add_component<Health>()->add_field(&Health::points, 10);
+//
+// The server keeps an encoder per client. Each call writes only what changed since the previous one, for the selected entities
+// (eg. the ones relevant to that client), going once through the compact array of each replicated component:
+// lecs::ReplicationEncoder encoder(schema);
+// encoder.encode(server_ecs, relevant_entities, packet);
+//
+// The client applies the packets in order, creating and removing its own entities as needed:
+// lecs::ReplicationDecoder decoder(schema);
+// decoder.decode(packet, client_ecs);
+// lecs::Entity local_entity = decoder.get_local_entity(server_entity);
+//
+// Packets are deltas of the previous ones, so the transport must deliver all of them, in order.
+// If a client loses some, reset its encoder and the next packet sends everything again.
+
+#pragma once
+
+#include "lecs.hpp"
+
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace lecs {
+	class BitWriter {
+	public:
+		// bit_count goes from 1 to 32, the bits of value above it are ignored.
+		void write(uint32_t value, uint32_t bit_count);
+		void write_bool(bool value) { write(value ? 1u : 0u, 1); }
+		// 7 bits at a time, small values take less space.
+		void write_varint(uint64_t value);
+
+		// Writes the last partial byte, padded with zeros. Call it once, after the last write.
+		void flush();
+
+		const std::vector<uint8_t>& get_bytes() const { return m_bytes; }
+		size_t get_bit_count() const { return m_bytes.size() * 8 + m_scratch_bits; }
+
+		void clear();
+
+	private:
+		std::vector<uint8_t> m_bytes;
+		uint64_t m_scratch{ 0 };
+		uint32_t m_scratch_bits{ 0 };
+	};
+
+	class BitReader {
+	public:
+		BitReader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+		// Return false when reading past the end, and keep returning false after that.
+		bool read(uint32_t bit_count, uint32_t& out_value);
+		bool read_bool(bool& out_value);
+		bool read_varint(uint64_t& out_value);
+
+		bool has_failed() const { return m_failed; }
+
+	private:
+		const uint8_t* m_data;
+		size_t m_size;
+		size_t m_position{ 0 };
+		uint64_t m_scratch{ 0 };
+		uint32_t m_scratch_bits{ 0 };
+		bool m_failed{ false };
+	};
+
+	struct ReplicatedField {
+		enum class Kind {
+			Unsigned,
+			// Zigzag encoded, so small negative values take few bits too.
+			Signed,
+			// Quantized in [min, max].
+			Float,
+			Bool
+		};
+
+		Kind kind;
+		// Of the field in the component.
+		size_t offset;
+		uint32_t bit_count;
+		float min;
+		float max;
+
+		uint32_t quantize(const unsigned char* component) const;
+		void dequantize(uint32_t value, unsigned char* component) const;
+	};
+
+	class ReplicationEncoder;
+
+	// Type erased access to a replicated component type, see ReplicatedComponent<T>.
+	class IReplicatedComponent {
+	public:
+		virtual ~IReplicatedComponent() = default;
+
+		const std::vector<ReplicatedField>& get_fields() const { return m_fields; }
+		ComponentID::IDType get_component_id() const { return m_component_id; }
+
+		// Passes every component of the ECS to the encoder, in the order of the compact array.
+		virtual void encode(ECS& ecs, ReplicationEncoder& encoder, size_t pool_index) const = 0;
+
+		// Calls write_fields on the component of the entity, and notifies its observers of the change. A component the
+		// entity doesn't have yet is written in a local value and then added with it, so its observers see the decoded value.
+		// Returns false, adding nothing, if write_fields does.
+		virtual bool write(ECS& ecs, Entity entity, const std::function<bool(unsigned char* component)>& write_fields) const = 0;
+		virtual void remove(ECS& ecs, Entity entity) const = 0;
+
+	protected:
+		explicit IReplicatedComponent(ComponentID::IDType component_id) : m_component_id(component_id) {}
+
+		std::vector<ReplicatedField> m_fields;
+		ComponentID::IDType m_component_id;
+	};
+
+	template <typename T>
+	class ReplicatedComponent : public IReplicatedComponent {
+	public:
+		ReplicatedComponent() : IReplicatedComponent(ComponentID::get<T>()) {}
+
+		// Values must fit in bit_count bits (signed values with their sign).
+		ReplicatedComponent& add_field(uint32_t T::* member, uint32_t bit_count) { return add(ReplicatedField::Kind::Unsigned, offset_of(member), bit_count, 0.0f, 0.0f); }
+		ReplicatedComponent& add_field(int32_t T::* member, uint32_t bit_count) { return add(ReplicatedField::Kind::Signed, offset_of(member), bit_count, 0.0f, 0.0f); }
+		// Values are clamped in [min, max], and rounded to one of the 2^bit_count steps of the range.
+		ReplicatedComponent& add_field(float T::* member, float min, float max, uint32_t bit_count) { return add(ReplicatedField::Kind::Float, offset_of(member), bit_count, min, max); }
+		ReplicatedComponent& add_field(bool T::* member) { return add(ReplicatedField::Kind::Bool, offset_of(member), 1, 0.0f, 0.0f); }
+
+		void encode(ECS& ecs, ReplicationEncoder& encoder, size_t pool_index) const override;
+
+		bool write(ECS& ecs, Entity entity, const std::function<bool(unsigned char* component)>& write_fields) const override {
+			if (T* component = ecs.get_component<T>(entity)) {
+				if (!write_fields(reinterpret_cast<unsigned char*>(component))) {
+					return false;
+				}
+				ecs.notify_component_changed<T>(entity);
+				return true;
+			}
+
+			T component{};
+			if (!write_fields(reinterpret_cast<unsigned char*>(&component))) {
+				return false;
+			}
+			return ecs.emplace_component<T>(entity, std::move(component)) != nullptr;
+		}
+
+		void remove(ECS& ecs, Entity entity) const override {
+			ecs.remove_component_from_entity<T>(entity);
+		}
+
+	private:
+		template <typename M>
+		static size_t offset_of(M T::* member) {
+			static const T sample{};
+			return static_cast<size_t>(reinterpret_cast<const unsigned char*>(&(sample.*member)) - reinterpret_cast<const unsigned char*>(&sample));
+		}
+
+		ReplicatedComponent& add(ReplicatedField::Kind kind, size_t offset, uint32_t bit_count, float min, float max) {
+			bit_count = bit_count < 1 ? 1 : (bit_count > 32 ? 32 : bit_count);
+			m_fields.push_back({ kind, offset, bit_count, min, max });
+			return *this;
+		}
+	};
+
+	class ReplicationSchema {
+	public:
+		// The order of the components is part of the format. Returns nullptr if T was already added.
+		template <typename T>
+		ReplicatedComponent<T>* add_component();
+
+		const std::vector<std::unique_ptr<IReplicatedComponent>>& get_components() const { return m_components; }
+
+	private:
+		std::vector<std::unique_ptr<IReplicatedComponent>> m_components;
+	};
+
+	// Keeps what one client received, to send it only what changed.
+	class ReplicationEncoder {
+	public:
+		explicit ReplicationEncoder(const ReplicationSchema& schema) : m_schema(schema) {}
+
+		// Writes the changes of the selected entities since the previous call. The entities that were selected
+		// before, and aren't anymore (or were removed), are removed from the client.
+		void encode(ECS& ecs, const std::vector<Entity>& selection, std::vector<uint8_t>& out_packet);
+
+		// Forgets what was sent, the next packet sends everything again.
+		void reset();
+
+	private:
+		template <typename T>
+		friend class ReplicatedComponent;
+
+		struct PoolBaseline {
+			std::vector<bool> present;
+			// Number of the encode that last saw the component, by entity index.
+			std::vector<uint32_t> seen;
+			// The quantized fields sent last, by entity index.
+			std::vector<uint32_t> values;
+		};
+
+		void encode_component(size_t pool_index, Entity entity, const unsigned char* component);
+		void write_entity(Entity entity);
+
+		const ReplicationSchema& m_schema;
+		std::vector<PoolBaseline> m_pools;
+		// The entities the client knows, by index.
+		std::vector<Entity> m_known_entities;
+		std::vector<bool> m_selected;
+		uint32_t m_encode_count{ 0 };
+		std::vector<uint32_t> m_quantized;
+		BitWriter m_writer;
+	};
+
+	class ReplicationDecoder {
+	public:
+		explicit ReplicationDecoder(const ReplicationSchema& schema) : m_schema(schema) {}
+
+		// Returns false if the packet is malformed, what was decoded before the error is kept.
+		bool decode(const std::vector<uint8_t>& packet, ECS& ecs);
+
+		// Returns Entity::Invalid if the server entity is not replicated here.
+		Entity get_local_entity(Entity remote_entity) const;
+
+	private:
+		bool read_entity(BitReader& reader, Entity& out_remote_entity) const;
+
+		const ReplicationSchema& m_schema;
+		std::unordered_map<Entity::IDType, Entity> m_local_entities;
+	};
+}
+
+template <typename T>
+void lecs::ReplicatedComponent<T>::encode(ECS& ecs, ReplicationEncoder& encoder, size_t pool_index) const {
+	auto& component_array = ecs.get_component_array<T>();
+	for (size_t i = 0; i < component_array.get_size(); ++i) {
+		const EntityIndex entity_index = component_array.get_entity_index_from_component_index(i);
+		if (entity_index < encoder.m_selected.size() && encoder.m_selected[entity_index]) {
+			encoder.encode_component(pool_index, ecs.get_entity_from_index(entity_index),
+				reinterpret_cast<const unsigned char*>(&component_array.get_data_from_component_index(i)));
+		}
+	}
+}
+
+template <typename T>
+lecs::ReplicatedComponent<T>* lecs::ReplicationSchema::add_component() {
+	for (const auto& component : m_components) {
+		if (component->get_component_id() == ComponentID::get<T>()) {
+			return nullptr;
+		}
+	}
+
+	ReplicatedComponent<T>* component = new ReplicatedComponent<T>();
+	m_components.emplace_back(component);
+	return component;
+}
+
+#if defined(LECS_IMPLEMENTATION)
+#include "lecs_replication.cpp"
+#endif // defined(LECS_IMPLEMENTATION)
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
@@ -0,0 +1,453 @@
+// LECS (Lightweight Entity Component System) scheduler implementation file
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <ostream>
+
+// FrameProfiler
+lecs::FrameProfiler::FrameProfiler(int32_t max_recorded_frames)
+	: m_max_recorded_frames(max_recorded_frames > 0 ? max_recorded_frames : 1),
+	m_start_time(std::chrono::steady_clock::now()) {}
+
+void lecs::FrameProfiler::begin_frame(int32_t thread_count) {
+	// Recycle the oldest frame, so its event storage is reused.
+	Frame frame;
+	if (static_cast<int32_t>(m_frames.size()) >= m_max_recorded_frames) {
+		frame = std::move(m_frames.front());
+		m_frames.pop_front();
+	}
+
+	frame.number = m_frame_number++;
+	frame.begin_us = now_us();
+	frame.end_us = frame.begin_us;
+	frame.thread_count = thread_count > 0 ? thread_count : 1;
+	frame.step_count = 0;
+	frame.events.clear();
+	m_frames.push_back(std::move(frame));
+	m_frame_open = true;
+}
+
+void lecs::FrameProfiler::end_frame() {
+	if (m_frame_open) {
+		m_frames.back().end_us = now_us();
+		m_frame_open = false;
+	}
+}
+
+int32_t lecs::FrameProfiler::begin_step() {
+	return m_frame_open ? m_frames.back().step_count++ : -1;
+}
+
+int32_t lecs::FrameProfiler::add_event(const std::string& group, const std::string& name, int32_t step) {
+	if (!m_frame_open) {
+		return -1;
+	}
+
+	std::vector<Event>& events = m_frames.back().events;
+	events.emplace_back();
+	Event& event = events.back();
+	event.name = name;
+	event.group = group;
+	event.step = step;
+	return static_cast<int32_t>(events.size()) - 1;
+}
+
+void lecs::FrameProfiler::add_dependency(int32_t event_index, int32_t depends_on_event_index) {
+	if (m_frame_open && event_index >= 0 && depends_on_event_index >= 0) {
+		m_frames.back().events[event_index].dependencies.push_back(depends_on_event_index);
+	}
+}
+
+void lecs::FrameProfiler::record(int32_t event_index, double begin_us, double end_us, int32_t thread_index) {
+	// Each event is written by the one thread that ran it, and the vector doesn't grow while a step runs.
+	if (m_frame_open && event_index >= 0) {
+		Event& event = m_frames.back().events[event_index];
+		event.begin_us = begin_us;
+		event.end_us = end_us;
+		event.thread_index = thread_index;
+	}
+}
+
+double lecs::FrameProfiler::now_us() const {
+	return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_start_time).count();
+}
+
+lecs::FrameProfiler::FrameStats lecs::FrameProfiler::compute_frame_stats(int32_t frame_index) const {
+	const Frame& frame = m_frames[frame_index];
+	const std::vector<Event>& events = frame.events;
+
+	FrameStats stats;
+	stats.frame_number = frame.number;
+	stats.wall_time_us = frame.end_us - frame.begin_us;
+
+	// Longest path through the dependencies. They always point to earlier events of the same step,
+	// and steps are serialized, so one pass per step is enough and the frame's path is the concatenation of the steps' ones.
+	std::vector<double> finish_us(events.size(), 0.0);
+	std::vector<int32_t> predecessor(events.size(), -1);
+	std::vector<int32_t> step_last_event(frame.step_count, -1);
+
+	for (size_t i = 0; i < events.size(); ++i) {
+		const Event& event = events[i];
+		const double duration_us = event.end_us - event.begin_us;
+		stats.busy_time_us += duration_us;
+
+		double start_us = 0.0;
+		for (int32_t dependency : event.dependencies) {
+			if (finish_us[dependency] > start_us) {
+				start_us = finish_us[dependency];
+				predecessor[i] = dependency;
+			}
+		}
+		finish_us[i] = start_us + duration_us;
+
+		int32_t& last_event = step_last_event[event.step];
+		if (last_event < 0 || finish_us[i] > finish_us[last_event]) {
+			last_event = static_cast<int32_t>(i);
+		}
+	}
+
+	for (int32_t last_event : step_last_event) {
+		if (last_event < 0) {
+			continue;
+		}
+
+		stats.critical_path_us += finish_us[last_event];
+
+		const size_t step_path_begin = stats.critical_path.size();
+		for (int32_t event_index = last_event; event_index >= 0; event_index = predecessor[event_index]) {
+			stats.critical_path.push_back(event_index);
+		}
+		std::reverse(stats.critical_path.begin() + step_path_begin, stats.critical_path.end());
+	}
+
+	if (stats.wall_time_us > 0.0) {
+		stats.parallel_efficiency = static_cast<float>(stats.busy_time_us / (frame.thread_count * stats.wall_time_us));
+	}
+
+	return stats;
+}
+
+namespace lecs {
+	namespace detail {
+		inline void write_json_string(std::ostream& out, const std::string& string) {
+			out << '"';
+			for (char c : string) {
+				switch (c) {
+				case '"': out << "\\\""; break;
+				case '\\': out << "\\\\"; break;
+				case '\n': out << "\\n"; break;
+				case '\t': out << "\\t"; break;
+				default:
+					if (static_cast<unsigned char>(c) >= 0x20) {
+						out << c;
+					}
+				}
+			}
+			out << '"';
+		}
+	}
+}
+
+void lecs::FrameProfiler::write_chrome_trace(std::ostream& out) const {
+	int32_t max_thread_count = 1;
+	for (const Frame& frame : m_frames) {
+		max_thread_count = std::max(max_thread_count, frame.thread_count);
+	}
+
+	// Timestamps are microseconds, keep the fraction and avoid the scientific notation.
+	const std::ios::fmtflags old_flags = out.flags();
+	const std::streamsize old_precision = out.precision();
+	out << std::fixed << std::setprecision(3);
+
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	for (int32_t thread_index = 0; thread_index < max_thread_count; ++thread_index) {
+		out << (thread_index == 0 ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread_index
+			<< ",\"args\":{\"name\":\"" << (thread_index == 0 ? "main" : "worker ");
+		if (thread_index > 0) {
+			out << thread_index;
+		}
+		out << "\"}}";
+	}
+
+	for (const Frame& frame : m_frames) {
+		out << ",\n{\"name\":\"frame " << frame.number << "\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":" << frame.begin_us
+			<< ",\"dur\":" << (frame.end_us - frame.begin_us) << "}";
+
+		for (const Event& event : frame.events) {
+			out << ",\n{\"name\":";
+			detail::write_json_string(out, event.name);
+			out << ",\"cat\":";
+			detail::write_json_string(out, event.group);
+			out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread_index << ",\"ts\":" << event.begin_us
+				<< ",\"dur\":" << (event.end_us - event.begin_us) << ",\"args\":{\"frame\":" << frame.number << ",\"step\":" << event.step << "}}";
+		}
+	}
+	out << "\n]}\n";
+
+	out.flags(old_flags);
+	out.precision(old_precision);
+}
+
+bool lecs::FrameProfiler::save_chrome_trace(const char* path) const {
+	std::ofstream file(path, std::ios::out | std::ios::trunc);
+	if (!file) {
+		return false;
+	}
+
+	write_chrome_trace(file);
+	return static_cast<bool>(file);
+}
+
+void lecs::FrameProfiler::clear() {
+	m_frames.clear();
+	m_frame_open = false;
+}
+
+// SystemGroup
+lecs::SystemGroup::SystemGroup(const char* name, float tick_rate_hz, int32_t max_steps_per_update)
+	: m_name(name),
+	m_tick_rate(tick_rate_hz > 0.0f ? tick_rate_hz : 0.0f),
+	m_step(tick_rate_hz > 0.0f ? 1.0 / static_cast<double>(tick_rate_hz) : 0.0),
+	m_max_steps_per_update(max_steps_per_update > 0 ? max_steps_per_update : 1) {}
+
+void lecs::SystemGroup::add_system(const char* name, SystemFunction system) {
+	std::vector<int32_t> dependencies;
+	if (!m_systems.empty()) {
+		dependencies.push_back(static_cast<int32_t>(m_systems.size()) - 1);
+	}
+
+	add_system_with_dependency_indices(name, std::move(system), std::move(dependencies));
+}
+
+bool lecs::SystemGroup::add_system(const char* name, SystemFunction system, const std::vector<std::string>& dependencies) {
+	std::vector<int32_t> dependency_indices;
+	for (const std::string& dependency : dependencies) {
+		auto found = std::find_if(m_systems.begin(), m_systems.end(), [&dependency](const System& other) { return other.name == dependency; });
+		if (found == m_systems.end()) {
+			return false;
+		}
+
+		dependency_indices.push_back(static_cast<int32_t>(found - m_systems.begin()));
+	}
+
+	add_system_with_dependency_indices(name, std::move(system), std::move(dependency_indices));
+	return true;
+}
+
+void lecs::SystemGroup::add_system_with_dependency_indices(const char* name, SystemFunction system, std::vector<int32_t> dependencies) {
+	const int32_t system_index = static_cast<int32_t>(m_systems.size());
+	for (int32_t dependency : dependencies) {
+		m_systems[dependency].dependents.push_back(system_index);
+	}
+
+	m_systems.push_back({ name, std::move(system), std::move(dependencies), {} });
+	m_remaining_dependencies.reset(new std::atomic<int32_t>[m_systems.size()]);
+}
+
+void lecs::SystemGroup::set_phase_offset(float phase) {
+	phase = phase - std::floor(phase); // wrap into [0, 1)
+
+	// The accumulator starts negative by the phase, so the first tick happens later.
+	m_accumulator -= static_cast<double>(phase - m_phase) * m_step;
+	m_phase = phase;
+}
+
+void lecs::SystemGroup::set_max_steps_per_update(int32_t max_steps_per_update) {
+	m_max_steps_per_update = max_steps_per_update > 0 ? max_steps_per_update : 1;
+}
+
+int32_t lecs::SystemGroup::update(ECS& ecs, float delta_time) {
+	if (!is_fixed_rate()) {
+		run_systems(ecs, delta_time);
+		m_tick_count++;
+		return 1;
+	}
+
+	m_accumulator += static_cast<double>(delta_time);
+
+	int32_t steps = 0;
+	while (m_accumulator >= m_step && steps < m_max_steps_per_update) {
+		run_systems(ecs, static_cast<float>(m_step));
+		m_accumulator -= m_step;
+		m_tick_count++;
+		steps++;
+	}
+
+	// Catch-up limit reached: drop the whole steps left, but keep the fraction so the phase is preserved.
+	if (m_accumulator >= m_step) {
+		const double dropped_steps = std::floor(m_accumulator / m_step);
+		m_accumulator -= dropped_steps * m_step;
+		m_dropped_step_count += static_cast<uint64_t>(dropped_steps);
+	}
+
+	return steps;
+}
+
+float lecs::SystemGroup::get_interpolation_alpha() const {
+	if (!is_fixed_rate() || m_accumulator <= 0.0) {
+		return 0.0f;
+	}
+
+	return static_cast<float>(m_accumulator / m_step);
+}
+
+void lecs::SystemGroup::run_systems(ECS& ecs, float delta_time) {
+	const int32_t system_count = static_cast<int32_t>(m_systems.size());
+
+	// Register the events before anything runs, jobs only fill them in.
+	int32_t first_event_index = -1;
+	if (m_profiler) {
+		const int32_t step = m_profiler->begin_step();
+		for (int32_t i = 0; i < system_count; ++i) {
+			const int32_t event_index = m_profiler->add_event(m_name, m_systems[i].name, step);
+			if (i == 0) {
+				first_event_index = event_index;
+			}
+			for (int32_t dependency : m_systems[i].dependencies) {
+				m_profiler->add_dependency(event_index, first_event_index + dependency);
+			}
+		}
+	}
+
+	if (m_job_pool == nullptr || system_count < 2) {
+		// Dependencies always point to systems added earlier, so the order they were added in is a valid one.
+		for (int32_t i = 0; i < system_count; ++i) {
+			run_system(i, ecs, delta_time, first_event_index);
+		}
+		return;
+	}
+
+	for (int32_t i = 0; i < system_count; ++i) {
+		m_remaining_dependencies[i].store(static_cast<int32_t>(m_systems[i].dependencies.size()), std::memory_order_relaxed);
+	}
+
+	JobCounter counter;
+	for (int32_t i = 0; i < system_count; ++i) {
+		if (m_systems[i].dependencies.empty()) {
+			submit_system(i, ecs, delta_time, first_event_index, counter);
+		}
+	}
+	m_job_pool->wait(counter);
+}
+
+void lecs::SystemGroup::run_system(int32_t system_index, ECS& ecs, float delta_time, int32_t first_event_index) {
+	if (first_event_index < 0) {
+		m_systems[system_index].function(ecs, delta_time);
+		return;
+	}
+
+	const double begin_us = m_profiler->now_us();
+	m_systems[system_index].function(ecs, delta_time);
+	const double end_us = m_profiler->now_us();
+	m_profiler->record(first_event_index + system_index, begin_us, end_us, JobPool::get_current_thread_index());
+}
+
+void lecs::SystemGroup::submit_system(int32_t system_index, ECS& ecs, float delta_time, int32_t first_event_index, JobCounter& counter) {
+	m_job_pool->submit([this, system_index, &ecs, delta_time, first_event_index, &counter]() {
+		run_system(system_index, ecs, delta_time, first_event_index);
+
+		// Submitted before this job's own completion is counted, so the counter can't reach zero too early.
+		for (int32_t dependent : m_systems[system_index].dependents) {
+			if (m_remaining_dependencies[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+				submit_system(dependent, ecs, delta_time, first_event_index, counter);
+			}
+		}
+	}, &counter);
+}
+
+// Scheduler
+lecs::SystemGroup& lecs::Scheduler::add_group(const char* name, float tick_rate_hz, int32_t max_steps_per_update) {
+	m_groups.push_back(std::make_unique<SystemGroup>(name, tick_rate_hz, max_steps_per_update));
+	m_groups.back()->set_job_pool(m_job_pool);
+	m_groups.back()->set_profiler(m_profiler);
+	return *m_groups.back();
+}
+
+lecs::SystemGroup* lecs::Scheduler::find_group(const char* name) {
+	for (auto& group : m_groups) {
+		if (group->get_name() == name) {
+			return group.get();
+		}
+	}
+
+	return nullptr;
+}
+
+void lecs::Scheduler::distribute_phase_offsets() {
+	for (size_t i = 0; i < m_groups.size(); ++i) {
+		SystemGroup& group = *m_groups[i];
+		if (!group.is_fixed_rate()) {
+			continue;
+		}
+
+		int32_t same_rate_count = 0;
+		int32_t same_rate_position = 0;
+		for (size_t j = 0; j < m_groups.size(); ++j) {
+			if (m_groups[j]->get_tick_rate() == group.get_tick_rate()) {
+				if (j < i) {
+					same_rate_position++;
+				}
+				same_rate_count++;
+			}
+		}
+
+		group.set_phase_offset(static_cast<float>(same_rate_position) / static_cast<float>(same_rate_count));
+	}
+}
+
+void lecs::Scheduler::update(ECS& ecs, float delta_time) {
+	if (m_profiler) {
+		m_profiler->begin_frame(m_job_pool ? m_job_pool->get_thread_count() : 1);
+	}
+
+	for (auto& group : m_groups) {
+		group->update(ecs, delta_time);
+	}
+
+	if (m_profiler) {
+		m_profiler->end_frame();
+	}
+}
+
+void lecs::Scheduler::set_job_pool(JobPool* job_pool) {
+	m_job_pool = job_pool;
+	for (auto& group : m_groups) {
+		group->set_job_pool(job_pool);
+	}
+}
+
+void lecs::Scheduler::set_profiler(FrameProfiler* profiler) {
+	m_profiler = profiler;
+	for (auto& group : m_groups) {
+		group->set_profiler(profiler);
+	}
+}
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
@@ -0,0 +1,256 @@
+// LECS (Lightweight Entity Component System) scheduler
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+// USAGE:
+// This is optional, systems are still just free functions or callable objects and you can keep calling them yourself.
+// If you use it, include this file in the same .cpp where you #define LECS_IMPLEMENTATION as well.
+//
+// Systems are organized in groups, each one ticking at its own fixed rate eg.:
+// lecs::Scheduler scheduler;
+// lecs::SystemGroup& physics = scheduler.add_group("physics", 120.0f);
+// physics.add_system("velocity", velocity_system_update);
+// lecs::SystemGroup& ai = scheduler.add_group("ai", 5.0f);
+// ai.add_system("replan", replan_system_update);
+//
+// Then, once per frame:
+// scheduler.update(my_ecs, frame_delta_time);
+//
+// Systems of a fixed rate group always receive the fixed delta time of the group.
+// A group with a tick rate of 0 is updated exactly once per frame with the frame delta time.
+//
+// By default each system of a group runs after the one added before it. You can list the dependencies explicitly instead,
+// and systems that don't depend on each other run in parallel once the scheduler has a JobPool eg.:
+// physics.add_system("broadphase", broadphase_system_update, {});
+// physics.add_system("forces", forces_system_update, {});
+// physics.add_system("integrate", integrate_system_update, { "broadphase", "forces" });
+// lecs::JobPool job_pool;
+// scheduler.set_job_pool(&job_pool);
+//
+// To see where threads idle, attach a FrameProfiler and export what it recorded as a Chrome trace (open it in Perfetto or chrome://tracing):
+// lecs::FrameProfiler profiler;
+// scheduler.set_profiler(&profiler);
+// ...
+// profiler.save_chrome_trace("frames.json");
+// lecs::FrameProfiler::FrameStats stats = profiler.compute_frame_stats(profiler.get_frame_count() - 1);
+
+#pragma once
+
+#include "lecs.hpp"
+#include "lecs_jobs.hpp"
+
+#include <deque>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lecs {
+	using SystemFunction = std::function<void(ECS&, float)>;
+
+	// Records when, and on which thread, each system ran. It keeps the last max_recorded_frames frames.
+	class FrameProfiler {
+	public:
+		struct Event {
+			std::string name;
+			std::string group;
+			double begin_us{ 0.0 };
+			double end_us{ 0.0 };
+			int32_t thread_index{ 0 };
+			// Steps are separated by barriers: all the events of a step finish before the next step starts.
+			int32_t step{ 0 };
+			// Indices of the events (in the same frame) that had to finish before this one started.
+			std::vector<int32_t> dependencies;
+		};
+
+		struct FrameStats {
+			uint64_t frame_number{ 0 };
+			double wall_time_us{ 0.0 };
+			// Sum of the durations of all the events.
+			double busy_time_us{ 0.0 };
+			// The longest chain of dependent events. The frame can't be faster than this, however many threads there are.
+			double critical_path_us{ 0.0 };
+			// busy_time / (thread_count * wall_time): 1 means no thread ever idled.
+			float parallel_efficiency{ 0.0f };
+			// Indices of the events on the critical path, in execution order.
+			std::vector<int32_t> critical_path;
+		};
+
+		explicit FrameProfiler(int32_t max_recorded_frames = 120);
+
+		// The scheduler calls these around each update.
+		void begin_frame(int32_t thread_count);
+		void end_frame();
+
+		// Groups call these before running the systems of a step. Events can only be added while a frame is open,
+		// otherwise add_event returns -1. Adding events is not thread safe, recording them is.
+		int32_t begin_step();
+		int32_t add_event(const std::string& group, const std::string& name, int32_t step);
+		void add_dependency(int32_t event_index, int32_t depends_on_event_index);
+		void record(int32_t event_index, double begin_us, double end_us, int32_t thread_index);
+
+		// Microseconds since the profiler was created.
+		double now_us() const;
+
+		// Frames are numbered from the oldest recorded one (0) to the most recent (get_frame_count() - 1).
+		int32_t get_frame_count() const { return static_cast<int32_t>(m_frames.size()); }
+		const std::vector<Event>& get_frame_events(int32_t frame) const { return m_frames[frame].events; }
+		FrameStats compute_frame_stats(int32_t frame) const;
+
+		// Chrome trace event format, one track per thread.
+		void write_chrome_trace(std::ostream& out) const;
+		bool save_chrome_trace(const char* path) const;
+
+		void clear();
+
+	private:
+		struct Frame {
+			uint64_t number{ 0 };
+			double begin_us{ 0.0 };
+			double end_us{ 0.0 };
+			int32_t thread_count{ 1 };
+			int32_t step_count{ 0 };
+			std::vector<Event> events;
+		};
+
+		std::deque<Frame> m_frames;
+		int32_t m_max_recorded_frames;
+		uint64_t m_frame_number{ 0 };
+		bool m_frame_open{ false };
+		std::chrono::steady_clock::time_point m_start_time;
+	};
+
+	// A list of systems that are updated together, at a fixed rate, using an accumulator.
+	// When a frame takes longer than a step the group catches up by running multiple steps, up to max_steps_per_update.
+	// Any time left beyond that is dropped, so a long hitch doesn't make the following frames even longer.
+	class SystemGroup {
+	public:
+		SystemGroup(const char* name, float tick_rate_hz, int32_t max_steps_per_update = 4);
+
+		// The system runs after the one added before it.
+		void add_system(const char* name, SystemFunction system);
+
+		// The system runs after the listed ones, which must have been added to this group already.
+		// Returns false (and doesn't add the system) if one of them can't be found.
+		bool add_system(const char* name, SystemFunction system, const std::vector<std::string>& dependencies);
+
+		// Delays the ticks of the group by a fraction [0, 1) of its step.
+		// Groups with the same rate and different phases tick on different frames.
+		void set_phase_offset(float phase);
+
+		void set_max_steps_per_update(int32_t max_steps_per_update);
+
+		// Accumulates delta_time and runs the systems once per elapsed step. Returns the number of steps run.
+		int32_t update(ECS& ecs, float delta_time);
+
+		const std::string& get_name() const { return m_name; }
+
+		float get_tick_rate() const { return m_tick_rate; }
+
+		// The delta time passed to the systems. Zero for variable rate groups.
+		float get_fixed_delta_time() const { return static_cast<float>(m_step); }
+
+		float get_phase_offset() const { return m_phase; }
+
+		// How far we are between the last step and the next one [0, 1). Use it to interpolate rendering.
+		float get_interpolation_alpha() const;
+
+		uint64_t get_tick_count() const { return m_tick_count; }
+
+		// Steps skipped because of the catch-up limit.
+		uint64_t get_dropped_step_count() const { return m_dropped_step_count; }
+
+		bool is_fixed_rate() const { return m_step > 0.0; }
+
+		// Optional, with a job pool independent systems run in parallel.
+		void set_job_pool(JobPool* job_pool) { m_job_pool = job_pool; }
+
+		// Optional, records the execution of each system.
+		void set_profiler(FrameProfiler* profiler) { m_profiler = profiler; }
+
+	private:
+		void add_system_with_dependency_indices(const char* name, SystemFunction system, std::vector<int32_t> dependencies);
+
+		void run_systems(ECS& ecs, float delta_time);
+
+		void run_system(int32_t system_index, ECS& ecs, float delta_time, int32_t first_event_index);
+
+		// Submits the system, and from its job the dependents it unblocks.
+		void submit_system(int32_t system_index, ECS& ecs, float delta_time, int32_t first_event_index, JobCounter& counter);
+
+		struct System {
+			std::string name;
+			SystemFunction function;
+			std::vector<int32_t> dependencies;
+			std::vector<int32_t> dependents;
+		};
+
+		std::string m_name;
+		std::vector<System> m_systems;
+		std::unique_ptr<std::atomic<int32_t>[]> m_remaining_dependencies;
+
+		JobPool* m_job_pool{ nullptr };
+		FrameProfiler* m_profiler{ nullptr };
+
+		float m_tick_rate;
+		double m_step;
+		double m_accumulator{ 0.0 };
+		float m_phase{ 0.0f };
+		int32_t m_max_steps_per_update;
+
+		uint64_t m_tick_count{ 0 };
+		uint64_t m_dropped_step_count{ 0 };
+	};
+
+	// Owns the system groups and updates them in the order they were added.
+	class Scheduler {
+	public:
+		SystemGroup& add_group(const char* name, float tick_rate_hz, int32_t max_steps_per_update = 4);
+
+		// Returns nullptr if there is no group with that name.
+		SystemGroup* find_group(const char* name);
+
+		// Spreads groups that tick at the same rate evenly across their step, so their work lands on different frames.
+		void distribute_phase_offsets();
+
+		void update(ECS& ecs, float delta_time);
+
+		// Applies to all the groups, including the ones added later.
+		void set_job_pool(JobPool* job_pool);
+		void set_profiler(FrameProfiler* profiler);
+
+	private:
+		std::vector<std::unique_ptr<SystemGroup>> m_groups;
+		JobPool* m_job_pool{ nullptr };
+		FrameProfiler* m_profiler{ nullptr };
+	};
+}
+
+#if defined(LECS_IMPLEMENTATION)
+#include "lecs_scheduler.cpp"
+#endif // defined(LECS_IMPLEMENTATION)
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
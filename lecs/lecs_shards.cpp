@@ -0,0 +1,183 @@
+// LECS (Lightweight Entity Component System) sharded worlds implementation file
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+
+// ShardedWorld
+lecs::ShardedWorld::ShardedWorld(uint32_t shard_count, JobPool* job_pool) : m_job_pool(job_pool) {
+	for (uint32_t i = 0; i < shard_count; ++i) {
+		m_shards.push_back(std::make_unique<ECS>());
+	}
+
+	m_outgoing.resize(static_cast<size_t>(shard_count) * shard_count);
+	m_remaps.resize(static_cast<size_t>(shard_count) * shard_count);
+	m_has_failed.resize(shard_count, 0);
+}
+
+lecs::ShardedEntity lecs::ShardedWorld::create_entity(uint32_t shard) {
+	if (shard >= m_shards.size()) {
+		return ShardedEntity{ shard, Entity::Invalid };
+	}
+
+	return ShardedEntity{ shard, m_shards[shard]->create_entity() };
+}
+
+void lecs::ShardedWorld::remove_entity(ShardedEntity entity) {
+	if (entity.shard < m_shards.size()) {
+		m_shards[entity.shard]->remove_entity(entity.entity);
+	}
+}
+
+bool lecs::ShardedWorld::is_entity_handle_active(ShardedEntity entity) const {
+	return entity.shard < m_shards.size() && m_shards[entity.shard]->is_entity_handle_active(entity.entity);
+}
+
+void lecs::ShardedWorld::for_each_shard(const std::function<void(ECS& shard, uint32_t shard_index)>& func) {
+	run_parallel(get_shard_count(), [&](uint32_t shard) {
+		func(*m_shards[shard], shard);
+	});
+}
+
+bool lecs::ShardedWorld::migrate(const PartitionFunction& partition) {
+	const uint32_t shard_count = get_shard_count();
+
+	// Every shard finds its leaving entities on its own.
+	run_parallel(shard_count, [&](uint32_t shard) {
+		ECS& ecs = *m_shards[shard];
+		for (uint32_t destination = 0; destination < shard_count; ++destination) {
+			m_outgoing[shard * shard_count + destination].clear();
+		}
+		m_has_failed[shard] = 0;
+
+		const EntityIndex entity_count = static_cast<EntityIndex>(ecs.get_entity_count());
+		for (EntityIndex entity_index = 0; entity_index < entity_count; ++entity_index) {
+			const Entity entity = ecs.get_entity_from_index(entity_index);
+			if (!entity.is_valid()) {
+				continue;
+			}
+
+			const uint32_t destination = partition(ecs, entity);
+			if (destination >= shard_count) {
+				m_has_failed[shard] = 1;
+			}
+			else if (destination != shard) {
+				m_outgoing[shard * shard_count + destination].push_back(entity);
+			}
+		}
+	});
+
+	// Round robin: one shard stays, the others rotate, so every pair meets once and the pairs of a round share no shard.
+	// With an odd count, a missing shard is added, and its partner sits the round out.
+	bool all_moved = true;
+	const uint32_t player_count = shard_count + shard_count % 2;
+	std::vector<std::pair<uint32_t, uint32_t>> pairs;
+	for (uint32_t round = 0; round + 1 < player_count; ++round) {
+		pairs.clear();
+		for (uint32_t i = 0; i < player_count / 2; ++i) {
+			const uint32_t a = i == 0 ? 0 : (round + i - 1) % (player_count - 1) + 1;
+			const uint32_t b = (round + player_count - 2 - i) % (player_count - 1) + 1;
+			if (a < shard_count && b < shard_count) {
+				pairs.emplace_back(a, b);
+			}
+		}
+
+		std::vector<uint8_t> moved(pairs.size(), 0);
+		run_parallel(static_cast<uint32_t>(pairs.size()), [&](uint32_t pair) {
+			moved[pair] = exchange(pairs[pair].first, pairs[pair].second) ? 1 : 0;
+		});
+
+		for (uint8_t pair_moved : moved) {
+			all_moved = all_moved && pair_moved != 0;
+		}
+	}
+
+	for (uint8_t has_failed : m_has_failed) {
+		all_moved = all_moved && has_failed == 0;
+	}
+
+	return all_moved;
+}
+
+lecs::ShardedEntity lecs::ShardedWorld::get_migrated(ShardedEntity entity) const {
+	const uint32_t shard_count = get_shard_count();
+	if (entity.shard >= shard_count) {
+		return entity;
+	}
+
+	for (uint32_t destination = 0; destination < shard_count; ++destination) {
+		const Entity moved = m_remaps[entity.shard * shard_count + destination].get(entity.entity);
+		if (moved.is_valid()) {
+			return ShardedEntity{ destination, moved };
+		}
+	}
+
+	return entity;
+}
+
+size_t lecs::ShardedWorld::get_migrated_count() const {
+	size_t count = 0;
+	for (const EntityRemap& remap : m_remaps) {
+		count += remap.get_destination_entities().size();
+	}
+
+	return count;
+}
+
+void lecs::ShardedWorld::run_parallel(uint32_t count, const std::function<void(uint32_t)>& func) {
+	if (m_job_pool == nullptr) {
+		for (uint32_t i = 0; i < count; ++i) {
+			func(i);
+		}
+		return;
+	}
+
+	m_job_pool->parallel_for(static_cast<int32_t>(count), 1, [&](int32_t begin, int32_t end) {
+		for (int32_t i = begin; i < end; ++i) {
+			func(static_cast<uint32_t>(i));
+		}
+	});
+}
+
+bool lecs::ShardedWorld::exchange(uint32_t shard_a, uint32_t shard_b) {
+	const uint32_t shard_count = get_shard_count();
+	bool all_moved = true;
+
+	// Both lists were made before anything moved, so what arrives in b is not sent back to a.
+	const uint32_t directions[2][2] = { { shard_a, shard_b }, { shard_b, shard_a } };
+	for (const auto& direction : directions) {
+		const size_t route = direction[0] * shard_count + direction[1];
+		if (m_outgoing[route].empty()) {
+			// move_entities sizes the remap by the source entities, skip it when nothing moves.
+			m_remaps[route] = EntityRemap{};
+			continue;
+		}
+
+		all_moved = move_entities(*m_shards[direction[0]], *m_shards[direction[1]], m_outgoing[route], m_remaps[route]) && all_moved;
+	}
+
+	return all_moved;
+}
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
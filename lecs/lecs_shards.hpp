@@ -0,0 +1,123 @@
+// LECS (Lightweight Entity Component System) sharded worlds
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+// USAGE:
+// This is optional. It uses the JobPool, include lecs_shards.hpp and lecs_jobs.hpp in the same .cpp where you
+// #define LECS_IMPLEMENTATION.
+//
+// A sharded world splits the entities in N ECS partitions (eg. spatial regions of a crowd), so that everything,
+// structural changes included, runs on one job per shard with no synchronization:
+// lecs::ShardedWorld world(4, &job_pool);
+// lecs::ShardedEntity agent = world.create_entity(region_of(spawn_position));
+// world.get_shard(agent.shard).add_component_to_entity<Agent>(agent.entity);
+//
+// world.for_each_shard([&](lecs::ECS& shard, uint32_t shard_index) {
+//		// Only touch this shard here: create, remove, iterate...
+// });
+//
+// Then, once per frame, the entities whose partition changed move to their new shard:
+// world.migrate([](lecs::ECS& shard, lecs::Entity entity) { return region_of(shard.get_component<Agent>(entity)->position); });
+// agent = world.get_migrated(agent); // handles of migrated entities change
+//
+// Components are moved with move_entities, so the entity remappers of the destination shard are applied. Handles
+// stored in components can only refer to entities of the same shard.
+
+#pragma once
+
+#include "lecs.hpp"
+#include "lecs_jobs.hpp"
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace lecs {
+	// An entity and the shard it lives in.
+	struct ShardedEntity {
+		uint32_t shard;
+		Entity entity;
+
+		bool operator==(const ShardedEntity& other) const {
+			return shard == other.shard && entity == other.entity;
+		}
+
+		bool is_valid() const { return entity.is_valid(); }
+	};
+
+	class ShardedWorld {
+	public:
+		// Returns the shard the entity belongs to.
+		using PartitionFunction = std::function<uint32_t(ECS& shard, Entity entity)>;
+
+		// Without a job pool, the shards run one after the other on the calling thread.
+		explicit ShardedWorld(uint32_t shard_count, JobPool* job_pool = nullptr);
+
+		ShardedWorld(const ShardedWorld&) = delete;
+		ShardedWorld& operator=(const ShardedWorld&) = delete;
+
+		uint32_t get_shard_count() const { return static_cast<uint32_t>(m_shards.size()); }
+		ECS& get_shard(uint32_t shard) { return *m_shards[shard]; }
+
+		// Returns an invalid entity if the shard doesn't exist.
+		ShardedEntity create_entity(uint32_t shard);
+		void remove_entity(ShardedEntity entity);
+		bool is_entity_handle_active(ShardedEntity entity) const;
+
+		// Calls func(shard, shard_index) for every shard, in parallel on the job pool, and waits for all of them.
+		// Each call must only touch its own shard.
+		void for_each_shard(const std::function<void(ECS& shard, uint32_t shard_index)>& func);
+
+		// Moves the entities for which partition returns another shard. partition runs on the job pool for each shard,
+		// then the shards exchange their entities two by two, in rounds where every shard takes part in at most one exchange.
+		// Returns false if some entities could not move (their destination is full or doesn't exist), they stay where they are.
+		bool migrate(const PartitionFunction& partition);
+
+		// The handle of the entity after the last migrate, or the same handle if it didn't move.
+		ShardedEntity get_migrated(ShardedEntity entity) const;
+
+		// Entities moved by the last migrate.
+		size_t get_migrated_count() const;
+
+	private:
+		// Calls func(index) for every index in [0, count), on the job pool if there is one.
+		void run_parallel(uint32_t count, const std::function<void(uint32_t)>& func);
+		bool exchange(uint32_t shard_a, uint32_t shard_b);
+
+		JobPool* m_job_pool;
+		std::vector<std::unique_ptr<ECS>> m_shards;
+		// By source shard * shard count + destination shard.
+		std::vector<std::vector<Entity>> m_outgoing;
+		std::vector<EntityRemap> m_remaps;
+		// By source shard, written by its own job.
+		std::vector<uint8_t> m_has_failed;
+	};
+}
+
+#if defined(LECS_IMPLEMENTATION)
+#include "lecs_shards.cpp"
+#endif // defined(LECS_IMPLEMENTATION)
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
@@ -0,0 +1,136 @@
+// LECS (Lightweight Entity Component System) shared memory implementation file
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+
+#if defined(LECS_HAS_SHARED_MEMORY)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // defined(LECS_HAS_SHARED_MEMORY)
+
+namespace lecs {
+	namespace detail {
+		inline std::string get_shared_memory_name(const std::string& name) {
+			return !name.empty() && name[0] == '/' ? name : "/" + name;
+		}
+	}
+}
+
+// SharedMemory
+lecs::SharedMemory::~SharedMemory() {
+	close();
+}
+
+#if defined(LECS_HAS_SHARED_MEMORY)
+bool lecs::SharedMemory::create(const std::string& name, size_t size) {
+	close();
+
+	const std::string shared_name = detail::get_shared_memory_name(name);
+	shm_unlink(shared_name.c_str());
+	const int file = shm_open(shared_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (file < 0) {
+		return false;
+	}
+
+	if (ftruncate(file, static_cast<off_t>(size)) != 0) {
+		::close(file);
+		shm_unlink(shared_name.c_str());
+		return false;
+	}
+
+	void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+	::close(file);
+	if (data == MAP_FAILED) {
+		shm_unlink(shared_name.c_str());
+		return false;
+	}
+
+	m_data = data;
+	m_size = size;
+	m_name = shared_name;
+	m_is_owner = true;
+	return true;
+}
+
+bool lecs::SharedMemory::open(const std::string& name, size_t size, bool writable) {
+	close();
+
+	const std::string shared_name = detail::get_shared_memory_name(name);
+	const int file = shm_open(shared_name.c_str(), writable ? O_RDWR : O_RDONLY, 0);
+	if (file < 0) {
+		return false;
+	}
+
+	// Mapping past the end of the segment would fault on the first access instead.
+	struct stat file_stat;
+	if (fstat(file, &file_stat) != 0 || static_cast<size_t>(file_stat.st_size) < size) {
+		::close(file);
+		return false;
+	}
+
+	void* data = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, file, 0);
+	::close(file);
+	if (data == MAP_FAILED) {
+		return false;
+	}
+
+	m_data = data;
+	m_size = size;
+	m_name = shared_name;
+	m_is_owner = false;
+	return true;
+}
+
+void lecs::SharedMemory::close() {
+	if (m_data == nullptr) {
+		return;
+	}
+
+	munmap(m_data, m_size);
+	if (m_is_owner) {
+		shm_unlink(m_name.c_str());
+	}
+
+	m_data = nullptr;
+	m_size = 0;
+	m_name.clear();
+	m_is_owner = false;
+}
+#else
+bool lecs::SharedMemory::create(const std::string& name, size_t size) {
+	return false;
+}
+
+bool lecs::SharedMemory::open(const std::string& name, size_t size, bool writable) {
+	return false;
+}
+
+void lecs::SharedMemory::close() {
+}
+#endif // defined(LECS_HAS_SHARED_MEMORY)
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
@@ -0,0 +1,83 @@
+// LECS (Lightweight Entity Component System) shared memory
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+// USAGE:
+// This is used by the modules that talk to other processes (eg. lecs_inspector.hpp), include it in the same .cpp where
+// you #define LECS_IMPLEMENTATION.
+//
+// A named segment of POSIX shared memory (shm_open and mmap), created by one process and opened by the others:
+// lecs::SharedMemory segment;
+// segment.create("/my_segment", size); // or segment.open("/my_segment", size, false) in the other process
+// void* data = segment.get_data();
+//
+// LECS_HAS_SHARED_MEMORY is defined where it's supported. Elsewhere create and open return false.
+// Old glibc versions need -lrt for shm_open.
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define LECS_HAS_SHARED_MEMORY
+#endif // defined(__unix__) || defined(__APPLE__)
+
+namespace lecs {
+	class SharedMemory {
+	public:
+		SharedMemory() = default;
+		~SharedMemory();
+
+		SharedMemory(const SharedMemory&) = delete;
+		SharedMemory& operator=(const SharedMemory&) = delete;
+
+		// Creates the segment, zero filled, replacing one with the same name. It's removed when this closes.
+		// A missing leading '/' is added to the name. Returns false if it could not be created.
+		bool create(const std::string& name, size_t size);
+
+		// Maps an existing segment. Returns false if there is none, or if it's smaller than size.
+		bool open(const std::string& name, size_t size, bool writable);
+
+		// Unmaps the segment, and removes its name if this created it. Processes that opened it keep their mapping.
+		void close();
+
+		bool is_open() const { return m_data != nullptr; }
+		void* get_data() const { return m_data; }
+		size_t get_size() const { return m_size; }
+
+	private:
+		void* m_data{ nullptr };
+		size_t m_size{ 0 };
+		std::string m_name;
+		bool m_is_owner{ false };
+	};
+}
+
+#if defined(LECS_IMPLEMENTATION)
+#include "lecs_shared_memory.cpp"
+#endif // defined(LECS_IMPLEMENTATION)
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
@@ -0,0 +1,268 @@
+// LECS (Lightweight Entity Component System) shared component pools implementation file
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+
+#include <algorithm>
+#include <new>
+
+namespace lecs {
+	namespace detail {
+		static const uint32_t SHARED_POOL_MAGIC = 0x5053454Cu; // "LESP"
+		static const uint32_t SHARED_POOL_VERSION = 1;
+		static const uint64_t SHARED_POOL_BLOCK_ALIGNMENT = 64;
+
+		static_assert(ATOMIC_INT_LOCK_FREE == 2, "Atomics shared between processes must be lock free");
+
+		// At the start of every buffer, then the entities, then the components.
+		struct SharedPoolBufferHeader {
+			uint64_t frame_number;
+			uint64_t count;
+		};
+
+		inline uint64_t align_shared_offset(uint64_t offset, uint64_t alignment) {
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+	}
+}
+
+struct lecs::detail::SharedPoolSegment::Header {
+	// Stored last by create: the rest is complete once a reader sees it.
+	std::atomic<uint32_t> magic;
+	uint32_t version;
+	uint32_t component_size;
+	uint32_t component_alignment;
+	uint32_t entity_size;
+	uint32_t capacity;
+	uint32_t max_readers;
+	uint32_t buffer_count;
+	uint64_t buffers_offset;
+	uint64_t buffer_size;
+	// In a buffer.
+	uint64_t components_offset;
+	uint64_t total_size;
+	std::atomic<uint32_t> latest_buffer;
+};
+
+struct lecs::detail::SharedPoolSegment::ReaderSlot {
+	std::atomic<uint32_t> claimed;
+	std::atomic<uint32_t> pinned_buffer;
+};
+
+// SharedPoolSegment
+const uint32_t lecs::detail::SharedPoolSegment::INVALID_BUFFER;
+
+bool lecs::detail::SharedPoolSegment::create(const std::string& name, uint32_t component_size, uint32_t component_alignment, uint32_t capacity, uint32_t max_readers) {
+	close();
+	if (capacity == 0 || max_readers == 0) {
+		return false;
+	}
+
+	// Every buffer that a reader can pin, the latest one, and one to write.
+	const uint32_t buffer_count = max_readers + 2;
+	const uint64_t block_alignment = std::max<uint64_t>(SHARED_POOL_BLOCK_ALIGNMENT, component_alignment);
+	const uint64_t slots_offset = align_shared_offset(sizeof(Header), block_alignment);
+	const uint64_t buffers_offset = align_shared_offset(slots_offset + sizeof(ReaderSlot) * max_readers, block_alignment);
+	const uint64_t components_offset = align_shared_offset(sizeof(SharedPoolBufferHeader) + sizeof(Entity) * uint64_t(capacity), block_alignment);
+	const uint64_t buffer_size = align_shared_offset(components_offset + uint64_t(component_size) * capacity, block_alignment);
+	const uint64_t total_size = buffers_offset + buffer_size * buffer_count;
+	if (!m_memory.create(name, static_cast<size_t>(total_size))) {
+		return false;
+	}
+
+	unsigned char* data = static_cast<unsigned char*>(m_memory.get_data());
+	Header* header = new (data) Header;
+	header->version = SHARED_POOL_VERSION;
+	header->component_size = component_size;
+	header->component_alignment = component_alignment;
+	header->entity_size = sizeof(Entity);
+	header->capacity = capacity;
+	header->max_readers = max_readers;
+	header->buffer_count = buffer_count;
+	header->buffers_offset = buffers_offset;
+	header->buffer_size = buffer_size;
+	header->components_offset = components_offset;
+	header->total_size = total_size;
+	header->latest_buffer.store(INVALID_BUFFER, std::memory_order_relaxed);
+
+	for (uint32_t slot = 0; slot < max_readers; ++slot) {
+		ReaderSlot* reader_slot = new (data + slots_offset + sizeof(ReaderSlot) * slot) ReaderSlot;
+		reader_slot->claimed.store(0, std::memory_order_relaxed);
+		reader_slot->pinned_buffer.store(INVALID_BUFFER, std::memory_order_relaxed);
+	}
+
+	header->magic.store(SHARED_POOL_MAGIC, std::memory_order_release);
+	return true;
+}
+
+bool lecs::detail::SharedPoolSegment::open(const std::string& name, uint32_t component_size, uint32_t component_alignment) {
+	close();
+
+	// The header tells the size of the rest.
+	if (!m_memory.open(name, sizeof(Header), true)) {
+		return false;
+	}
+	if (!is_compatible(component_size, component_alignment)) {
+		close();
+		return false;
+	}
+
+	const uint64_t total_size = get_header().total_size;
+	m_memory.close();
+	// It may have been created again in the meantime.
+	if (!m_memory.open(name, static_cast<size_t>(total_size), true) || !is_compatible(component_size, component_alignment) ||
+		get_header().total_size != total_size) {
+		close();
+		return false;
+	}
+
+	return true;
+}
+
+void lecs::detail::SharedPoolSegment::close() {
+	m_memory.close();
+	m_reader_slot = INVALID_BUFFER;
+}
+
+uint32_t lecs::detail::SharedPoolSegment::get_capacity() const {
+	return get_header().capacity;
+}
+
+uint32_t lecs::detail::SharedPoolSegment::find_free_buffer() const {
+	const Header& header = get_header();
+	const ReaderSlot* reader_slots = get_reader_slots();
+
+	// Sequentially consistent with pin_latest_buffer: a reader that pins a buffer after these loads sees that it's no
+	// longer the latest, and pins again.
+	const uint32_t latest = header.latest_buffer.load(std::memory_order_seq_cst);
+	for (uint32_t buffer = 0; buffer < header.buffer_count; ++buffer) {
+		if (buffer == latest) {
+			continue;
+		}
+
+		bool is_pinned = false;
+		for (uint32_t slot = 0; slot < header.max_readers && !is_pinned; ++slot) {
+			is_pinned = reader_slots[slot].pinned_buffer.load(std::memory_order_seq_cst) == buffer;
+		}
+		if (!is_pinned) {
+			return buffer;
+		}
+	}
+
+	return INVALID_BUFFER;
+}
+
+void lecs::detail::SharedPoolSegment::publish_buffer(uint32_t buffer, uint64_t frame_number, uint32_t count) {
+	SharedPoolBufferHeader* buffer_header = reinterpret_cast<SharedPoolBufferHeader*>(get_buffer(buffer));
+	buffer_header->frame_number = frame_number;
+	buffer_header->count = count;
+	get_header().latest_buffer.store(buffer, std::memory_order_seq_cst);
+}
+
+bool lecs::detail::SharedPoolSegment::claim_reader_slot() {
+	const Header& header = get_header();
+	ReaderSlot* reader_slots = get_reader_slots();
+	for (uint32_t slot = 0; slot < header.max_readers; ++slot) {
+		uint32_t expected = 0;
+		if (reader_slots[slot].claimed.compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) {
+			reader_slots[slot].pinned_buffer.store(INVALID_BUFFER, std::memory_order_release);
+			m_reader_slot = slot;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void lecs::detail::SharedPoolSegment::release_reader_slot() {
+	if (m_reader_slot == INVALID_BUFFER) {
+		return;
+	}
+
+	ReaderSlot& reader_slot = get_reader_slots()[m_reader_slot];
+	reader_slot.pinned_buffer.store(INVALID_BUFFER, std::memory_order_release);
+	reader_slot.claimed.store(0, std::memory_order_release);
+	m_reader_slot = INVALID_BUFFER;
+}
+
+uint32_t lecs::detail::SharedPoolSegment::pin_latest_buffer() {
+	const Header& header = get_header();
+	ReaderSlot& reader_slot = get_reader_slots()[m_reader_slot];
+	for (;;) {
+		const uint32_t latest = header.latest_buffer.load(std::memory_order_seq_cst);
+		if (latest == INVALID_BUFFER) {
+			reader_slot.pinned_buffer.store(INVALID_BUFFER, std::memory_order_release);
+			return INVALID_BUFFER;
+		}
+
+		// Only safe if it's still the latest once pinned, otherwise the publisher may be writing it already.
+		reader_slot.pinned_buffer.store(latest, std::memory_order_seq_cst);
+		if (header.latest_buffer.load(std::memory_order_seq_cst) == latest) {
+			return latest;
+		}
+	}
+}
+
+void lecs::detail::SharedPoolSegment::unpin_buffer() {
+	get_reader_slots()[m_reader_slot].pinned_buffer.store(INVALID_BUFFER, std::memory_order_release);
+}
+
+uint64_t lecs::detail::SharedPoolSegment::get_frame_number(uint32_t buffer) const {
+	return reinterpret_cast<const SharedPoolBufferHeader*>(get_buffer(buffer))->frame_number;
+}
+
+uint32_t lecs::detail::SharedPoolSegment::get_count(uint32_t buffer) const {
+	return static_cast<uint32_t>(reinterpret_cast<const SharedPoolBufferHeader*>(get_buffer(buffer))->count);
+}
+
+lecs::Entity* lecs::detail::SharedPoolSegment::get_entities(uint32_t buffer) const {
+	return reinterpret_cast<Entity*>(get_buffer(buffer) + sizeof(SharedPoolBufferHeader));
+}
+
+void* lecs::detail::SharedPoolSegment::get_components(uint32_t buffer) const {
+	return get_buffer(buffer) + get_header().components_offset;
+}
+
+lecs::detail::SharedPoolSegment::Header& lecs::detail::SharedPoolSegment::get_header() const {
+	return *static_cast<Header*>(m_memory.get_data());
+}
+
+lecs::detail::SharedPoolSegment::ReaderSlot* lecs::detail::SharedPoolSegment::get_reader_slots() const {
+	const uint64_t block_alignment = std::max<uint64_t>(SHARED_POOL_BLOCK_ALIGNMENT, get_header().component_alignment);
+	return reinterpret_cast<ReaderSlot*>(static_cast<unsigned char*>(m_memory.get_data()) + align_shared_offset(sizeof(Header), block_alignment));
+}
+
+unsigned char* lecs::detail::SharedPoolSegment::get_buffer(uint32_t buffer) const {
+	const Header& header = get_header();
+	return static_cast<unsigned char*>(m_memory.get_data()) + header.buffers_offset + header.buffer_size * buffer;
+}
+
+bool lecs::detail::SharedPoolSegment::is_compatible(uint32_t component_size, uint32_t component_alignment) const {
+	const Header& header = get_header();
+	return header.magic.load(std::memory_order_acquire) == SHARED_POOL_MAGIC && header.version == SHARED_POOL_VERSION &&
+		header.component_size == component_size && header.component_alignment == component_alignment && header.entity_size == sizeof(Entity);
+}
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
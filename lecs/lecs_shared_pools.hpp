@@ -0,0 +1,252 @@
+// LECS (Lightweight Entity Component System) shared component pools
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+// USAGE:
+// This is optional. It uses SharedMemory, include lecs_shared_pools.hpp and lecs_shared_memory.hpp in the same .cpp where
+// you #define LECS_IMPLEMENTATION.
+//
+// Other processes (eg. a renderer or analytics) can read the pool of a component type straight from shared memory.
+// The simulation publishes it once per frame, and never waits for the readers:
+// lecs::SharedPoolPublisher<Transform> transforms;
+// transforms.open("/my_game_transforms", 100000); // the most components published at once
+// ...
+// transforms.publish(my_ecs);
+//
+// In the other process, built with the same component type and the same LECS_ENTITY_*_BITS:
+// lecs::SharedPoolReader<Transform> transforms;
+// transforms.open("/my_game_transforms");
+// if (transforms.acquire()) {
+//		const Transform* components = transforms.get_components();
+//		const lecs::Entity* entities = transforms.get_entities(); // entities[i] has components[i]
+//		for (uint32_t i = 0; i < transforms.get_size(); ++i) { /* ... */ }
+//		transforms.release();
+// }
+//
+// The segment holds max_readers + 2 buffers. publish copies the pool, with its entities, in one that is neither the
+// latest nor pinned by a reader, then makes it the latest. acquire pins the latest one, so the publisher can't write it
+// until release: the arrays are read in place, and they don't change while they are pinned.
+// A reader that dies while holding its slot keeps it, reopen the publisher to reset the slots.
+
+#pragma once
+
+#include "lecs.hpp"
+#include "lecs_shared_memory.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace lecs {
+	namespace detail {
+		// The part of the shared pools that doesn't depend on the component type.
+		class SharedPoolSegment {
+		public:
+			static const uint32_t INVALID_BUFFER = static_cast<uint32_t>(-1);
+
+			bool create(const std::string& name, uint32_t component_size, uint32_t component_alignment, uint32_t capacity, uint32_t max_readers);
+			bool open(const std::string& name, uint32_t component_size, uint32_t component_alignment);
+			void close();
+			bool is_open() const { return m_memory.is_open(); }
+
+			uint32_t get_capacity() const;
+
+			// Returns a buffer that is neither the latest nor pinned, INVALID_BUFFER if there is none.
+			uint32_t find_free_buffer() const;
+			void publish_buffer(uint32_t buffer, uint64_t frame_number, uint32_t count);
+
+			// Takes a free reader slot. Returns false if all of them are taken.
+			bool claim_reader_slot();
+			void release_reader_slot();
+			// Pins the latest buffer in the reader slot. Returns INVALID_BUFFER if nothing was published yet.
+			uint32_t pin_latest_buffer();
+			void unpin_buffer();
+
+			uint64_t get_frame_number(uint32_t buffer) const;
+			uint32_t get_count(uint32_t buffer) const;
+			Entity* get_entities(uint32_t buffer) const;
+			void* get_components(uint32_t buffer) const;
+
+		private:
+			struct Header;
+			struct ReaderSlot;
+
+			Header& get_header() const;
+			ReaderSlot* get_reader_slots() const;
+			// Checks what create wrote, once it's complete.
+			bool is_compatible(uint32_t component_size, uint32_t component_alignment) const;
+			unsigned char* get_buffer(uint32_t buffer) const;
+
+			SharedMemory m_memory;
+			uint32_t m_reader_slot{ INVALID_BUFFER };
+		};
+	}
+
+	template <typename T>
+	class SharedPoolPublisher {
+	public:
+		static_assert(std::is_trivially_copyable<T>::value, "Shared components are read as raw bytes by other processes");
+
+		SharedPoolPublisher() = default;
+		SharedPoolPublisher(const SharedPoolPublisher&) = delete;
+		SharedPoolPublisher& operator=(const SharedPoolPublisher&) = delete;
+
+		// Creates the segment, see SharedMemory::create. capacity is the most components published at once,
+		// max_readers the most readers at the same time.
+		bool open(const std::string& name, uint32_t capacity, uint32_t max_readers = 2) {
+			m_frame_number = 0;
+			return m_segment.create(name, sizeof(T), alignof(T), capacity, max_readers);
+		}
+
+		void close() { m_segment.close(); }
+		bool is_open() const { return m_segment.is_open(); }
+
+		// Copies the components of the pool, and their entities, to the readers. It never waits for them.
+		// Returns false, publishing nothing, if it's not open or there are more components than the capacity.
+		bool publish(ECS& ecs);
+
+		uint64_t get_frame_number() const { return m_frame_number; }
+
+	private:
+		detail::SharedPoolSegment m_segment;
+		uint64_t m_frame_number{ 0 };
+	};
+
+	template <typename T>
+	class SharedPoolReader {
+	public:
+		SharedPoolReader() = default;
+		~SharedPoolReader() { close(); }
+
+		SharedPoolReader(const SharedPoolReader&) = delete;
+		SharedPoolReader& operator=(const SharedPoolReader&) = delete;
+
+		// Maps the segment and takes a reader slot. Returns false if there is no such segment, if it holds another
+		// component type (by size and alignment), or if all of its reader slots are taken.
+		bool open(const std::string& name);
+		void close();
+		bool is_open() const { return m_segment.is_open(); }
+
+		// Pins the latest published frame, and releases the previous one. Returns false if nothing was published yet.
+		bool acquire();
+		// Lets the publisher reuse the pinned frame. The pointers can't be used after this.
+		void release();
+
+		// Of the pinned frame. The frame numbers start from 1.
+		uint64_t get_frame_number() const { return m_buffer != detail::SharedPoolSegment::INVALID_BUFFER ? m_segment.get_frame_number(m_buffer) : 0; }
+		uint32_t get_size() const { return m_buffer != detail::SharedPoolSegment::INVALID_BUFFER ? m_segment.get_count(m_buffer) : 0; }
+		const T* get_components() const;
+		const Entity* get_entities() const;
+
+	private:
+		detail::SharedPoolSegment m_segment;
+		uint32_t m_buffer{ detail::SharedPoolSegment::INVALID_BUFFER };
+	};
+}
+
+// SharedPoolPublisher<T>
+template <typename T>
+bool lecs::SharedPoolPublisher<T>::publish(ECS& ecs) {
+	if (!m_segment.is_open()) {
+		return false;
+	}
+
+	ComponentArray<T>& component_array = ecs.get_component_array<T>();
+	const size_t count = component_array.get_size();
+	const uint32_t buffer = m_segment.find_free_buffer();
+	if (count > m_segment.get_capacity() || buffer == detail::SharedPoolSegment::INVALID_BUFFER) {
+		return false;
+	}
+
+	Entity* entities = m_segment.get_entities(buffer);
+	unsigned char* components = static_cast<unsigned char*>(m_segment.get_components(buffer));
+	for (size_t i = 0; i < count; ++i) {
+		entities[i] = ecs.get_entity_from_index(component_array.get_entity_index_from_component_index(i));
+		std::memcpy(components + i * sizeof(T), &component_array.get_data_from_component_index(i), sizeof(T));
+	}
+
+	m_segment.publish_buffer(buffer, ++m_frame_number, static_cast<uint32_t>(count));
+	return true;
+}
+
+// SharedPoolReader<T>
+template <typename T>
+bool lecs::SharedPoolReader<T>::open(const std::string& name) {
+	close();
+	if (!m_segment.open(name, sizeof(T), alignof(T))) {
+		return false;
+	}
+
+	if (!m_segment.claim_reader_slot()) {
+		m_segment.close();
+		return false;
+	}
+
+	return true;
+}
+
+template <typename T>
+void lecs::SharedPoolReader<T>::close() {
+	if (m_segment.is_open()) {
+		release();
+		m_segment.release_reader_slot();
+		m_segment.close();
+	}
+}
+
+template <typename T>
+bool lecs::SharedPoolReader<T>::acquire() {
+	if (!m_segment.is_open()) {
+		return false;
+	}
+
+	m_buffer = m_segment.pin_latest_buffer();
+	return m_buffer != detail::SharedPoolSegment::INVALID_BUFFER;
+}
+
+template <typename T>
+void lecs::SharedPoolReader<T>::release() {
+	if (m_buffer != detail::SharedPoolSegment::INVALID_BUFFER) {
+		m_segment.unpin_buffer();
+		m_buffer = detail::SharedPoolSegment::INVALID_BUFFER;
+	}
+}
+
+template <typename T>
+const T* lecs::SharedPoolReader<T>::get_components() const {
+	return m_buffer != detail::SharedPoolSegment::INVALID_BUFFER ? static_cast<const T*>(m_segment.get_components(m_buffer)) : nullptr;
+}
+
+template <typename T>
+const lecs::Entity* lecs::SharedPoolReader<T>::get_entities() const {
+	return m_buffer != detail::SharedPoolSegment::INVALID_BUFFER ? m_segment.get_entities(m_buffer) : nullptr;
+}
+
+#if defined(LECS_IMPLEMENTATION)
+#include "lecs_shared_pools.cpp"
+#endif // defined(LECS_IMPLEMENTATION)
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
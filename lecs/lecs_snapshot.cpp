@@ -0,0 +1,619 @@
+// LECS (Lightweight Entity Component System) compressed snapshots implementation file
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace lecs {
+	namespace detail {
+		static const uint32_t SNAPSHOT_MAGIC = 0x5043454Cu; // "LECP"
+		static const uint32_t SNAPSHOT_VERSION = 2;
+		static const uint32_t SNAPSHOT_KEY_FRAME_FLAG = 1;
+		static const uint32_t SNAPSHOT_NO_PARTNER = static_cast<uint32_t>(-1);
+
+		static const size_t LZ_MIN_MATCH = 4;
+		// The end of the block is always literals, so the decoder never reads matches past it.
+		static const size_t LZ_LAST_LITERALS = 5;
+		static const uint32_t LZ_HASH_BITS = 12;
+		static const size_t LZ_MAX_OFFSET = 65535;
+
+		inline void write_snapshot_u32(std::vector<uint8_t>& bytes, uint32_t value) {
+			const size_t offset = bytes.size();
+			bytes.resize(offset + sizeof(value));
+			std::memcpy(bytes.data() + offset, &value, sizeof(value));
+		}
+
+		inline bool read_snapshot_u32(const std::vector<uint8_t>& bytes, size_t& offset, uint32_t& out_value) {
+			if (bytes.size() - offset < sizeof(out_value)) {
+				return false;
+			}
+
+			std::memcpy(&out_value, bytes.data() + offset, sizeof(out_value));
+			offset += sizeof(out_value);
+			return true;
+		}
+
+		// Points at size bytes of the frame, and skips them.
+		inline bool read_snapshot_block(const std::vector<uint8_t>& bytes, size_t& offset, uint32_t size, const uint8_t*& out_block) {
+			if (bytes.size() - offset < size) {
+				return false;
+			}
+
+			out_block = bytes.data() + offset;
+			offset += size;
+			return true;
+		}
+
+		inline void write_snapshot_varint(std::vector<uint8_t>& bytes, uint64_t value) {
+			while (value >= 0x80) {
+				bytes.push_back(static_cast<uint8_t>(value | 0x80));
+				value >>= 7;
+			}
+			bytes.push_back(static_cast<uint8_t>(value));
+		}
+
+		inline bool read_snapshot_varint(const uint8_t* bytes, size_t size, size_t& offset, uint64_t& out_value) {
+			out_value = 0;
+			for (uint32_t shift = 0; shift < 64; shift += 7) {
+				if (offset >= size) {
+					return false;
+				}
+
+				const uint8_t byte = bytes[offset++];
+				out_value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+				if ((byte & 0x80) == 0) {
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		// The position of every entity in the previous pool, or SNAPSHOT_NO_PARTNER if it was not there (another entity with
+		// the same index doesn't count). Both lists are sorted by index.
+		inline void match_snapshot_partners(const std::vector<Entity>& entities, const std::vector<Entity>& previous_entities, std::vector<uint32_t>& out_partners) {
+			out_partners.resize(entities.size());
+			size_t previous_position = 0;
+			for (size_t i = 0; i < entities.size(); ++i) {
+				while (previous_position < previous_entities.size() && previous_entities[previous_position].get_index() < entities[i].get_index()) {
+					previous_position++;
+				}
+				out_partners[i] = previous_position < previous_entities.size() && previous_entities[previous_position] == entities[i] ?
+					static_cast<uint32_t>(previous_position) : SNAPSHOT_NO_PARTNER;
+			}
+		}
+
+		// XORs each plane with the same plane of the previous pool, every component with the one of the same entity.
+		inline void xor_snapshot_planes(uint8_t* shuffled, size_t count, size_t component_size, const SnapshotPool& previous, const std::vector<uint32_t>& partners) {
+			const size_t previous_count = previous.entities.size();
+			for (size_t b = 0; b < component_size; ++b) {
+				uint8_t* plane = shuffled + b * count;
+				const uint8_t* previous_plane = previous.shuffled.data() + b * previous_count;
+				for (size_t i = 0; i < count; ++i) {
+					if (partners[i] != SNAPSHOT_NO_PARTNER) {
+						plane[i] ^= previous_plane[partners[i]];
+					}
+				}
+			}
+		}
+
+		// Compresses a varint block, prefixed by its size and its compressed size.
+		inline void write_snapshot_compressed(std::vector<uint8_t>& out_frame, const std::vector<uint8_t>& block) {
+			const size_t sizes_offset = out_frame.size();
+			write_snapshot_u32(out_frame, static_cast<uint32_t>(block.size()));
+			write_snapshot_u32(out_frame, 0);
+			lz_compress(block.data(), block.size(), out_frame);
+
+			const uint32_t compressed_size = static_cast<uint32_t>(out_frame.size() - sizes_offset - 2 * sizeof(uint32_t));
+			std::memcpy(out_frame.data() + sizes_offset + sizeof(uint32_t), &compressed_size, sizeof(compressed_size));
+		}
+
+		inline uint32_t read_lz_u32(const uint8_t* data) {
+			uint32_t value;
+			std::memcpy(&value, data, sizeof(value));
+			return value;
+		}
+
+		inline void write_lz_length(std::vector<uint8_t>& out_compressed, size_t length) {
+			while (length >= 255) {
+				out_compressed.push_back(255);
+				length -= 255;
+			}
+			out_compressed.push_back(static_cast<uint8_t>(length));
+		}
+
+		inline bool read_lz_length(const uint8_t* compressed, size_t compressed_size, size_t& offset, size_t& length) {
+			uint8_t byte;
+			do {
+				if (offset >= compressed_size) {
+					return false;
+				}
+				byte = compressed[offset++];
+				length += byte;
+			} while (byte == 255);
+
+			return true;
+		}
+
+		inline void write_lz_sequence(std::vector<uint8_t>& out_compressed, const uint8_t* literals, size_t literal_count, size_t offset, size_t match_length) {
+			const size_t match_code = match_length >= LZ_MIN_MATCH ? match_length - LZ_MIN_MATCH : 0;
+			out_compressed.push_back(static_cast<uint8_t>(((literal_count < 15 ? literal_count : 15) << 4) | (match_code < 15 ? match_code : 15)));
+			if (literal_count >= 15) {
+				write_lz_length(out_compressed, literal_count - 15);
+			}
+			out_compressed.insert(out_compressed.end(), literals, literals + literal_count);
+
+			if (match_length == 0) {
+				return;
+			}
+
+			out_compressed.push_back(static_cast<uint8_t>(offset & 0xFF));
+			out_compressed.push_back(static_cast<uint8_t>(offset >> 8));
+			if (match_code >= 15) {
+				write_lz_length(out_compressed, match_code - 15);
+			}
+		}
+	}
+}
+
+void lecs::detail::lz_compress(const uint8_t* data, size_t size, std::vector<uint8_t>& out_compressed) {
+	static const uint32_t NO_POSITION = static_cast<uint32_t>(-1);
+	uint32_t hash_table[1 << LZ_HASH_BITS];
+	std::fill(std::begin(hash_table), std::end(hash_table), NO_POSITION);
+
+	size_t anchor = 0;
+	size_t position = 0;
+	if (size >= LZ_MIN_MATCH + LZ_LAST_LITERALS) {
+		const size_t match_limit = size - LZ_LAST_LITERALS;
+		while (position + LZ_MIN_MATCH <= match_limit) {
+			const uint32_t sequence = read_lz_u32(data + position);
+			const uint32_t hash = (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+			const uint32_t candidate = hash_table[hash];
+			hash_table[hash] = static_cast<uint32_t>(position);
+
+			if (candidate == NO_POSITION || position - candidate > LZ_MAX_OFFSET || read_lz_u32(data + candidate) != sequence) {
+				// Data that doesn't compress is skipped faster and faster.
+				position += 1 + ((position - anchor) >> 6);
+				continue;
+			}
+
+			size_t match_length = LZ_MIN_MATCH;
+			while (position + match_length < match_limit && data[candidate + match_length] == data[position + match_length]) {
+				match_length++;
+			}
+
+			write_lz_sequence(out_compressed, data + anchor, position - anchor, position - candidate, match_length);
+			position += match_length;
+			anchor = position;
+		}
+	}
+
+	write_lz_sequence(out_compressed, data + anchor, size - anchor, 0, 0);
+}
+
+bool lecs::detail::lz_decompress(const uint8_t* compressed, size_t compressed_size, uint8_t* out_data, size_t size) {
+	size_t in = 0;
+	size_t out = 0;
+	while (in < compressed_size) {
+		const uint8_t token = compressed[in++];
+
+		size_t literal_count = token >> 4;
+		if (literal_count == 15 && !read_lz_length(compressed, compressed_size, in, literal_count)) {
+			return false;
+		}
+		if (literal_count > compressed_size - in || literal_count > size - out) {
+			return false;
+		}
+		if (literal_count > 0) {
+			std::memcpy(out_data + out, compressed + in, literal_count);
+		}
+		in += literal_count;
+		out += literal_count;
+
+		// The last sequence has no match.
+		if (in == compressed_size) {
+			break;
+		}
+
+		if (compressed_size - in < 2) {
+			return false;
+		}
+		const size_t offset = compressed[in] | (static_cast<size_t>(compressed[in + 1]) << 8);
+		in += 2;
+		if (offset == 0 || offset > out) {
+			return false;
+		}
+
+		size_t match_length = (token & 0x0F) + LZ_MIN_MATCH;
+		if ((token & 0x0F) == 15 && !read_lz_length(compressed, compressed_size, in, match_length)) {
+			return false;
+		}
+		if (match_length > size - out) {
+			return false;
+		}
+
+		// Matches can overlap what they write (eg. runs of the same byte), every copy doubles the distance it can read from.
+		size_t distance = offset;
+		size_t copied = 0;
+		while (copied < match_length) {
+			const size_t chunk = match_length - copied < distance ? match_length - copied : distance;
+			std::memcpy(out_data + out + copied, out_data + out + copied - distance, chunk);
+			copied += chunk;
+			distance += chunk;
+		}
+		out += match_length;
+	}
+
+	return out == size;
+}
+
+// SnapshotEncoder
+void lecs::SnapshotEncoder::encode(ECS& ecs, std::vector<uint8_t>& out_frame) {
+	out_frame.clear();
+	const bool is_key_frame = m_frame_number % m_key_frame_interval == 0;
+	if (is_key_frame) {
+		m_previous_pools.clear();
+	}
+
+	std::vector<Entity> entities;
+	const EntityIndex entity_count = static_cast<EntityIndex>(ecs.get_entity_count());
+	m_entity_positions.resize(entity_count);
+	for (EntityIndex entity_index = 0; entity_index < entity_count; ++entity_index) {
+		const Entity entity = ecs.get_entity_from_index(entity_index);
+		if (entity.is_valid()) {
+			m_entity_positions[entity_index] = static_cast<uint32_t>(entities.size());
+			entities.push_back(entity);
+		}
+	}
+
+	uint32_t pool_count = 0;
+	for (const ComponentType& type : m_registry.get_types()) {
+		if (type.trivially_copyable) {
+			pool_count++;
+		}
+	}
+
+	detail::write_snapshot_u32(out_frame, detail::SNAPSHOT_MAGIC);
+	detail::write_snapshot_u32(out_frame, detail::SNAPSHOT_VERSION);
+	detail::write_snapshot_u32(out_frame, is_key_frame ? detail::SNAPSHOT_KEY_FRAME_FLAG : 0);
+	detail::write_snapshot_u32(out_frame, m_frame_number);
+	detail::write_snapshot_u32(out_frame, static_cast<uint32_t>(entities.size()));
+	detail::write_snapshot_u32(out_frame, pool_count);
+
+	// Entities are sorted by index, so the gaps between them are small.
+	m_scratch.clear();
+	EntityIndex next_index = 0;
+	for (Entity entity : entities) {
+		detail::write_snapshot_varint(m_scratch, entity.get_index() - next_index);
+		detail::write_snapshot_varint(m_scratch, entity.get_generation());
+		next_index = entity.get_index() + 1;
+	}
+	detail::write_snapshot_compressed(out_frame, m_scratch);
+
+	std::vector<uint32_t> positions;
+	detail::SnapshotPool pool;
+	for (const ComponentType& type : m_registry.get_types()) {
+		if (!type.trivially_copyable) {
+			continue;
+		}
+
+		// One walk over the compact array, then the components are put in the order of the entities.
+		type.get_components(ecs, m_pool_entity_indices, m_pool_components);
+		m_components_by_position.assign(entities.size(), nullptr);
+		for (size_t i = 0; i < m_pool_components.size(); ++i) {
+			m_components_by_position[m_entity_positions[m_pool_entity_indices[i]]] = m_pool_components[i];
+		}
+
+		positions.clear();
+		pool.entities.clear();
+		for (size_t i = 0; i < entities.size(); ++i) {
+			if (m_components_by_position[i] != nullptr) {
+				positions.push_back(static_cast<uint32_t>(i));
+				pool.entities.push_back(entities[i]);
+			}
+		}
+
+		const size_t count = positions.size();
+		detail::write_snapshot_u32(out_frame, type.key);
+		detail::write_snapshot_u32(out_frame, type.size);
+		detail::write_snapshot_u32(out_frame, static_cast<uint32_t>(count));
+
+		m_scratch.clear();
+		uint32_t next_position = 0;
+		for (uint32_t position : positions) {
+			detail::write_snapshot_varint(m_scratch, position - next_position);
+			next_position = position + 1;
+		}
+		detail::write_snapshot_compressed(out_frame, m_scratch);
+
+		// Byte b of component i goes to plane b: the same byte of every component is together, and it changes little from one to the next.
+		pool.shuffled.resize(count * type.size);
+		for (size_t i = 0; i < count; ++i) {
+			const uint8_t* component = static_cast<const uint8_t*>(m_components_by_position[positions[i]]);
+			for (size_t b = 0; b < type.size; ++b) {
+				pool.shuffled[b * count + i] = component[b];
+			}
+		}
+
+		// XOR with the same entity in the previous frame, what didn't change becomes zeros. Matching entities instead of
+		// positions keeps the zeros when entities are created or removed.
+		detail::SnapshotPool& previous = m_previous_pools[type.key];
+		m_scratch = pool.shuffled;
+		detail::match_snapshot_partners(pool.entities, previous.entities, m_partners);
+		detail::xor_snapshot_planes(m_scratch.data(), count, type.size, previous, m_partners);
+		std::swap(previous, pool);
+
+		const size_t sizes_offset = out_frame.size();
+		detail::write_snapshot_u32(out_frame, 0);
+		detail::lz_compress(m_scratch.data(), m_scratch.size(), out_frame);
+		const uint32_t compressed_size = static_cast<uint32_t>(out_frame.size() - sizes_offset - sizeof(uint32_t));
+		std::memcpy(out_frame.data() + sizes_offset, &compressed_size, sizeof(compressed_size));
+	}
+
+	m_frame_number++;
+}
+
+void lecs::SnapshotEncoder::reset() {
+	m_frame_number = 0;
+	m_previous_pools.clear();
+}
+
+// SnapshotDecoder
+bool lecs::SnapshotDecoder::decode(const std::vector<uint8_t>& frame, ECS& ecs) {
+	size_t offset = 0;
+	uint32_t magic, version, flags, frame_number, entity_count, pool_count;
+	if (!detail::read_snapshot_u32(frame, offset, magic) || magic != detail::SNAPSHOT_MAGIC ||
+		!detail::read_snapshot_u32(frame, offset, version) || version != detail::SNAPSHOT_VERSION ||
+		!detail::read_snapshot_u32(frame, offset, flags) ||
+		!detail::read_snapshot_u32(frame, offset, frame_number) ||
+		!detail::read_snapshot_u32(frame, offset, entity_count) || entity_count > static_cast<uint32_t>(MAX_ENTITIES) ||
+		!detail::read_snapshot_u32(frame, offset, pool_count)) {
+		return false;
+	}
+
+	const bool is_key_frame = (flags & detail::SNAPSHOT_KEY_FRAME_FLAG) != 0;
+	if (!is_key_frame && (!m_has_previous_frame || frame_number != m_previous_frame_number + 1)) {
+		return false;
+	}
+
+	uint32_t entities_size, compressed_entities_size;
+	const uint8_t* compressed_entities;
+	if (!detail::read_snapshot_u32(frame, offset, entities_size) ||
+		!detail::read_snapshot_u32(frame, offset, compressed_entities_size) ||
+		!detail::read_snapshot_block(frame, offset, compressed_entities_size, compressed_entities)) {
+		return false;
+	}
+
+	// Every entity takes 2 varints, of 1 to 10 bytes. This also bounds what is allocated for a malformed frame.
+	if (entities_size < entity_count * 2ull || entities_size > entity_count * 20ull || pool_count > m_registry.get_types().size()) {
+		return false;
+	}
+
+	std::vector<DecodedPool> pools(pool_count);
+
+	for (DecodedPool& pool : pools) {
+		uint32_t key, component_size;
+		if (!detail::read_snapshot_u32(frame, offset, key) ||
+			!detail::read_snapshot_u32(frame, offset, component_size) ||
+			!detail::read_snapshot_u32(frame, offset, pool.count) || pool.count > entity_count ||
+			!detail::read_snapshot_u32(frame, offset, pool.positions_size) ||
+			!detail::read_snapshot_u32(frame, offset, pool.compressed_positions_size) ||
+			!detail::read_snapshot_block(frame, offset, pool.compressed_positions_size, pool.compressed_positions) ||
+			!detail::read_snapshot_u32(frame, offset, pool.compressed_data_size) ||
+			!detail::read_snapshot_block(frame, offset, pool.compressed_data_size, pool.compressed_data)) {
+			return false;
+		}
+
+		pool.type = m_registry.find_by_key(key);
+		if (pool.type == nullptr || !pool.type->trivially_copyable || pool.type->size != component_size ||
+			pool.positions_size < pool.count || pool.positions_size > pool.count * 10ull) {
+			return false;
+		}
+		pool.is_valid = false;
+	}
+
+	// The entities and every pool are decompressed on their own job, the ECS is only changed once all of them were valid.
+	std::vector<Entity> recorded_entities(entity_count);
+	bool are_entities_valid = false;
+	auto decode_entities = [&]() {
+		std::vector<uint8_t> bytes(entities_size);
+		if (!detail::lz_decompress(compressed_entities, compressed_entities_size, bytes.data(), bytes.size())) {
+			return;
+		}
+
+		size_t byte_offset = 0;
+		uint64_t next_index = 0;
+		for (Entity& entity : recorded_entities) {
+			uint64_t gap, generation;
+			if (!detail::read_snapshot_varint(bytes.data(), bytes.size(), byte_offset, gap) ||
+				!detail::read_snapshot_varint(bytes.data(), bytes.size(), byte_offset, generation)) {
+				return;
+			}
+
+			const uint64_t entity_index = next_index + gap;
+			if (entity_index >= static_cast<uint64_t>(MAX_ENTITIES) || generation > static_cast<EntityGeneration>(-1)) {
+				return;
+			}
+
+			entity = Entity(static_cast<EntityIndex>(entity_index), static_cast<EntityGeneration>(generation));
+			next_index = entity_index + 1;
+		}
+		are_entities_valid = byte_offset == bytes.size();
+	};
+
+	// The pools are XORed entity by entity, so the entities are decoded first.
+	decode_entities();
+	if (!are_entities_valid) {
+		return false;
+	}
+
+	auto decode_job = [&](int32_t begin, int32_t end) {
+		for (int32_t i = begin; i < end; ++i) {
+			pools[i].is_valid = decode_pool(pools[i], recorded_entities, is_key_frame);
+		}
+	};
+
+	if (m_job_pool != nullptr) {
+		m_job_pool->parallel_for(static_cast<int32_t>(pools.size()), 1, decode_job);
+	}
+	else {
+		decode_job(0, static_cast<int32_t>(pools.size()));
+	}
+
+	for (const DecodedPool& pool : pools) {
+		if (!pool.is_valid) {
+			return false;
+		}
+	}
+
+	// Entities that are not in the frame anymore are removed, the new ones are created.
+	std::unordered_map<Entity::IDType, Entity> local_entities;
+	local_entities.reserve(recorded_entities.size());
+	for (Entity recorded_entity : recorded_entities) {
+		auto it = m_local_entities.find(recorded_entity.id);
+		if (it != m_local_entities.end()) {
+			local_entities.emplace(recorded_entity.id, it->second);
+			m_local_entities.erase(it);
+		}
+	}
+	for (const auto& removed_entity : m_local_entities) {
+		ecs.remove_entity(removed_entity.second);
+	}
+
+	std::vector<Entity> entities(recorded_entities.size());
+	for (size_t i = 0; i < recorded_entities.size(); ++i) {
+		auto it = local_entities.find(recorded_entities[i].id);
+		if (it != local_entities.end()) {
+			entities[i] = it->second;
+		}
+		else {
+			entities[i] = ecs.create_entity();
+			local_entities.emplace(recorded_entities[i].id, entities[i]);
+		}
+	}
+	m_local_entities.swap(local_entities);
+
+	std::vector<bool> has_component;
+	for (DecodedPool& pool : pools) {
+		const ComponentType& type = *pool.type;
+		has_component.assign(entities.size(), false);
+
+		for (uint32_t i = 0; i < pool.count; ++i) {
+			const Entity entity = entities[pool.positions[i]];
+			const uint8_t* bytes = pool.components.data() + static_cast<size_t>(i) * type.size;
+			has_component[pool.positions[i]] = true;
+
+			// Components that didn't change are not written, so their observers are not told they changed.
+			const void* component = type.get_component(ecs, entity);
+			if (component == nullptr) {
+				type.add_component_from_bytes(ecs, entity, bytes);
+			}
+			else if (std::memcmp(component, bytes, type.size) != 0) {
+				type.set_component_from_bytes(ecs, entity, bytes);
+			}
+		}
+
+		for (size_t i = 0; i < entities.size(); ++i) {
+			if (!has_component[i] && type.get_component(ecs, entities[i]) != nullptr) {
+				type.remove_component(ecs, entities[i]);
+			}
+		}
+
+		std::swap(m_previous_pools[type.key], pool.shuffled_pool);
+	}
+
+	m_has_previous_frame = true;
+	m_previous_frame_number = frame_number;
+	return true;
+}
+
+lecs::Entity lecs::SnapshotDecoder::get_local_entity(Entity recorded_entity) const {
+	auto it = m_local_entities.find(recorded_entity.id);
+	return it != m_local_entities.end() ? it->second : Entity::Invalid;
+}
+
+bool lecs::SnapshotDecoder::is_key_frame(const std::vector<uint8_t>& frame) {
+	size_t offset = 0;
+	uint32_t magic, version, flags;
+	return detail::read_snapshot_u32(frame, offset, magic) && magic == detail::SNAPSHOT_MAGIC &&
+		detail::read_snapshot_u32(frame, offset, version) && version == detail::SNAPSHOT_VERSION &&
+		detail::read_snapshot_u32(frame, offset, flags) && (flags & detail::SNAPSHOT_KEY_FRAME_FLAG) != 0;
+}
+
+bool lecs::SnapshotDecoder::decode_pool(DecodedPool& pool, const std::vector<Entity>& recorded_entities, bool is_key_frame) const {
+	const size_t count = pool.count;
+	const size_t component_size = pool.type->size;
+
+	std::vector<uint8_t> bytes(pool.positions_size);
+	if (!detail::lz_decompress(pool.compressed_positions, pool.compressed_positions_size, bytes.data(), bytes.size())) {
+		return false;
+	}
+
+	pool.positions.resize(count);
+	pool.shuffled_pool.entities.resize(count);
+	size_t byte_offset = 0;
+	uint64_t next_position = 0;
+	for (size_t i = 0; i < count; ++i) {
+		uint64_t gap;
+		if (!detail::read_snapshot_varint(bytes.data(), bytes.size(), byte_offset, gap) || next_position + gap >= recorded_entities.size()) {
+			return false;
+		}
+
+		pool.positions[i] = static_cast<uint32_t>(next_position + gap);
+		pool.shuffled_pool.entities[i] = recorded_entities[pool.positions[i]];
+		next_position = pool.positions[i] + 1;
+	}
+
+	std::vector<uint8_t>& shuffled = pool.shuffled_pool.shuffled;
+	shuffled.resize(count * component_size);
+	if (!detail::lz_decompress(pool.compressed_data, pool.compressed_data_size, shuffled.data(), shuffled.size())) {
+		return false;
+	}
+
+	// Undo the XOR with the previous frame. The jobs only read the previous pools, decode swaps them once they are done.
+	if (!is_key_frame) {
+		auto it = m_previous_pools.find(pool.type->key);
+		if (it != m_previous_pools.end()) {
+			std::vector<uint32_t> partners;
+			detail::match_snapshot_partners(pool.shuffled_pool.entities, it->second.entities, partners);
+			detail::xor_snapshot_planes(shuffled.data(), count, component_size, it->second, partners);
+		}
+	}
+
+	pool.components.resize(count * component_size);
+	for (size_t b = 0; b < component_size; ++b) {
+		const uint8_t* plane = shuffled.data() + b * count;
+		for (size_t i = 0; i < count; ++i) {
+			pool.components[i * component_size + b] = plane[i];
+		}
+	}
+
+	return true;
+}
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
@@ -0,0 +1,148 @@
+// LECS (Lightweight Entity Component System) compressed snapshots
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+// USAGE:
+// This is optional. It uses the ComponentRegistry and the JobPool, include lecs_snapshot.hpp, lecs_registry.hpp and lecs_jobs.hpp
+// in the same .cpp where you #define LECS_IMPLEMENTATION.
+//
+// A snapshot saves the entities of a world and their registered (trivially copyable) components, compressed.
+// Encode one per frame to record a replay:
+// lecs::SnapshotEncoder encoder(registry);
+// std::vector<uint8_t> frame;
+// encoder.encode(my_ecs, frame); // append it to the replay
+//
+// Then apply the frames in the same order to play it back, in another ECS:
+// lecs::SnapshotDecoder decoder(registry, &job_pool);
+// decoder.decode(frame, replay_ecs);
+// lecs::Entity replayed_entity = decoder.get_local_entity(recorded_entity);
+//
+// Each component array is sorted by entity, byte shuffled (the first byte of every component, then the second and so on),
+// XORed with the component of the same entity in the previous frame and compressed with a small LZ coder. Components that
+// don't change become zeros, which take next to nothing, even when entities are created and removed. Pools are decompressed in parallel on the job pool.
+// Frames other than key frames depend on the previous one, seek to a key frame (see is_key_frame) to start decoding.
+
+#pragma once
+
+#include "lecs.hpp"
+#include "lecs_jobs.hpp"
+#include "lecs_registry.hpp"
+
+#include <unordered_map>
+#include <vector>
+
+namespace lecs {
+	namespace detail {
+		// A pool of the previous frame, the next one is XORed with it.
+		struct SnapshotPool {
+			// The recorded handles, sorted by index.
+			std::vector<Entity> entities;
+			std::vector<uint8_t> shuffled;
+		};
+	}
+
+	class SnapshotEncoder {
+	public:
+		explicit SnapshotEncoder(const ComponentRegistry& registry) : m_registry(registry) {}
+
+		// Every key_frame_interval frames, one doesn't depend on the previous frames. 1 makes all of them key frames.
+		void set_key_frame_interval(uint32_t key_frame_interval) { m_key_frame_interval = key_frame_interval > 0 ? key_frame_interval : 1; }
+
+		void encode(ECS& ecs, std::vector<uint8_t>& out_frame);
+
+		// The next frame will be a key frame.
+		void reset();
+
+	private:
+		const ComponentRegistry& m_registry;
+		uint32_t m_key_frame_interval{ 60 };
+		uint32_t m_frame_number{ 0 };
+		// The shuffled components of the previous frame, by component key.
+		std::unordered_map<uint32_t, detail::SnapshotPool> m_previous_pools;
+		std::vector<uint8_t> m_scratch;
+		// The position in the frame of every entity index.
+		std::vector<uint32_t> m_entity_positions;
+		std::vector<EntityIndex> m_pool_entity_indices;
+		std::vector<const void*> m_pool_components;
+		// The component of every entity of the frame, nullptr if it doesn't have one.
+		std::vector<const void*> m_components_by_position;
+		std::vector<uint32_t> m_partners;
+	};
+
+	class SnapshotDecoder {
+	public:
+		// Without a job pool, pools are decompressed on the calling thread.
+		SnapshotDecoder(const ComponentRegistry& registry, JobPool* job_pool = nullptr) : m_registry(registry), m_job_pool(job_pool) {}
+
+		// Makes the ECS match the frame: entities are created and removed, components added, written and removed.
+		// Returns false, without touching the ECS, if the frame is malformed or depends on a frame that was not decoded.
+		bool decode(const std::vector<uint8_t>& frame, ECS& ecs);
+
+		// Returns Entity::Invalid if the recorded entity doesn't exist in the last decoded frame.
+		Entity get_local_entity(Entity recorded_entity) const;
+
+		static bool is_key_frame(const std::vector<uint8_t>& frame);
+
+	private:
+		struct DecodedPool {
+			const ComponentType* type;
+			uint32_t count;
+			const uint8_t* compressed_positions;
+			uint32_t positions_size;
+			uint32_t compressed_positions_size;
+			const uint8_t* compressed_data;
+			uint32_t compressed_data_size;
+			// Filled by the jobs. Positions are in the entity list of the frame.
+			std::vector<uint32_t> positions;
+			// Kept by decode for the next frame.
+			detail::SnapshotPool shuffled_pool;
+			std::vector<uint8_t> components;
+			bool is_valid;
+		};
+
+		bool decode_pool(DecodedPool& pool, const std::vector<Entity>& recorded_entities, bool is_key_frame) const;
+
+		const ComponentRegistry& m_registry;
+		JobPool* m_job_pool;
+		bool m_has_previous_frame{ false };
+		uint32_t m_previous_frame_number{ 0 };
+		std::unordered_map<uint32_t, detail::SnapshotPool> m_previous_pools;
+		std::unordered_map<Entity::IDType, Entity> m_local_entities;
+	};
+
+	namespace detail {
+		// LZ77 with the sequence layout of LZ4 blocks: a token with the literal and match lengths, the literals, a 16 bits offset.
+		// Appends to out_compressed.
+		void lz_compress(const uint8_t* data, size_t size, std::vector<uint8_t>& out_compressed);
+		// Returns false if the data is malformed or doesn't decompress to exactly size bytes.
+		bool lz_decompress(const uint8_t* compressed, size_t compressed_size, uint8_t* out_data, size_t size);
+	}
+}
+
+#if defined(LECS_IMPLEMENTATION)
+#include "lecs_snapshot.cpp"
+#endif // defined(LECS_IMPLEMENTATION)
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
@@ -0,0 +1,535 @@
+// LECS (Lightweight Entity Component System) spatial index
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+// USAGE:
+// This is optional. It uses the JobPool, so include lecs_jobs.hpp in the same .cpp where you #define LECS_IMPLEMENTATION.
+//
+// A SpatialGrid indexes the entities by the position stored in one of their components.
+// First tell it where the position is, by specializing SpatialPositionOf (or by passing your own accessor type):
+// template <>
+// struct lecs::SpatialPositionOf<Transform> {
+//		lecs::SpatialPoint operator()(const Transform& transform) const {
+//			return { transform.position[0], transform.position[1], transform.position[2] };
+//		}
+// };
+//
+// Then create it, with a cell size about the size of your usual query radius:
+// lecs::SpatialGrid<Transform> grid(my_ecs, 10.0f);
+//
+// The grid observes the component, so adding and removing it (or the entity) keeps the grid up to date.
+// When a position changes, use set_component or notify_component_changed so the grid can move the entity:
+// my_ecs.set_component<Transform>(entity, new_transform);
+//
+// Queries fill a vector of entities:
+// std::vector<lecs::Entity> neighbours;
+// grid.query_radius({ 0.0f, 0.0f, 0.0f }, 10.0f, neighbours);
+// grid.query_box({ -5.0f, -5.0f, -5.0f }, { 5.0f, 5.0f, 5.0f }, neighbours);
+// grid.query_k_nearest({ 0.0f, 0.0f, 0.0f }, 8, neighbours); // sorted by distance
+// Disabled entities stay in the grid, but queries leave them out unless the filter is lecs::EntityFilter::IncludeDisabled.
+//
+// When most things move every frame, skip the notifications and rebuild the whole grid instead, in parallel if you pass a job pool:
+// grid.rebuild(&job_pool);
+//
+// For 2D just leave z at 0, the grid only visits the cells that can contain something.
+
+#pragma once
+
+#include "lecs.hpp"
+#include "lecs_jobs.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <queue>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace lecs {
+	struct SpatialPoint {
+		float x;
+		float y;
+		float z;
+	};
+
+	// Specialize it for your position component, see the usage above.
+	template <typename PositionComponent>
+	struct SpatialPositionOf;
+
+	// Uniform grid of cells, stored sparsely in hash maps, so only the occupied cells cost memory.
+	// The positions are cached in the grid, queries never touch the component data.
+	template <typename PositionComponent, typename PositionAccessor = SpatialPositionOf<PositionComponent>>
+	class SpatialGrid : public IComponentObserver {
+	public:
+		SpatialGrid(ECS& ecs, float cell_size, PositionAccessor accessor = PositionAccessor{});
+		~SpatialGrid() override;
+
+		SpatialGrid(const SpatialGrid&) = delete;
+		SpatialGrid& operator=(const SpatialGrid&) = delete;
+
+		void on_component_added(Entity entity) override;
+		void on_component_removed(Entity entity) override;
+		void on_component_changed(Entity entity) override;
+
+		// Appends the entities within radius of center.
+		void query_radius(const SpatialPoint& center, float radius, std::vector<Entity>& out_entities, EntityFilter filter = EntityFilter::EnabledOnly) const;
+
+		// Appends the entities inside the box (bounds included).
+		void query_box(const SpatialPoint& min, const SpatialPoint& max, std::vector<Entity>& out_entities, EntityFilter filter = EntityFilter::EnabledOnly) const;
+
+		// Appends the (up to) k entities closest to center, the closest first.
+		void query_k_nearest(const SpatialPoint& center, int32_t k, std::vector<Entity>& out_entities, EntityFilter filter = EntityFilter::EnabledOnly) const;
+
+		// Reads the positions of all the components again. With a job pool the work is split between its threads.
+		void rebuild(JobPool* job_pool = nullptr);
+
+		int32_t get_entity_count() const { return m_entity_count; }
+
+		float get_cell_size() const { return m_cell_size; }
+
+	private:
+		using CellKey = uint64_t;
+		using Cell = std::vector<EntityIndex>;
+		using CellMap = std::unordered_map<CellKey, Cell>;
+
+		// The cells are split in partitions by key, so a rebuild can fill each partition on a different thread.
+		static const int32_t PARTITION_COUNT = 16;
+
+		// Cell coordinates are packed in 21 bits each. Far away cells can alias, which only adds candidates to the distance tests.
+		static const int32_t CELL_COORDINATE_BITS = 21;
+		static const int32_t CELL_COORDINATE_OFFSET = 1 << (CELL_COORDINATE_BITS - 1);
+		static const CellKey CELL_COORDINATE_MASK = (CellKey(1) << CELL_COORDINATE_BITS) - 1;
+
+		struct CellCoordinates {
+			int32_t x;
+			int32_t y;
+			int32_t z;
+		};
+
+		struct Slot {
+			SpatialPoint position{ 0.0f, 0.0f, 0.0f };
+			CellKey cell{ 0 };
+			uint32_t index_in_cell{ 0 };
+			bool present{ false };
+		};
+
+		CellCoordinates to_cell_coordinates(const SpatialPoint& point) const;
+		static CellKey to_cell_key(const CellCoordinates& coordinates);
+		static CellCoordinates from_cell_key(CellKey key);
+		static int32_t get_partition(CellKey key);
+
+		void insert(EntityIndex entity_index, const SpatialPoint& position);
+		void erase(EntityIndex entity_index);
+		void grow_bounds(const CellCoordinates& coordinates);
+		Slot& get_slot(EntityIndex entity_index);
+
+		// Calls visitor(cell) for every occupied cell in the range. It walks the occupied cells instead, if there are fewer of them.
+		template <typename Visitor>
+		void visit_cells(CellCoordinates min, CellCoordinates max, Visitor&& visitor) const;
+
+		static float distance_squared(const SpatialPoint& a, const SpatialPoint& b);
+
+		bool passes(EntityIndex entity_index, EntityFilter filter) const {
+			return filter == EntityFilter::IncludeDisabled || m_ecs.is_entity_enabled_from_index(entity_index);
+		}
+
+		ECS& m_ecs;
+		PositionAccessor m_accessor;
+		float m_cell_size;
+		float m_inverse_cell_size;
+
+		std::vector<Slot> m_slots;
+		std::array<CellMap, PARTITION_COUNT> m_partitions;
+		int32_t m_cell_count{ 0 };
+		int32_t m_entity_count{ 0 };
+
+		// Conservative bounds of the occupied cells, they only grow until the next rebuild.
+		CellCoordinates m_min_bounds{ 0, 0, 0 };
+		CellCoordinates m_max_bounds{ -1, -1, -1 };
+	};
+}
+
+template <typename PositionComponent, typename PositionAccessor>
+lecs::SpatialGrid<PositionComponent, PositionAccessor>::SpatialGrid(ECS& ecs, float cell_size, PositionAccessor accessor)
+	: m_ecs(ecs), m_accessor(accessor), m_cell_size(cell_size), m_inverse_cell_size(1.0f / cell_size) {
+	m_ecs.add_component_observer<PositionComponent>(this);
+	rebuild();
+}
+
+template <typename PositionComponent, typename PositionAccessor>
+lecs::SpatialGrid<PositionComponent, PositionAccessor>::~SpatialGrid() {
+	m_ecs.remove_component_observer<PositionComponent>(this);
+}
+
+template <typename PositionComponent, typename PositionAccessor>
+void lecs::SpatialGrid<PositionComponent, PositionAccessor>::on_component_added(Entity entity) {
+	insert(entity.get_index(), m_accessor(*m_ecs.get_component<PositionComponent>(entity)));
+}
+
+template <typename PositionComponent, typename PositionAccessor>
+void lecs::SpatialGrid<PositionComponent, PositionAccessor>::on_component_removed(Entity entity) {
+	erase(entity.get_index());
+}
+
+template <typename PositionComponent, typename PositionAccessor>
+void lecs::SpatialGrid<PositionComponent, PositionAccessor>::on_component_changed(Entity entity) {
+	const EntityIndex entity_index = entity.get_index();
+	const SpatialPoint position = m_accessor(*m_ecs.get_component<PositionComponent>(entity));
+
+	Slot& slot = get_slot(entity_index);
+	if (slot.present && slot.cell == to_cell_key(to_cell_coordinates(position))) {
+		slot.position = position;
+		return;
+	}
+
+	erase(entity_index);
+	insert(entity_index, position);
+}
+
+template <typename PositionComponent, typename PositionAccessor>
+void lecs::SpatialGrid<PositionComponent, PositionAccessor>::query_radius(const SpatialPoint& center, float radius, std::vector<Entity>& out_entities, EntityFilter filter) const {
+	const float radius_squared = radius * radius;
+	const CellCoordinates min = to_cell_coordinates({ center.x - radius, center.y - radius, center.z - radius });
+	const CellCoordinates max = to_cell_coordinates({ center.x + radius, center.y + radius, center.z + radius });
+
+	visit_cells(min, max, [&](const Cell& cell) {
+		for (EntityIndex entity_index : cell) {
+			if (distance_squared(m_slots[entity_index].position, center) <= radius_squared && passes(entity_index, filter)) {
+				out_entities.push_back(m_ecs.get_entity_from_index(entity_index));
+			}
+		}
+	});
+}
+
+template <typename PositionComponent, typename PositionAccessor>
+void lecs::SpatialGrid<PositionComponent, PositionAccessor>::query_box(const SpatialPoint& min, const SpatialPoint& max, std::vector<Entity>& out_entities, EntityFilter filter) const {
+	visit_cells(to_cell_coordinates(min), to_cell_coordinates(max), [&](const Cell& cell) {
+		for (EntityIndex entity_index : cell) {
+			const SpatialPoint& position = m_slots[entity_index].position;
+			if (position.x >= min.x && position.x <= max.x &&
+				position.y >= min.y && position.y <= max.y &&
+				position.z >= min.z && position.z <= max.z && passes(entity_index, filter)) {
+				out_entities.push_back(m_ecs.get_entity_from_index(entity_index));
+			}
+		}
+	});
+}
+
+template <typename PositionComponent, typename PositionAccessor>
+void lecs::SpatialGrid<PositionComponent, PositionAccessor>::query_k_nearest(const SpatialPoint& center, int32_t k, std::vector<Entity>& out_entities, EntityFilter filter) const {
+	if (k <= 0 || m_entity_count == 0) {
+		return;
+	}
+
+	// Max-heap of the best candidates so far, the worst one on top.
+	using Candidate = std::pair<float, EntityIndex>;
+	std::priority_queue<Candidate> candidates;
+
+	// Visit shells of cells around the center one. An entity in shell (ring + 1) is at least ring * cell_size away,
+	// so once we have k candidates closer than that, no further shell can improve them.
+	const CellCoordinates center_cell = to_cell_coordinates(center);
+	for (int32_t ring = 0; ; ++ring) {
+		const CellCoordinates min = { center_cell.x - ring, center_cell.y - ring, center_cell.z - ring };
+		const CellCoordinates max = { center_cell.x + ring, center_cell.y + ring, center_cell.z + ring };
+
+		for (int32_t z = std::max(min.z, m_min_bounds.z); z <= std::min(max.z, m_max_bounds.z); ++z) {
+			for (int32_t y = std::max(min.y, m_min_bounds.y); y <= std::min(max.y, m_max_bounds.y); ++y) {
+				const bool on_shell_yz = z == min.z || z == max.z || y == min.y || y == max.y;
+				for (int32_t x = std::max(min.x, m_min_bounds.x); x <= std::min(max.x, m_max_bounds.x); ++x) {
+					if (!on_shell_yz && x != min.x && x != max.x) {
+						x = max.x - 1; // skip the inside of the shell, visited by the previous rings
+						continue;
+					}
+
+					const CellKey key = to_cell_key({ x, y, z });
+					const CellMap& cells = m_partitions[get_partition(key)];
+					auto found = cells.find(key);
+					if (found == cells.end()) {
+						continue;
+					}
+
+					for (EntityIndex entity_index : found->second) {
+						if (!passes(entity_index, filter)) {
+							continue;
+						}
+
+						const float distance = distance_squared(m_slots[entity_index].position, center);
+						if (static_cast<int32_t>(candidates.size()) < k) {
+							candidates.push({ distance, entity_index });
+						}
+						else if (distance < candidates.top().first) {
+							candidates.pop();
+							candidates.push({ distance, entity_index });
+						}
+					}
+				}
+			}
+		}
+
+		const float reach = static_cast<float>(ring) * m_cell_size;
+		const bool found_all = static_cast<int32_t>(candidates.size()) == k && candidates.top().first <= reach * reach;
+		const bool covered_bounds = min.x <= m_min_bounds.x && min.y <= m_min_bounds.y && min.z <= m_min_bounds.z &&
+			max.x >= m_max_bounds.x && max.y >= m_max_bounds.y && max.z >= m_max_bounds.z;
+		if (found_all || covered_bounds) {
+			break;
+		}
+	}
+
+	const size_t first = out_entities.size();
+	out_entities.resize(first + candidates.size());
+	for (size_t i = out_entities.size(); i > first; --i) {
+		out_entities[i - 1] = m_ecs.get_entity_from_index(candidates.top().second);
+		candidates.pop();
+	}
+}
+
+template <typename PositionComponent, typename PositionAccessor>
+void lecs::SpatialGrid<PositionComponent, PositionAccessor>::rebuild(JobPool* job_pool) {
+	auto& component_array = m_ecs.get_component_array<PositionComponent>();
+	const int32_t component_count = static_cast<int32_t>(component_array.get_size());
+
+	for (CellMap& cells : m_partitions) {
+		cells.clear();
+	}
+	m_slots.assign(static_cast<size_t>(m_ecs.get_entity_count()), Slot{});
+	m_cell_count = 0;
+	m_entity_count = component_count;
+	m_min_bounds = { 0, 0, 0 };
+	m_max_bounds = { -1, -1, -1 };
+
+	// Read the positions and compute the cells. Every batch writes distinct slots, and keeps its own bounds.
+	const int32_t batch_size = 4096;
+	const int32_t batch_count = (component_count + batch_size - 1) / batch_size;
+	std::vector<CellKey> keys(component_count);
+	std::vector<std::pair<CellCoordinates, CellCoordinates>> batch_bounds(batch_count);
+
+	auto compute_cells = [&](int32_t begin, int32_t end) {
+		CellCoordinates min = to_cell_coordinates(m_accessor(component_array.get_data_from_component_index(begin)));
+		CellCoordinates max = min;
+		for (int32_t i = begin; i < end; ++i) {
+			const SpatialPoint position = m_accessor(component_array.get_data_from_component_index(i));
+			const CellCoordinates coordinates = to_cell_coordinates(position);
+			min = { std::min(min.x, coordinates.x), std::min(min.y, coordinates.y), std::min(min.z, coordinates.z) };
+			max = { std::max(max.x, coordinates.x), std::max(max.y, coordinates.y), std::max(max.z, coordinates.z) };
+
+			keys[i] = to_cell_key(coordinates);
+			Slot& slot = m_slots[component_array.get_entity_index_from_component_index(i)];
+			slot.position = position;
+			slot.cell = keys[i];
+			slot.present = true;
+		}
+		batch_bounds[begin / batch_size] = { min, max };
+	};
+
+	// Each partition is filled by a single job, walking the keys in order so cells keep the order of the component array.
+	std::array<int32_t, PARTITION_COUNT> partition_cell_counts{};
+	auto fill_partitions = [&](int32_t begin, int32_t end) {
+		for (int32_t partition = begin; partition < end; ++partition) {
+			CellMap& cells = m_partitions[partition];
+			for (int32_t i = 0; i < component_count; ++i) {
+				if (get_partition(keys[i]) != partition) {
+					continue;
+				}
+
+				const EntityIndex entity_index = component_array.get_entity_index_from_component_index(i);
+				Cell& cell = cells[keys[i]];
+				m_slots[entity_index].index_in_cell = static_cast<uint32_t>(cell.size());
+				cell.push_back(entity_index);
+			}
+			partition_cell_counts[partition] = static_cast<int32_t>(cells.size());
+		}
+	};
+
+	if (job_pool) {
+		job_pool->parallel_for(component_count, batch_size, compute_cells);
+		job_pool->parallel_for(PARTITION_COUNT, 1, fill_partitions);
+	}
+	else {
+		for (int32_t begin = 0; begin < component_count; begin += batch_size) {
+			compute_cells(begin, std::min(begin + batch_size, component_count));
+		}
+		fill_partitions(0, PARTITION_COUNT);
+	}
+
+	for (int32_t partition_cell_count : partition_cell_counts) {
+		m_cell_count += partition_cell_count;
+	}
+	for (const auto& bounds : batch_bounds) {
+		grow_bounds(bounds.first);
+		grow_bounds(bounds.second);
+	}
+}
+
+template <typename PositionComponent, typename PositionAccessor>
+typename lecs::SpatialGrid<PositionComponent, PositionAccessor>::CellCoordinates
+lecs::SpatialGrid<PositionComponent, PositionAccessor>::to_cell_coordinates(const SpatialPoint& point) const {
+	return {
+		static_cast<int32_t>(std::floor(point.x * m_inverse_cell_size)),
+		static_cast<int32_t>(std::floor(point.y * m_inverse_cell_size)),
+		static_cast<int32_t>(std::floor(point.z * m_inverse_cell_size))
+	};
+}
+
+template <typename PositionComponent, typename PositionAccessor>
+typename lecs::SpatialGrid<PositionComponent, PositionAccessor>::CellKey
+lecs::SpatialGrid<PositionComponent, PositionAccessor>::to_cell_key(const CellCoordinates& coordinates) {
+	const CellKey x = static_cast<CellKey>(coordinates.x + CELL_COORDINATE_OFFSET) & CELL_COORDINATE_MASK;
+	const CellKey y = static_cast<CellKey>(coordinates.y + CELL_COORDINATE_OFFSET) & CELL_COORDINATE_MASK;
+	const CellKey z = static_cast<CellKey>(coordinates.z + CELL_COORDINATE_OFFSET) & CELL_COORDINATE_MASK;
+	return x | (y << CELL_COORDINATE_BITS) | (z << (2 * CELL_COORDINATE_BITS));
+}
+
+template <typename PositionComponent, typename PositionAccessor>
+typename lecs::SpatialGrid<PositionComponent, PositionAccessor>::CellCoordinates
+lecs::SpatialGrid<PositionComponent, PositionAccessor>::from_cell_key(CellKey key) {
+	return {
+		static_cast<int32_t>(key & CELL_COORDINATE_MASK) - CELL_COORDINATE_OFFSET,
+		static_cast<int32_t>((key >> CELL_COORDINATE_BITS) & CELL_COORDINATE_MASK) - CELL_COORDINATE_OFFSET,
+		static_cast<int32_t>((key >> (2 * CELL_COORDINATE_BITS)) & CELL_COORDINATE_MASK) - CELL_COORDINATE_OFFSET
+	};
+}
+
+template <typename PositionComponent, typename PositionAccessor>
+int32_t lecs::SpatialGrid<PositionComponent, PositionAccessor>::get_partition(CellKey key) {
+	// Fibonacci hashing, the top bits are well mixed.
+	return static_cast<int32_t>((key * 0x9E3779B97F4A7C15ull) >> 60);
+}
+
+template <typename PositionComponent, typename PositionAccessor>
+void lecs::SpatialGrid<PositionComponent, PositionAccessor>::insert(EntityIndex entity_index, const SpatialPoint& position) {
+	const CellCoordinates coordinates = to_cell_coordinates(position);
+	const CellKey key = to_cell_key(coordinates);
+
+	Cell& cell = m_partitions[get_partition(key)][key];
+	if (cell.empty()) {
+		m_cell_count++;
+	}
+
+	Slot& slot = get_slot(entity_index);
+	slot.position = position;
+	slot.cell = key;
+	slot.index_in_cell = static_cast<uint32_t>(cell.size());
+	slot.present = true;
+	cell.push_back(entity_index);
+
+	grow_bounds(coordinates);
+	m_entity_count++;
+}
+
+template <typename PositionComponent, typename PositionAccessor>
+void lecs::SpatialGrid<PositionComponent, PositionAccessor>::erase(EntityIndex entity_index) {
+	Slot& slot = get_slot(entity_index);
+	if (!slot.present) {
+		return;
+	}
+
+	// Swap and pop, like the component arrays do.
+	CellMap& cells = m_partitions[get_partition(slot.cell)];
+	auto found = cells.find(slot.cell);
+	Cell& cell = found->second;
+	const EntityIndex moved_entity_index = cell.back();
+	cell[slot.index_in_cell] = moved_entity_index;
+	m_slots[moved_entity_index].index_in_cell = slot.index_in_cell;
+	cell.pop_back();
+
+	if (cell.empty()) {
+		cells.erase(found);
+		m_cell_count--;
+	}
+
+	slot.present = false;
+	m_entity_count--;
+}
+
+template <typename PositionComponent, typename PositionAccessor>
+void lecs::SpatialGrid<PositionComponent, PositionAccessor>::grow_bounds(const CellCoordinates& coordinates) {
+	if (m_min_bounds.x > m_max_bounds.x) {
+		m_min_bounds = coordinates;
+		m_max_bounds = coordinates;
+		return;
+	}
+
+	m_min_bounds = { std::min(m_min_bounds.x, coordinates.x), std::min(m_min_bounds.y, coordinates.y), std::min(m_min_bounds.z, coordinates.z) };
+	m_max_bounds = { std::max(m_max_bounds.x, coordinates.x), std::max(m_max_bounds.y, coordinates.y), std::max(m_max_bounds.z, coordinates.z) };
+}
+
+template <typename PositionComponent, typename PositionAccessor>
+typename lecs::SpatialGrid<PositionComponent, PositionAccessor>::Slot&
+lecs::SpatialGrid<PositionComponent, PositionAccessor>::get_slot(EntityIndex entity_index) {
+	if (entity_index >= m_slots.size()) {
+		m_slots.resize(static_cast<size_t>(entity_index) + 1);
+	}
+
+	return m_slots[entity_index];
+}
+
+template <typename PositionComponent, typename PositionAccessor>
+template <typename Visitor>
+void lecs::SpatialGrid<PositionComponent, PositionAccessor>::visit_cells(CellCoordinates min, CellCoordinates max, Visitor&& visitor) const {
+	min = { std::max(min.x, m_min_bounds.x), std::max(min.y, m_min_bounds.y), std::max(min.z, m_min_bounds.z) };
+	max = { std::min(max.x, m_max_bounds.x), std::min(max.y, m_max_bounds.y), std::min(max.z, m_max_bounds.z) };
+	if (min.x > max.x || min.y > max.y || min.z > max.z) {
+		return;
+	}
+
+	const int64_t range_cell_count = int64_t(max.x - min.x + 1) * int64_t(max.y - min.y + 1) * int64_t(max.z - min.z + 1);
+	if (range_cell_count > m_cell_count) {
+		for (const CellMap& cells : m_partitions) {
+			for (const auto& key_and_cell : cells) {
+				const CellCoordinates coordinates = from_cell_key(key_and_cell.first);
+				if (coordinates.x >= min.x && coordinates.x <= max.x &&
+					coordinates.y >= min.y && coordinates.y <= max.y &&
+					coordinates.z >= min.z && coordinates.z <= max.z) {
+					visitor(key_and_cell.second);
+				}
+			}
+		}
+		return;
+	}
+
+	for (int32_t z = min.z; z <= max.z; ++z) {
+		for (int32_t y = min.y; y <= max.y; ++y) {
+			for (int32_t x = min.x; x <= max.x; ++x) {
+				const CellKey key = to_cell_key({ x, y, z });
+				const CellMap& cells = m_partitions[get_partition(key)];
+				auto found = cells.find(key);
+				if (found != cells.end()) {
+					visitor(found->second);
+				}
+			}
+		}
+	}
+}
+
+template <typename PositionComponent, typename PositionAccessor>
+float lecs::SpatialGrid<PositionComponent, PositionAccessor>::distance_squared(const SpatialPoint& a, const SpatialPoint& b) {
+	const float dx = a.x - b.x;
+	const float dy = a.y - b.y;
+	const float dz = a.z - b.z;
+	return dx * dx + dy * dy + dz * dz;
+}
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
@@ -0,0 +1,320 @@
+// LECS (Lightweight Entity Component System) world streaming implementation file
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+
+namespace lecs {
+	namespace detail {
+		static const uint32_t CELL_MAGIC = 0x4345434Cu; // "LECC"
+		static const uint32_t CELL_VERSION = 1;
+
+		// How many entities or components commit creates between two checks of the clock.
+		static const uint32_t CELL_COMMIT_CHECK_INTERVAL = 64;
+
+		inline void write_cell_u32(std::vector<uint8_t>& bytes, uint32_t value) {
+			const size_t offset = bytes.size();
+			bytes.resize(offset + sizeof(value));
+			std::memcpy(bytes.data() + offset, &value, sizeof(value));
+		}
+
+		inline bool read_cell_u32(const std::vector<uint8_t>& bytes, size_t& offset, uint32_t& out_value) {
+			if (bytes.size() - offset < sizeof(out_value)) {
+				return false;
+			}
+
+			std::memcpy(&out_value, bytes.data() + offset, sizeof(out_value));
+			offset += sizeof(out_value);
+			return true;
+		}
+	}
+}
+
+bool lecs::encode_cell(ECS& ecs, const ComponentRegistry& registry, const std::vector<Entity>& entities, std::vector<uint8_t>& out_bytes) {
+	out_bytes.clear();
+	for (Entity entity : entities) {
+		if (!ecs.is_entity_handle_active(entity)) {
+			return false;
+		}
+	}
+
+	uint32_t pool_count = 0;
+	for (const ComponentType& type : registry.get_types()) {
+		if (type.trivially_copyable) {
+			pool_count++;
+		}
+	}
+
+	detail::write_cell_u32(out_bytes, detail::CELL_MAGIC);
+	detail::write_cell_u32(out_bytes, detail::CELL_VERSION);
+	detail::write_cell_u32(out_bytes, static_cast<uint32_t>(entities.size()));
+	detail::write_cell_u32(out_bytes, pool_count);
+
+	std::vector<uint32_t> pool_entities;
+	for (const ComponentType& type : registry.get_types()) {
+		if (!type.trivially_copyable) {
+			continue;
+		}
+
+		pool_entities.clear();
+		for (size_t i = 0; i < entities.size(); ++i) {
+			if (type.get_component(ecs, entities[i]) != nullptr) {
+				pool_entities.push_back(static_cast<uint32_t>(i));
+			}
+		}
+
+		detail::write_cell_u32(out_bytes, type.key);
+		detail::write_cell_u32(out_bytes, type.size);
+		detail::write_cell_u32(out_bytes, static_cast<uint32_t>(pool_entities.size()));
+		for (uint32_t entity_in_cell : pool_entities) {
+			detail::write_cell_u32(out_bytes, entity_in_cell);
+		}
+
+		size_t offset = out_bytes.size();
+		out_bytes.resize(offset + pool_entities.size() * type.size);
+		for (uint32_t entity_in_cell : pool_entities) {
+			std::memcpy(out_bytes.data() + offset, type.get_component(ecs, entities[entity_in_cell]), type.size);
+			offset += type.size;
+		}
+	}
+
+	return true;
+}
+
+// CellStreamer
+lecs::CellStreamer::CellStreamer(const ComponentRegistry& registry, JobPool& job_pool)
+	: m_registry(registry), m_job_pool(job_pool) {
+}
+
+lecs::CellStreamer::~CellStreamer() {
+	m_job_pool.wait(m_loads_in_flight);
+}
+
+bool lecs::CellStreamer::request_load(CellID cell_id, const std::string& path) {
+	uint32_t request;
+	if (!begin_request(cell_id, request)) {
+		return false;
+	}
+
+	m_job_pool.submit([this, cell_id, request, path]() {
+		std::vector<uint8_t> bytes;
+		std::ifstream file(path, std::ios::binary);
+		if (file) {
+			bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		}
+		decode(cell_id, request, bytes);
+	}, &m_loads_in_flight);
+	return true;
+}
+
+bool lecs::CellStreamer::request_load(CellID cell_id, std::vector<uint8_t> bytes) {
+	uint32_t request;
+	if (!begin_request(cell_id, request)) {
+		return false;
+	}
+
+	// std::function needs a copyable job, so the bytes are shared with it instead of moved in.
+	auto shared_bytes = std::make_shared<std::vector<uint8_t>>(std::move(bytes));
+	m_job_pool.submit([this, cell_id, request, shared_bytes]() {
+		decode(cell_id, request, *shared_bytes);
+	}, &m_loads_in_flight);
+	return true;
+}
+
+bool lecs::CellStreamer::commit(ECS& ecs, std::chrono::microseconds budget) {
+	const auto deadline = std::chrono::steady_clock::now() + budget;
+	uint32_t operations = 0;
+	auto is_out_of_time = [&]() {
+		return ++operations % detail::CELL_COMMIT_CHECK_INTERVAL == 0 && std::chrono::steady_clock::now() >= deadline;
+	};
+
+	while (m_is_committing || take_next_staged_cell()) {
+		Cell& cell = m_cells[m_committing.cell_id];
+
+		while (cell.entities.size() < m_committing.entity_count) {
+			cell.entities.push_back(ecs.create_entity());
+			if (is_out_of_time()) {
+				return false;
+			}
+		}
+
+		for (; m_commit_pool < m_committing.pools.size(); ++m_commit_pool) {
+			const StagedPool& pool = m_committing.pools[m_commit_pool];
+			for (; m_commit_component < pool.entities.size(); ++m_commit_component) {
+				const Entity entity = cell.entities[pool.entities[m_commit_component]];
+				pool.type->add_component_from_bytes(ecs, entity, pool.data.data() + m_commit_component * pool.type->size);
+				if (is_out_of_time()) {
+					++m_commit_component;
+					return false;
+				}
+			}
+			m_commit_component = 0;
+		}
+
+		cell.state = CellState::Loaded;
+		m_committing = StagedCell{};
+		m_is_committing = false;
+	}
+
+	return true;
+}
+
+bool lecs::CellStreamer::unload(ECS& ecs, CellID cell_id) {
+	auto it = m_cells.find(cell_id);
+	if (it == m_cells.end() || it->second.state == CellState::Unloaded) {
+		return false;
+	}
+
+	Cell& cell = it->second;
+	if (m_is_committing && m_committing.cell_id == cell_id) {
+		m_committing = StagedCell{};
+		m_is_committing = false;
+	}
+
+	ecs.remove_entities(cell.entities);
+
+	// A load still in flight is recognized as stale by its request number and dropped.
+	cell.entities.clear();
+	cell.state = CellState::Unloaded;
+	return true;
+}
+
+lecs::CellState lecs::CellStreamer::get_state(CellID cell_id) const {
+	auto it = m_cells.find(cell_id);
+	return it != m_cells.end() ? it->second.state : CellState::Unloaded;
+}
+
+const std::vector<lecs::Entity>* lecs::CellStreamer::get_entities(CellID cell_id) const {
+	auto it = m_cells.find(cell_id);
+	return it != m_cells.end() ? &it->second.entities : nullptr;
+}
+
+void lecs::CellStreamer::decode(CellID cell_id, uint32_t request, const std::vector<uint8_t>& bytes) {
+	StagedCell staged_cell;
+	staged_cell.cell_id = cell_id;
+	staged_cell.request = request;
+	staged_cell.valid = decode_into(bytes, staged_cell);
+	if (!staged_cell.valid) {
+		staged_cell.pools.clear();
+	}
+
+	std::lock_guard<std::mutex> lock(m_staged_mutex);
+	m_staged_cells.push_back(std::move(staged_cell));
+}
+
+bool lecs::CellStreamer::decode_into(const std::vector<uint8_t>& bytes, StagedCell& staged_cell) const {
+	size_t offset = 0;
+	uint32_t magic, version, pool_count;
+	if (!detail::read_cell_u32(bytes, offset, magic) || magic != detail::CELL_MAGIC ||
+		!detail::read_cell_u32(bytes, offset, version) || version != detail::CELL_VERSION ||
+		!detail::read_cell_u32(bytes, offset, staged_cell.entity_count) ||
+		!detail::read_cell_u32(bytes, offset, pool_count) ||
+		staged_cell.entity_count > static_cast<uint32_t>(MAX_ENTITIES)) {
+		return false;
+	}
+
+	for (uint32_t i = 0; i < pool_count; ++i) {
+		uint32_t key, size, count;
+		if (!detail::read_cell_u32(bytes, offset, key) ||
+			!detail::read_cell_u32(bytes, offset, size) ||
+			!detail::read_cell_u32(bytes, offset, count)) {
+			return false;
+		}
+
+		// Checked before anything is allocated, so a corrupted count can't ask for gigabytes.
+		const uint64_t pool_bytes = static_cast<uint64_t>(count) * (sizeof(uint32_t) + size);
+		if (pool_bytes > bytes.size() - offset) {
+			return false;
+		}
+
+		StagedPool pool;
+		pool.type = m_registry.find_by_key(key);
+		pool.entities.resize(count);
+		for (uint32_t& entity_in_cell : pool.entities) {
+			detail::read_cell_u32(bytes, offset, entity_in_cell);
+			if (entity_in_cell >= staged_cell.entity_count) {
+				return false;
+			}
+		}
+
+		// Pools of components this build doesn't know (or whose layout changed) are skipped.
+		if (pool.type != nullptr && pool.type->trivially_copyable && pool.type->size == size) {
+			pool.data.assign(bytes.begin() + offset, bytes.begin() + offset + static_cast<size_t>(count) * size);
+			staged_cell.pools.push_back(std::move(pool));
+		}
+		offset += static_cast<size_t>(count) * size;
+	}
+
+	return true;
+}
+
+bool lecs::CellStreamer::begin_request(CellID cell_id, uint32_t& out_request) {
+	Cell& cell = m_cells[cell_id];
+	if (cell.state != CellState::Unloaded && cell.state != CellState::Failed) {
+		return false;
+	}
+
+	cell.state = CellState::Loading;
+	cell.request = ++m_request_counter;
+	cell.entities.clear();
+	out_request = cell.request;
+	return true;
+}
+
+bool lecs::CellStreamer::take_next_staged_cell() {
+	while (true) {
+		{
+			std::lock_guard<std::mutex> lock(m_staged_mutex);
+			if (m_staged_cells.empty()) {
+				return false;
+			}
+
+			m_committing = std::move(m_staged_cells.front());
+			m_staged_cells.pop_front();
+		}
+
+		Cell& cell = m_cells[m_committing.cell_id];
+		if (cell.state != CellState::Loading || cell.request != m_committing.request) {
+			continue;
+		}
+
+		if (!m_committing.valid) {
+			cell.state = CellState::Failed;
+			continue;
+		}
+
+		cell.state = CellState::Committing;
+		m_is_committing = true;
+		m_commit_pool = 0;
+		m_commit_component = 0;
+		return true;
+	}
+}
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
@@ -0,0 +1,165 @@
+// LECS (Lightweight Entity Component System) world streaming
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+// USAGE:
+// This is optional. It uses the ComponentRegistry and the JobPool, include lecs_streaming.hpp, lecs_registry.hpp and lecs_jobs.hpp
+// in the same .cpp where you #define LECS_IMPLEMENTATION.
+//
+// A cell is a group of entities (eg. a region of an open world) saved together, with their components:
+// std::vector<uint8_t> bytes;
+// lecs::encode_cell(my_ecs, registry, cell_entities, bytes); // then write the bytes to a file
+//
+// A CellStreamer reads and decodes cells on the threads of a job pool. The main thread then moves them in the ECS
+// in small steps, spending at most the time budget you give it each frame:
+// lecs::CellStreamer streamer(registry, job_pool);
+// streamer.request_load(42, "cells/42.cell");
+// ...
+// streamer.commit(my_ecs, std::chrono::microseconds(1000)); // once per frame
+// ...
+// streamer.unload(my_ecs, 42); // removes all the entities of the cell
+//
+// Only trivially copyable components registered in the registry are saved in cells, the others are skipped.
+// The format uses the native byte order, cells are meant to be loaded on the platform that wrote them.
+
+#pragma once
+
+#include "lecs.hpp"
+#include "lecs_jobs.hpp"
+#include "lecs_registry.hpp"
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lecs {
+	using CellID = uint32_t;
+
+	enum class CellState {
+		Unloaded,
+		// Being read and decoded in the background.
+		Loading,
+		// Decoded, its entities are being created by commit.
+		Committing,
+		Loaded,
+		// The data could not be read or is not a valid cell.
+		Failed
+	};
+
+	// Cell format (native byte order):
+	// uint32 magic, uint32 version, uint32 entity count, uint32 pool count
+	// then for each pool:
+	// uint32 component key, uint32 component size, uint32 component count,
+	// uint32 entity (position in the cell) of each component, the bytes of each component.
+	// Returns false if an entity is not active.
+	bool encode_cell(ECS& ecs, const ComponentRegistry& registry, const std::vector<Entity>& entities, std::vector<uint8_t>& out_bytes);
+
+	class CellStreamer {
+	public:
+		CellStreamer(const ComponentRegistry& registry, JobPool& job_pool);
+
+		// Waits for the loads still running in the background.
+		~CellStreamer();
+
+		CellStreamer(const CellStreamer&) = delete;
+		CellStreamer& operator=(const CellStreamer&) = delete;
+
+		// Reads and decodes the file in the background. Returns false if the cell is not unloaded.
+		bool request_load(CellID cell_id, const std::string& path);
+
+		// The bytes are only decoded in the background. Returns false if the cell is not unloaded.
+		bool request_load(CellID cell_id, std::vector<uint8_t> bytes);
+
+		// Moves decoded cells in the ECS until the budget is spent, continuing from where the previous call stopped.
+		// Returns true if there is nothing left to commit.
+		bool commit(ECS& ecs, std::chrono::microseconds budget);
+
+		// Removes all the entities of the cell. A cell that is still loading is dropped when it's ready.
+		// Returns false if the cell is not loading nor loaded.
+		bool unload(ECS& ecs, CellID cell_id);
+
+		CellState get_state(CellID cell_id) const;
+
+		// The entities created so far for the cell, or nullptr if it's unknown.
+		const std::vector<Entity>* get_entities(CellID cell_id) const;
+
+	private:
+		struct StagedPool {
+			const ComponentType* type;
+			std::vector<uint32_t> entities;
+			std::vector<uint8_t> data;
+		};
+
+		struct StagedCell {
+			CellID cell_id{ 0 };
+			// Increases every time a load is requested, so a stale load of an unloaded cell is recognized.
+			uint32_t request{ 0 };
+			bool valid{ false };
+			uint32_t entity_count{ 0 };
+			std::vector<StagedPool> pools;
+		};
+
+		struct Cell {
+			CellState state{ CellState::Unloaded };
+			uint32_t request{ 0 };
+			std::vector<Entity> entities;
+		};
+
+		// Runs on the job pool.
+		void decode(CellID cell_id, uint32_t request, const std::vector<uint8_t>& bytes);
+		bool decode_into(const std::vector<uint8_t>& bytes, StagedCell& staged_cell) const;
+
+		// Main thread only.
+		bool begin_request(CellID cell_id, uint32_t& out_request);
+		bool take_next_staged_cell();
+
+		const ComponentRegistry& m_registry;
+		JobPool& m_job_pool;
+		JobCounter m_loads_in_flight;
+
+		// Written by the jobs, read by commit.
+		std::mutex m_staged_mutex;
+		std::deque<StagedCell> m_staged_cells;
+
+		// Main thread only.
+		std::unordered_map<CellID, Cell> m_cells;
+		uint32_t m_request_counter{ 0 };
+
+		// Progress of the cell being committed.
+		StagedCell m_committing;
+		bool m_is_committing{ false };
+		size_t m_commit_pool{ 0 };
+		size_t m_commit_component{ 0 };
+	};
+}
+
+#if defined(LECS_IMPLEMENTATION)
+#include "lecs_streaming.cpp"
+#endif // defined(LECS_IMPLEMENTATION)
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
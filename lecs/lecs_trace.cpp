@@ -0,0 +1,371 @@
+// LECS (Lightweight Entity Component System) operation traces implementation file
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace lecs {
+	namespace detail {
+		static const uint32_t TRACE_MAGIC = 0x5443454Cu; // "LECT"
+		static const uint32_t TRACE_VERSION = 1;
+		static const size_t TRACE_HEADER_SIZE = 2 * sizeof(uint32_t);
+
+		inline void write_trace_varint(std::vector<uint8_t>& bytes, uint64_t value) {
+			while (value >= 0x80) {
+				bytes.push_back(static_cast<uint8_t>(value | 0x80));
+				value >>= 7;
+			}
+			bytes.push_back(static_cast<uint8_t>(value));
+		}
+
+		inline bool read_trace_varint(const std::vector<uint8_t>& bytes, size_t& offset, uint64_t& out_value) {
+			out_value = 0;
+			for (uint32_t shift = 0; shift < 64; shift += 7) {
+				if (offset >= bytes.size()) {
+					return false;
+				}
+
+				const uint8_t byte = bytes[offset++];
+				out_value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+				if ((byte & 0x80) == 0) {
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		struct TraceStep {
+			TraceOperation operation;
+			// Of the component operations.
+			const ComponentType* type;
+			// Index in the masks of the queries.
+			uint32_t query;
+			uint64_t entity;
+			// Of the sliced queries.
+			EntityIndex first_index;
+			EntityIndex index_count;
+		};
+	}
+}
+
+bool lecs::load_trace(const std::string& path, std::vector<uint8_t>& out_trace) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+
+	out_trace.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+bool lecs::replay_trace(const std::vector<uint8_t>& trace, const ComponentRegistry& registry, ECS& ecs, TraceReport& out_report) {
+	out_report = TraceReport{};
+
+	uint32_t magic, version;
+	if (trace.size() < detail::TRACE_HEADER_SIZE) {
+		return false;
+	}
+	std::memcpy(&magic, trace.data(), sizeof(magic));
+	std::memcpy(&version, trace.data() + sizeof(magic), sizeof(version));
+	if (magic != detail::TRACE_MAGIC || version != detail::TRACE_VERSION) {
+		return false;
+	}
+
+	// Decode all of it first, so the timings are only the operations.
+	std::vector<detail::TraceStep> steps;
+	std::vector<ComponentMask> queries;
+	uint64_t entity_count = 0;
+	size_t offset = detail::TRACE_HEADER_SIZE;
+	while (offset < trace.size()) {
+		detail::TraceStep step{ static_cast<TraceOperation>(trace[offset++]), nullptr, 0, 0, 0, 0 };
+		uint64_t key, count, first_index, index_count;
+		switch (step.operation) {
+		case TraceOperation::CreateEntity:
+			step.entity = entity_count++;
+			break;
+
+		case TraceOperation::RemoveEntity:
+			if (!detail::read_trace_varint(trace, offset, step.entity) || step.entity >= entity_count) {
+				return false;
+			}
+			break;
+
+		case TraceOperation::AddComponent:
+		case TraceOperation::RemoveComponent:
+			if (!detail::read_trace_varint(trace, offset, key) || key > UINT32_MAX ||
+				!detail::read_trace_varint(trace, offset, step.entity) || step.entity >= entity_count) {
+				return false;
+			}
+
+			step.type = registry.find_by_key(static_cast<uint32_t>(key));
+			if (step.type == nullptr) {
+				return false;
+			}
+			break;
+
+		case TraceOperation::Query:
+		case TraceOperation::SlicedQuery:
+			if (!detail::read_trace_varint(trace, offset, count) || count > static_cast<uint64_t>(MAX_COMPONENTS)) {
+				return false;
+			}
+
+			queries.emplace_back();
+			for (uint64_t i = 0; i < count; ++i) {
+				const ComponentType* type = nullptr;
+				if (!detail::read_trace_varint(trace, offset, key) || key > UINT32_MAX ||
+					(type = registry.find_by_key(static_cast<uint32_t>(key))) == nullptr) {
+					return false;
+				}
+				queries.back().set(type->component_id, true);
+			}
+			step.query = static_cast<uint32_t>(queries.size() - 1);
+
+			if (step.operation == TraceOperation::SlicedQuery) {
+				if (!detail::read_trace_varint(trace, offset, first_index) || first_index > static_cast<uint64_t>(MAX_ENTITIES) ||
+					!detail::read_trace_varint(trace, offset, index_count) || index_count > static_cast<uint64_t>(MAX_ENTITIES)) {
+					return false;
+				}
+				step.first_index = static_cast<EntityIndex>(first_index);
+				step.index_count = static_cast<EntityIndex>(index_count);
+			}
+			break;
+
+		default:
+			return false;
+		}
+
+		steps.push_back(step);
+	}
+
+	std::vector<Entity> entities;
+	entities.reserve(static_cast<size_t>(entity_count));
+
+	// Runs of the same operation are timed together.
+	TraceOperation run_operation = TraceOperation::Count;
+	auto run_start = std::chrono::steady_clock::now();
+	auto end_run = [&]() {
+		const auto now = std::chrono::steady_clock::now();
+		if (run_operation != TraceOperation::Count) {
+			out_report.timings[static_cast<size_t>(run_operation)].total_time += std::chrono::duration_cast<std::chrono::nanoseconds>(now - run_start);
+		}
+		run_start = now;
+	};
+
+	// Visits the entities like EntityIterator, without knowing the component types at compile time.
+	auto visit = [&](EntityIndex entity_index, const ComponentMask& mask) {
+		if (ecs.get_entity_from_index(entity_index).is_valid() && ecs.is_entity_enabled_from_index(entity_index) &&
+			(ecs.get_component_mask_from_index(entity_index) & mask) == mask) {
+			out_report.visited_entities++;
+		}
+	};
+
+	for (const detail::TraceStep& step : steps) {
+		if (step.operation != run_operation) {
+			end_run();
+			run_operation = step.operation;
+		}
+		out_report.timings[static_cast<size_t>(step.operation)].count++;
+
+		switch (step.operation) {
+		case TraceOperation::CreateEntity:
+			entities.push_back(ecs.create_entity());
+			break;
+
+		case TraceOperation::RemoveEntity:
+			ecs.remove_entity(entities[step.entity]);
+			break;
+
+		case TraceOperation::AddComponent:
+			step.type->add_component(ecs, entities[step.entity]);
+			break;
+
+		case TraceOperation::RemoveComponent:
+			step.type->remove_component(ecs, entities[step.entity]);
+			break;
+
+		case TraceOperation::Query: {
+			const EntityIndex count = static_cast<EntityIndex>(ecs.get_entity_count());
+			for (EntityIndex entity_index = 0; entity_index < count; ++entity_index) {
+				visit(entity_index, queries[step.query]);
+			}
+			break;
+		}
+
+		case TraceOperation::SlicedQuery: {
+			// The same indices as the recorded run, going back to 0 at the end of the table like its cursor.
+			const EntityIndex count = static_cast<EntityIndex>(ecs.get_entity_count());
+			EntityIndex cursor = step.first_index;
+			for (EntityIndex scanned = 0; scanned < step.index_count && scanned < count; ++scanned) {
+				if (cursor >= count) {
+					cursor = 0;
+				}
+				visit(cursor++, queries[step.query]);
+			}
+			break;
+		}
+
+		default:
+			break;
+		}
+	}
+	end_run();
+
+	return true;
+}
+
+#if defined(LECS_TRACE)
+// TraceRecorder
+lecs::TraceRecorder::~TraceRecorder() {
+	stop();
+}
+
+void lecs::TraceRecorder::start(ECS& ecs) {
+	stop();
+
+	m_trace.clear();
+	m_trace.resize(detail::TRACE_HEADER_SIZE);
+	std::memcpy(m_trace.data(), &detail::TRACE_MAGIC, sizeof(detail::TRACE_MAGIC));
+	std::memcpy(m_trace.data() + sizeof(detail::TRACE_MAGIC), &detail::TRACE_VERSION, sizeof(detail::TRACE_VERSION));
+
+	m_trace_entities.clear();
+	m_next_trace_entity = 0;
+	m_operation_count = 0;
+	m_skipped_count = 0;
+
+	m_ecs = &ecs;
+	m_ecs->set_operation_recorder(this);
+}
+
+void lecs::TraceRecorder::stop() {
+	if (m_ecs != nullptr && m_ecs->get_operation_recorder() == this) {
+		m_ecs->set_operation_recorder(nullptr);
+	}
+	m_ecs = nullptr;
+}
+
+bool lecs::TraceRecorder::save(const std::string& path) const {
+	std::ofstream file(path, std::ios::binary);
+	file.write(reinterpret_cast<const char*>(m_trace.data()), static_cast<std::streamsize>(m_trace.size()));
+	return static_cast<bool>(file);
+}
+
+void lecs::TraceRecorder::on_entity_created(Entity entity) {
+	if (!entity.is_valid()) {
+		return;
+	}
+
+	m_trace.push_back(static_cast<uint8_t>(TraceOperation::CreateEntity));
+	m_trace_entities[entity.id] = m_next_trace_entity++;
+	m_operation_count++;
+}
+
+void lecs::TraceRecorder::on_entity_removed(Entity entity) {
+	const uint64_t trace_entity = get_trace_entity(entity);
+	m_trace.push_back(static_cast<uint8_t>(TraceOperation::RemoveEntity));
+	detail::write_trace_varint(m_trace, trace_entity);
+	m_trace_entities.erase(entity.id);
+	m_operation_count++;
+}
+
+void lecs::TraceRecorder::on_component_added(ComponentID::IDType component_id, Entity entity) {
+	write_component_operation(TraceOperation::AddComponent, component_id, entity);
+}
+
+void lecs::TraceRecorder::on_component_removed(ComponentID::IDType component_id, Entity entity) {
+	write_component_operation(TraceOperation::RemoveComponent, component_id, entity);
+}
+
+void lecs::TraceRecorder::on_query(const ComponentMask& mask) {
+	if (write_query(TraceOperation::Query, mask)) {
+		m_operation_count++;
+	}
+}
+
+void lecs::TraceRecorder::on_sliced_query(const ComponentMask& mask, EntityIndex first_index, EntityIndex index_count) {
+	if (write_query(TraceOperation::SlicedQuery, mask)) {
+		detail::write_trace_varint(m_trace, first_index);
+		detail::write_trace_varint(m_trace, index_count);
+		m_operation_count++;
+	}
+}
+
+bool lecs::TraceRecorder::write_query(TraceOperation operation, const ComponentMask& mask) {
+	// The query is recorded only if all of its components can be replayed.
+	uint64_t count = 0;
+	for (ComponentID::IDType component_id = 0; component_id < MAX_COMPONENTS; ++component_id) {
+		if (!mask.test(component_id)) {
+			continue;
+		}
+
+		if (m_registry.find_by_component_id(component_id) == nullptr) {
+			m_skipped_count++;
+			return false;
+		}
+		count++;
+	}
+
+	m_trace.push_back(static_cast<uint8_t>(operation));
+	detail::write_trace_varint(m_trace, count);
+	for (ComponentID::IDType component_id = 0; component_id < MAX_COMPONENTS; ++component_id) {
+		if (mask.test(component_id)) {
+			detail::write_trace_varint(m_trace, m_registry.find_by_component_id(component_id)->key);
+		}
+	}
+	return true;
+}
+
+uint64_t lecs::TraceRecorder::get_trace_entity(Entity entity) {
+	auto it = m_trace_entities.find(entity.id);
+	if (it != m_trace_entities.end()) {
+		return it->second;
+	}
+
+	// The entity existed before the recording started.
+	m_trace.push_back(static_cast<uint8_t>(TraceOperation::CreateEntity));
+	m_operation_count++;
+	m_trace_entities.emplace(entity.id, m_next_trace_entity);
+	return m_next_trace_entity++;
+}
+
+void lecs::TraceRecorder::write_component_operation(TraceOperation operation, ComponentID::IDType component_id, Entity entity) {
+	const ComponentType* type = m_registry.find_by_component_id(component_id);
+	if (type == nullptr) {
+		m_skipped_count++;
+		return;
+	}
+
+	const uint64_t trace_entity = get_trace_entity(entity);
+	m_trace.push_back(static_cast<uint8_t>(operation));
+	detail::write_trace_varint(m_trace, type->key);
+	detail::write_trace_varint(m_trace, trace_entity);
+	m_operation_count++;
+}
+#endif // defined(LECS_TRACE)
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
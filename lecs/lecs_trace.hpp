@@ -0,0 +1,143 @@
+// LECS (Lightweight Entity Component System) operation traces
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+// USAGE:
+// This is optional. It uses the ComponentRegistry, include lecs_trace.hpp and lecs_registry.hpp in the same .cpp
+// where you #define LECS_IMPLEMENTATION.
+//
+// A trace is the list of the structural operations (create, remove, add and remove component) and of the queries
+// that ran on an ECS, eg. during a real play session. Recording needs LECS_TRACE to be defined (everywhere):
+// lecs::TraceRecorder recorder(registry);
+// recorder.start(my_ecs);
+// ... play ...
+// recorder.stop();
+// recorder.save("session.lecstrace");
+//
+// Replaying doesn't need LECS_TRACE, so the same trace can be run on any build (eg. another storage strategy) and compared:
+// lecs::TraceReport report;
+// lecs::replay_trace(trace, registry, empty_ecs, report);
+// report.get(lecs::TraceOperation::AddComponent).total_time;
+//
+// Components are written by the key they were registered with, not by ComponentID, so the build replaying the trace
+// only needs to register the same keys. Operations on components that are not registered are not recorded.
+// Component values are not recorded: replayed components are default initialized, and queries only visit the entities.
+// Entities moved in or out with move_entities are recorded as created (with their components) or removed.
+// A TimeSlicedQuery run is replayed on the same entity indices, so it visits the same entities if the ECS replaying the
+// trace has its entities at the same indices, eg. it is empty and the recording started with an empty ECS.
+
+#pragma once
+
+#include "lecs.hpp"
+#include "lecs_registry.hpp"
+
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace lecs {
+	enum class TraceOperation : uint8_t {
+		CreateEntity,
+		RemoveEntity,
+		AddComponent,
+		RemoveComponent,
+		Query,
+		SlicedQuery,
+		Count
+	};
+
+	struct TraceReport {
+		struct Timing {
+			uint64_t count{ 0 };
+			std::chrono::nanoseconds total_time{ 0 };
+		};
+
+		Timing timings[static_cast<size_t>(TraceOperation::Count)];
+		// Entities visited by the queries.
+		uint64_t visited_entities{ 0 };
+
+		const Timing& get(TraceOperation operation) const { return timings[static_cast<size_t>(operation)]; }
+	};
+
+	// Loads a trace saved by TraceRecorder::save. Returns false if the file could not be read.
+	bool load_trace(const std::string& path, std::vector<uint8_t>& out_trace);
+
+	// Runs the operations of the trace on the ECS, and times them by kind.
+	// The trace is decoded before anything runs, and consecutive operations of the same kind are timed together, so the
+	// report doesn't include the decoding nor (much of) the clock. Returns false, running nothing, if the trace is malformed
+	// or uses a component key that is not registered.
+	bool replay_trace(const std::vector<uint8_t>& trace, const ComponentRegistry& registry, ECS& ecs, TraceReport& out_report);
+
+#if defined(LECS_TRACE)
+	class TraceRecorder : public IOperationRecorder {
+	public:
+		explicit TraceRecorder(const ComponentRegistry& registry) : m_registry(registry) {}
+		~TraceRecorder();
+
+		TraceRecorder(const TraceRecorder&) = delete;
+		TraceRecorder& operator=(const TraceRecorder&) = delete;
+
+		// Starts a new trace. Entities that already exist are created in the trace the first time they are used.
+		void start(ECS& ecs);
+		void stop();
+
+		const std::vector<uint8_t>& get_trace() const { return m_trace; }
+		uint64_t get_operation_count() const { return m_operation_count; }
+		// Operations on components that are not registered.
+		uint64_t get_skipped_count() const { return m_skipped_count; }
+
+		bool save(const std::string& path) const;
+
+		void on_entity_created(Entity entity) override;
+		void on_entity_removed(Entity entity) override;
+		void on_component_added(ComponentID::IDType component_id, Entity entity) override;
+		void on_component_removed(ComponentID::IDType component_id, Entity entity) override;
+		void on_query(const ComponentMask& mask) override;
+		void on_sliced_query(const ComponentMask& mask, EntityIndex first_index, EntityIndex index_count) override;
+
+	private:
+		// Entities are numbered in the order the trace creates them.
+		uint64_t get_trace_entity(Entity entity);
+		void write_component_operation(TraceOperation operation, ComponentID::IDType component_id, Entity entity);
+		// Returns false, writing nothing, if a component of the query is not registered.
+		bool write_query(TraceOperation operation, const ComponentMask& mask);
+
+		const ComponentRegistry& m_registry;
+		ECS* m_ecs{ nullptr };
+		std::vector<uint8_t> m_trace;
+		std::unordered_map<Entity::IDType, uint64_t> m_trace_entities;
+		uint64_t m_next_trace_entity{ 0 };
+		uint64_t m_operation_count{ 0 };
+		uint64_t m_skipped_count{ 0 };
+	};
+#endif // defined(LECS_TRACE)
+}
+
+#if defined(LECS_IMPLEMENTATION)
+#include "lecs_trace.cpp"
+#endif // defined(LECS_IMPLEMENTATION)
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.
@@ -1,10 +1,32 @@
+#include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <thread>
 
 constexpr size_t _10M = 10'000'000L;
 #define LECS_MAX_ENTITIES _10M
+#define LECS_STATS
+#define LECS_TRACE
 #define LECS_IMPLEMENTATION
 #include "lecs/lecs.hpp"
+#include "lecs/lecs_checksum.hpp"
+#include "lecs/lecs_coroutines.hpp"
+#include "lecs/lecs_index.hpp"
+#include "lecs/lecs_inspector.hpp"
+#include "lecs/lecs_jobs.hpp"
+#include "lecs/lecs_registry.hpp"
+#include "lecs/lecs_replication.hpp"
+#include "lecs/lecs_scheduler.hpp"
+#include "lecs/lecs_shards.hpp"
+#include "lecs/lecs_shared_pools.hpp"
+#include "lecs/lecs_shared_memory.hpp"
+#include "lecs/lecs_snapshot.hpp"
+#include "lecs/lecs_spatial.hpp"
+#include "lecs/lecs_trace.hpp"
+#include "lecs/lecs_streaming.hpp"
 
 struct TransformComponent {
 	float position[3];
@@ -39,6 +61,28 @@ struct VelocityComponent {
 	float velocity[3];
 };
 
+struct ParentComponent {
+	lecs::Entity parent;
+};
+
+struct PositionComponent {
+	float x;
+	float y;
+	float z;
+};
+
+template <>
+struct lecs::SpatialPositionOf<PositionComponent> {
+	lecs::SpatialPoint operator()(const PositionComponent& position) const {
+		return { position.x, position.y, position.z };
+	}
+};
+
+struct NetworkIdComponent {
+	uint32_t value;
+	int32_t score;
+};
+
 #define PRINT_ENTITY(e) std::cout << #e << ": { " << e.get_index() << " | " << e.get_generation() << " }" << std::endl;
 void test_system_update(lecs::ECS& ecs) {
 	for (auto e : lecs::EntityIterator<TransformComponent, VelocityComponent>(ecs)) {
@@ -102,6 +146,1355 @@ std::unique_ptr<lecs::ECS> test_entity_creation_times(std::unique_ptr<lecs::ECS>
 	return std::move(ecs);
 }
 
+void test_time_sliced_query() {
+	std::unique_ptr<lecs::ECS> ecs = std::make_unique<lecs::ECS>();
+	std::vector<lecs::Entity> entities;
+	for (int i = 0; i < 100; i++) {
+		entities.push_back(ecs->create_entity());
+		ecs->add_component_to_entity<VelocityComponent>(entities.back());
+	}
+
+	std::vector<int> visits(entities.size() + 10, 0);
+	lecs::TimeSlicedQuery<VelocityComponent> query;
+	for (int frame = 0; frame < 11; frame++) {
+		query.run(*ecs, 10, [&](lecs::Entity e) { visits[e.get_index()]++; });
+
+		// Churn between frames, the cursor must not skip anything because of it.
+		if (frame == 3) {
+			ecs->remove_entity(entities[50]);
+			lecs::Entity e = ecs->create_entity();
+			ecs->add_component_to_entity<VelocityComponent>(e);
+		}
+	}
+
+	bool all_visited = true;
+	for (int i = 0; i < 100; i++) {
+		all_visited = all_visited && visits[i] > 0;
+	}
+	std::cout << "test_time_sliced_query visited every entity: " << (all_visited ? "true" : "false") << ", sweeps: " << query.get_sweep_count() << std::endl;
+}
+void test_system_groups() {
+	std::unique_ptr<lecs::ECS> ecs = std::make_unique<lecs::ECS>();
+	lecs::Scheduler scheduler;
+
+	int32_t ai_tick_frames[2] = { -1, -1 };
+	int32_t frame = 0;
+	lecs::SystemGroup& physics = scheduler.add_group("physics", 120.0f);
+	physics.add_system("noop", [](lecs::ECS&, float) {});
+	lecs::SystemGroup& gameplay = scheduler.add_group("gameplay", 30.0f);
+	gameplay.add_system("noop", [](lecs::ECS&, float) {});
+	lecs::SystemGroup& ai_a = scheduler.add_group("ai_a", 5.0f);
+	ai_a.add_system("record", [&](lecs::ECS&, float) { ai_tick_frames[0] = frame; });
+	lecs::SystemGroup& ai_b = scheduler.add_group("ai_b", 5.0f);
+	ai_b.add_system("record", [&](lecs::ECS&, float) { ai_tick_frames[1] = frame; });
+	scheduler.distribute_phase_offsets();
+
+	for (frame = 0; frame < 60; frame++) {
+		scheduler.update(*ecs, 1.0f / 60.0f);
+	}
+	std::cout << "test_system_groups ticks in one second: physics " << physics.get_tick_count() << ", gameplay " << gameplay.get_tick_count()
+		<< ", ai " << ai_a.get_tick_count() << "/" << ai_b.get_tick_count() << ", ai groups on different frames: " << (ai_tick_frames[0] != ai_tick_frames[1] ? "true" : "false") << std::endl;
+
+	// A long hitch must not run more than max_steps_per_update steps.
+	const int32_t steps = physics.update(*ecs, 0.5f);
+	std::cout << "test_system_groups steps after hitch: " << steps << ", dropped: " << physics.get_dropped_step_count() << std::endl;
+}
+void test_frame_profiler() {
+	std::unique_ptr<lecs::ECS> ecs = std::make_unique<lecs::ECS>();
+	lecs::JobPool job_pool(2);
+	lecs::FrameProfiler profiler;
+	lecs::Scheduler scheduler;
+	scheduler.set_job_pool(&job_pool);
+	scheduler.set_profiler(&profiler);
+
+	auto sleep_for_ms = [](int32_t ms) {
+		return [ms](lecs::ECS&, float) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); };
+	};
+	lecs::SystemGroup& group = scheduler.add_group("gameplay", 0.0f);
+	group.add_system("short", sleep_for_ms(1), {});
+	group.add_system("long", sleep_for_ms(4), {});
+	group.add_system("apply", sleep_for_ms(1), { "short", "long" });
+	const bool missing_dependency_rejected = !group.add_system("broken", sleep_for_ms(1), { "missing" });
+
+	scheduler.update(*ecs, 1.0f / 60.0f);
+
+	const int32_t last_frame = profiler.get_frame_count() - 1;
+	lecs::FrameProfiler::FrameStats stats = profiler.compute_frame_stats(last_frame);
+	std::cout << "test_frame_profiler critical path:";
+	for (int32_t event_index : stats.critical_path) {
+		std::cout << " " << profiler.get_frame_events(last_frame)[event_index].name;
+	}
+	std::cout << ", shorter than busy time: " << (stats.critical_path_us < stats.busy_time_us ? "true" : "false")
+		<< ", missing dependency rejected: " << (missing_dependency_rejected ? "true" : "false") << std::endl;
+
+	std::ostringstream trace;
+	profiler.write_chrome_trace(trace);
+	std::cout << "test_frame_profiler trace has events: " << (trace.str().find("\"apply\"") != std::string::npos ? "true" : "false") << std::endl;
+}
+void test_stats() {
+	std::unique_ptr<lecs::ECS> ecs = std::make_unique<lecs::ECS>();
+	const lecs::Stats before = lecs::get_stats();
+
+	lecs::Entity e0 = ecs->create_entity();
+	lecs::Entity e1 = ecs->create_entity();
+	ecs->add_component_to_entity<VelocityComponent>(e0); // the pool was already created by the earlier tests, but not in this ECS
+	ecs->add_component_to_entity<VelocityComponent>(e1);
+	ecs->remove_component_from_entity<VelocityComponent>(e0); // e1's component is moved into e0's slot
+	ecs->remove_entity(e0);
+	ecs->create_entity(); // reuses e0's index
+	ecs->add_component_to_entity<VelocityComponent>(e0); // stale handle
+
+	// Counters of other threads are merged too.
+	std::thread other_thread([&ecs, e0]() { ecs->remove_entity(e0); });
+	other_thread.join();
+
+	const lecs::Stats frame_stats = lecs::get_stats() - before;
+	std::cout << "test_stats swap moves: " << frame_stats.remove_swap_moves << ", free list hits: " << frame_stats.free_list_hits
+		<< ", pool creations: " << frame_stats.lazy_pool_creations << ", invalid handles: " << frame_stats.invalid_handle_rejections << std::endl;
+}
+void test_spatial_grid() {
+	std::unique_ptr<lecs::ECS> ecs = std::make_unique<lecs::ECS>();
+	lecs::SpatialGrid<PositionComponent> grid(*ecs, 4.0f);
+
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> coordinate(-50.0f, 50.0f);
+	std::vector<lecs::Entity> entities;
+	for (int i = 0; i < 2000; i++) {
+		lecs::Entity e = ecs->create_entity();
+		ecs->add_component_to_entity<PositionComponent>(e);
+		ecs->set_component<PositionComponent>(e, { coordinate(random), coordinate(random), 0.0f });
+		entities.push_back(e);
+	}
+	for (int i = 0; i < 500; i++) {
+		ecs->remove_entity(entities[i]);
+	}
+
+	// Move some of them to a different cell.
+	for (int i = 500; i < 600; i++) {
+		ecs->set_component<PositionComponent>(entities[i], { coordinate(random), coordinate(random), 0.0f });
+	}
+
+	const lecs::SpatialPoint center = { 3.0f, -7.0f, 0.0f };
+	auto distance_to_center = [&](lecs::Entity e) {
+		const PositionComponent* p = ecs->get_component<PositionComponent>(e);
+		return (p->x - center.x) * (p->x - center.x) + (p->y - center.y) * (p->y - center.y);
+	};
+	std::vector<lecs::Entity> by_distance;
+	for (lecs::Entity e : lecs::EntityIterator<PositionComponent>(*ecs)) {
+		by_distance.push_back(e);
+	}
+	std::sort(by_distance.begin(), by_distance.end(), [&](lecs::Entity a, lecs::Entity b) { return distance_to_center(a) < distance_to_center(b); });
+
+	std::vector<lecs::Entity> expected_in_radius;
+	for (lecs::Entity e : by_distance) {
+		if (distance_to_center(e) <= 10.0f * 10.0f) expected_in_radius.push_back(e);
+	}
+	auto same_entities = [](std::vector<lecs::Entity> a, std::vector<lecs::Entity> b) {
+		auto by_id = [](const lecs::Entity& l, const lecs::Entity& r) { return l.id < r.id; };
+		std::sort(a.begin(), a.end(), by_id);
+		std::sort(b.begin(), b.end(), by_id);
+		return a == b;
+	};
+
+	std::vector<lecs::Entity> in_radius;
+	grid.query_radius(center, 10.0f, in_radius);
+	const bool radius_matches = same_entities(in_radius, expected_in_radius);
+
+	std::vector<lecs::Entity> nearest;
+	grid.query_k_nearest(center, 5, nearest);
+	const bool nearest_matches = nearest == std::vector<lecs::Entity>(by_distance.begin(), by_distance.begin() + 5);
+
+	lecs::JobPool job_pool(2);
+	grid.rebuild(&job_pool);
+	std::vector<lecs::Entity> in_radius_after_rebuild;
+	grid.query_radius(center, 10.0f, in_radius_after_rebuild);
+
+	// Disabled entities stay in the grid, the queries skip them unless asked.
+	ecs->set_entity_enabled(by_distance[0], false);
+	std::vector<lecs::Entity> nearest_enabled;
+	grid.query_k_nearest(center, 5, nearest_enabled);
+	std::vector<lecs::Entity> in_radius_enabled;
+	grid.query_radius(center, 10.0f, in_radius_enabled);
+	std::vector<lecs::Entity> in_radius_all;
+	grid.query_radius(center, 10.0f, in_radius_all, lecs::EntityFilter::IncludeDisabled);
+	const bool disabled_skipped = nearest_enabled == std::vector<lecs::Entity>(by_distance.begin() + 1, by_distance.begin() + 6) &&
+		in_radius_enabled.size() + 1 == expected_in_radius.size() && same_entities(in_radius_all, expected_in_radius);
+
+	std::cout << "test_spatial_grid radius query matches: " << (radius_matches ? "true" : "false") << ", k nearest matches: " << (nearest_matches ? "true" : "false")
+		<< ", rebuild matches: " << (same_entities(in_radius, in_radius_after_rebuild) ? "true" : "false")
+		<< ", disabled skipped: " << (disabled_skipped ? "true" : "false") << ", entities: " << grid.get_entity_count() << std::endl;
+}
+void test_secondary_indexes() {
+	std::unique_ptr<lecs::ECS> ecs = std::make_unique<lecs::ECS>();
+	std::vector<lecs::Entity> entities;
+	for (uint32_t i = 0; i < 100; i++) {
+		lecs::Entity e = ecs->create_entity();
+		ecs->add_component_to_entity<NetworkIdComponent>(e);
+		ecs->set_component<NetworkIdComponent>(e, { 1000 + i, static_cast<int32_t>(i % 10) });
+		entities.push_back(e);
+	}
+
+	// Indexes created after the components exist pick them up.
+	lecs::HashIndex<NetworkIdComponent, uint32_t> network_ids(*ecs, &NetworkIdComponent::value);
+	lecs::OrderedIndex<NetworkIdComponent, int32_t> scores(*ecs, &NetworkIdComponent::score);
+
+	ecs->remove_entity(entities[42]);
+	ecs->set_component<NetworkIdComponent>(entities[7], { 5000, 100 });
+
+	std::vector<lecs::Entity> best;
+	scores.find_largest(3, best);
+	std::vector<lecs::Entity> in_range;
+	scores.find_range(2, 3, in_range);
+
+	int32_t with_velocity = 0;
+	ecs->add_component_to_entity<VelocityComponent>(in_range.front());
+	for (lecs::Entity e : lecs::EntityListIterator<VelocityComponent>(*ecs, in_range)) {
+		with_velocity += ecs->has_component<VelocityComponent>(e) ? 1 : 0;
+	}
+
+	// Disabled entities are left out, unless asked for.
+	ecs->set_entity_enabled(entities[3], false);
+	ecs->set_entity_enabled(entities[7], false);
+	std::vector<lecs::Entity> best_enabled;
+	scores.find_largest(1, best_enabled);
+	const bool disabled_skipped = network_ids.find(1003) == lecs::Entity::Invalid &&
+		network_ids.find(1003, lecs::EntityFilter::IncludeDisabled) == entities[3] &&
+		best_enabled.size() == 1 && !(best_enabled.front() == entities[7]) && scores.find(100, lecs::EntityFilter::IncludeDisabled) == entities[7];
+	ecs->set_entity_enabled(entities[3], true);
+	ecs->set_entity_enabled(entities[7], true);
+
+	std::cout << "test_secondary_indexes find: " << (network_ids.find(1003) == entities[3] ? "true" : "false")
+		<< ", removed: " << (network_ids.find(1042) == lecs::Entity::Invalid ? "true" : "false")
+		<< ", changed: " << (network_ids.find(5000) == entities[7] && network_ids.count(1007) == 0 ? "true" : "false")
+		<< ", top score: " << (best.front() == entities[7] ? "true" : "false")
+		<< ", range size: " << in_range.size() << ", filtered: " << with_velocity << ", disabled skipped: " << (disabled_skipped ? "true" : "false") << std::endl;
+}
+void test_world_checksum() {
+	std::unique_ptr<lecs::ECS> peer_a = std::make_unique<lecs::ECS>();
+	std::unique_ptr<lecs::ECS> peer_b = std::make_unique<lecs::ECS>();
+	lecs::WorldChecksum checksum_a(*peer_a);
+	lecs::WorldChecksum checksum_b(*peer_b);
+	checksum_a.track<VelocityComponent>(1);
+	checksum_b.track<VelocityComponent>(1);
+	checksum_a.track<PositionComponent>(2);
+	checksum_b.track<PositionComponent>(2);
+
+	// Same operations, in a different order.
+	std::vector<lecs::Entity> entities;
+	for (int i = 0; i < 10; i++) {
+		entities.push_back(peer_a->create_entity());
+		peer_b->create_entity();
+	}
+	for (int i = 0; i < 10; i++) {
+		peer_a->add_component_to_entity<VelocityComponent>(entities[i]);
+		peer_b->add_component_to_entity<VelocityComponent>(entities[9 - i]);
+		peer_a->set_component<VelocityComponent>(entities[i], { { float(i), 0.0f, 0.0f } });
+		peer_b->set_component<VelocityComponent>(entities[9 - i], { { float(9 - i), 0.0f, 0.0f } });
+	}
+	const bool same_after_reordering = checksum_a.get_digest() == checksum_b.get_digest();
+
+	peer_b->set_component<VelocityComponent>(entities[6], { { 0.5f, 0.0f, 0.0f } });
+
+	std::vector<lecs::WorldChecksum::PoolDigest> pools_a, pools_b;
+	checksum_a.get_pool_digests(pools_a);
+	checksum_b.get_pool_digests(pools_b);
+	uint32_t pool_key = 0;
+	lecs::WorldChecksum::find_first_differing_pool(pools_a, pools_b, pool_key);
+
+	std::vector<lecs::WorldChecksum::EntityHash> hashes_a, hashes_b;
+	checksum_a.get_entity_hashes(pool_key, hashes_a);
+	checksum_b.get_entity_hashes(pool_key, hashes_b);
+	lecs::Entity differing_entity;
+	lecs::WorldChecksum::find_first_differing_entity(hashes_a, hashes_b, differing_entity);
+
+	std::cout << "test_world_checksum same after reordering: " << (same_after_reordering ? "true" : "false")
+		<< ", differs after desync: " << (checksum_a.get_digest() != checksum_b.get_digest() ? "true" : "false")
+		<< ", differing pool: " << pool_key << ", differing entity found: " << (differing_entity == entities[6] ? "true" : "false") << std::endl;
+}
+
+struct CountingObserver : lecs::IComponentObserver {
+	void on_component_added(lecs::Entity) override { added++; }
+	void on_component_removed(lecs::Entity) override { removed++; }
+	void on_component_changed(lecs::Entity) override { changed++; }
+
+	int32_t added = 0;
+	int32_t removed = 0;
+	int32_t changed = 0;
+};
+
+void test_cell_streaming() {
+	lecs::ComponentRegistry registry;
+	registry.register_component<VelocityComponent>(1, "Velocity");
+	registry.register_component<PositionComponent>(2, "Position");
+
+	std::unique_ptr<lecs::ECS> source = std::make_unique<lecs::ECS>();
+	std::vector<lecs::Entity> cell_entities;
+	for (int i = 0; i < 1000; i++) {
+		lecs::Entity entity = source->create_entity();
+		source->add_component_to_entity<PositionComponent>(entity);
+		source->set_component<PositionComponent>(entity, { float(i), 0.0f, 0.0f });
+		if (i % 2 == 0) {
+			source->add_component_to_entity<VelocityComponent>(entity);
+			source->set_component<VelocityComponent>(entity, { { 1.0f, float(i), 0.0f } });
+		}
+		cell_entities.push_back(entity);
+	}
+	std::vector<uint8_t> bytes;
+	lecs::encode_cell(*source, registry, cell_entities, bytes);
+
+	std::unique_ptr<lecs::ECS> world = std::make_unique<lecs::ECS>();
+	CountingObserver observer;
+	world->add_component_observer<PositionComponent>(&observer);
+	const lecs::Entity outside_cell = world->create_entity();
+	world->add_component_to_entity<PositionComponent>(outside_cell);
+	lecs::JobPool job_pool(2);
+	lecs::CellStreamer streamer(registry, job_pool);
+	streamer.request_load(7, bytes);
+	streamer.request_load(8, std::vector<uint8_t>{ 1, 2, 3 });
+
+	// Commit with no budget, so it has to stop and continue many times.
+	int32_t commit_calls = 0;
+	while (streamer.get_state(7) != lecs::CellState::Loaded || streamer.get_state(8) == lecs::CellState::Loading) {
+		if (!streamer.commit(*world, std::chrono::microseconds(0))) {
+			commit_calls++;
+		}
+	}
+
+	bool matches = streamer.get_state(7) == lecs::CellState::Loaded && streamer.get_entities(7)->size() == cell_entities.size();
+	for (size_t i = 0; matches && i < cell_entities.size(); i++) {
+		lecs::Entity entity = (*streamer.get_entities(7))[i];
+		const PositionComponent* position = world->get_component<PositionComponent>(entity);
+		const VelocityComponent* velocity = world->get_component<VelocityComponent>(entity);
+		matches = position && position->x == float(i) && (i % 2 == 0 ? velocity && velocity->velocity[1] == float(i) : velocity == nullptr);
+	}
+
+	// Streamed components are constructed from their bytes, so they are only notified as added.
+	const bool notified_once = observer.added == 1001 && observer.changed == 0;
+
+	const std::vector<lecs::Entity> loaded_entities = *streamer.get_entities(7);
+	streamer.unload(*world, 7);
+	size_t entities_left = 0;
+	for (lecs::Entity entity : loaded_entities) {
+		entities_left += world->is_entity_handle_active(entity) ? 1 : 0;
+	}
+	const bool unloaded_cell_only = observer.removed == 1000 && world->get_component<PositionComponent>(outside_cell) != nullptr &&
+		lecs::DenseView<PositionComponent>(*world).size() == 1;
+	world->remove_component_observer<PositionComponent>(&observer);
+
+	std::cout << "test_cell_streaming matches: " << (matches ? "true" : "false") << ", committed in steps: " << (commit_calls > 0 ? "true" : "false")
+		<< ", bad cell failed: " << (streamer.get_state(8) == lecs::CellState::Failed ? "true" : "false")
+		<< ", unloaded: " << (entities_left == 0 && unloaded_cell_only ? "true" : "false") << ", notified once: " << (notified_once ? "true" : "false") << std::endl;
+}
+
+void test_move_entities() {
+	std::unique_ptr<lecs::ECS> side_world = std::make_unique<lecs::ECS>();
+	std::unique_ptr<lecs::ECS> live_world = std::make_unique<lecs::ECS>();
+	live_world->set_entity_remapper<ParentComponent>([](ParentComponent& component, const lecs::EntityRemap& remap) {
+		component.parent = remap.get(component.parent);
+	});
+	lecs::HashIndex<NetworkIdComponent, uint32_t> live_network_ids(*live_world, &NetworkIdComponent::value);
+	live_world->create_entity();
+
+	// A chain of 100 entities, each one the parent of the next. The even ones are moved.
+	std::vector<lecs::Entity> entities;
+	std::vector<lecs::Entity> selection;
+	for (int i = 0; i < 100; i++) {
+		lecs::Entity entity = side_world->create_entity();
+		side_world->add_component_to_entity<NetworkIdComponent>(entity);
+		side_world->set_component<NetworkIdComponent>(entity, { uint32_t(i), 0 });
+		if (i > 0) {
+			side_world->add_component_to_entity<ParentComponent>(entity);
+			side_world->set_component<ParentComponent>(entity, { entities.back() });
+		}
+		entities.push_back(entity);
+		if (i % 2 == 0) {
+			selection.push_back(entity);
+		}
+	}
+	selection.push_back(entities[0]); // repeated handles are skipped
+
+	lecs::EntityRemap remap;
+	const bool moved = lecs::move_entities(*side_world, *live_world, selection, remap);
+
+	bool matches = remap.get_destination_entities().size() == 50;
+	for (int i = 0; matches && i < 100; i++) {
+		lecs::Entity live_entity = remap.get(entities[i]);
+		if (i % 2 == 0) {
+			const NetworkIdComponent* network_id = live_world->get_component<NetworkIdComponent>(live_entity);
+			const ParentComponent* parent = live_world->get_component<ParentComponent>(live_entity);
+			// Parents were odd, so they stayed behind and the references become invalid.
+			matches = !side_world->is_entity_handle_active(entities[i]) && network_id && network_id->value == uint32_t(i) &&
+				live_network_ids.find(uint32_t(i)) == live_entity && (i == 0 ? parent == nullptr : parent && !parent->parent.is_valid());
+		}
+		else {
+			const ParentComponent* parent = side_world->get_component<ParentComponent>(entities[i]);
+			matches = !live_entity.is_valid() && side_world->get_component<NetworkIdComponent>(entities[i])->value == uint32_t(i) && parent && parent->parent == entities[i - 1];
+		}
+	}
+
+	std::cout << "test_move_entities moved: " << (moved ? "true" : "false") << ", matches: " << (matches ? "true" : "false")
+		<< ", remaining in side world: " << side_world->get_component_array<NetworkIdComponent>().get_size() << std::endl;
+}
+
+#if defined(LECS_HAS_COROUTINES)
+lecs::CoroutineSystem raycast_and_wait(lecs::CoroutineContext& context, lecs::Entity entity, std::vector<uint64_t>& frames) {
+	std::vector<float> results(1000, 0.0f);
+	co_await context.parallel_for(1000, 100, [&](int32_t begin, int32_t end) {
+		for (int32_t i = begin; i < end; i++) results[i] = float(i);
+	});
+	frames.push_back(context.get_frame());
+
+	float sum = 0.0f;
+	for (float result : results) sum += result;
+	context.get_ecs().set_component<VelocityComponent>(entity, { { sum, 0.0f, 0.0f } });
+
+	for (int i = 0; i < 3; i++) {
+		co_await context.next_frame();
+		frames.push_back(context.get_frame());
+	}
+}
+
+void test_coroutine_systems() {
+	std::unique_ptr<lecs::ECS> ecs = std::make_unique<lecs::ECS>();
+	lecs::Entity entity = ecs->create_entity();
+	ecs->add_component_to_entity<VelocityComponent>(entity);
+
+	lecs::JobPool job_pool(2);
+	lecs::CoroutineRunner runner(&job_pool);
+	std::vector<uint64_t> frames;
+	runner.start(raycast_and_wait, entity, std::ref(frames));
+
+	// Frames are short here, the jobs may take a few of them.
+	int32_t updates = 0;
+	while (runner.get_running_count() > 0 && updates < 1000) {
+		runner.update(*ecs, 1.0f / 60.0f);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		updates++;
+	}
+
+	bool consecutive_frames = frames.size() == 4;
+	for (size_t i = 1; consecutive_frames && i < frames.size(); i++) {
+		consecutive_frames = frames[i] == frames[i - 1] + 1;
+	}
+
+	std::cout << "test_coroutine_systems finished: " << (runner.get_running_count() == 0 ? "true" : "false")
+		<< ", jobs applied: " << (ecs->get_component<VelocityComponent>(entity)->velocity[0] == 499500.0f ? "true" : "false")
+		<< ", one frame per next_frame: " << (consecutive_frames ? "true" : "false") << std::endl;
+}
+#endif // defined(LECS_HAS_COROUTINES)
+
+void test_replication() {
+	lecs::ReplicationSchema schema;
+	schema.add_component<PositionComponent>()
+		->add_field(&PositionComponent::x, -100.0f, 100.0f, 16)
+		.add_field(&PositionComponent::y, -100.0f, 100.0f, 16)
+		.add_field(&PositionComponent::z, -100.0f, 100.0f, 16);
+	schema.add_component<NetworkIdComponent>()
+		->add_field(&NetworkIdComponent::value, 20)
+		.add_field(&NetworkIdComponent::score, 12);
+
+	std::unique_ptr<lecs::ECS> server = std::make_unique<lecs::ECS>();
+	std::unique_ptr<lecs::ECS> client = std::make_unique<lecs::ECS>();
+	lecs::ReplicationEncoder encoder(schema);
+	lecs::ReplicationDecoder decoder(schema);
+
+	std::vector<lecs::Entity> entities;
+	for (int i = 0; i < 200; i++) {
+		lecs::Entity entity = server->create_entity();
+		server->add_component_to_entity<PositionComponent>(entity);
+		server->set_component<PositionComponent>(entity, { float(i) * 0.5f - 50.0f, 1.0f, -1.0f });
+		server->add_component_to_entity<NetworkIdComponent>(entity);
+		server->set_component<NetworkIdComponent>(entity, { uint32_t(i), -i });
+		entities.push_back(entity);
+	}
+
+	std::vector<uint8_t> packet;
+	auto matches = [&]() {
+		for (lecs::Entity entity : entities) {
+			lecs::Entity local_entity = decoder.get_local_entity(entity);
+			if (!server->is_entity_handle_active(entity)) {
+				if (local_entity.is_valid()) return false;
+				continue;
+			}
+			const PositionComponent* position = server->get_component<PositionComponent>(entity);
+			const PositionComponent* local_position = client->get_component<PositionComponent>(local_entity);
+			const NetworkIdComponent* network_id = server->get_component<NetworkIdComponent>(entity);
+			const NetworkIdComponent* local_network_id = client->get_component<NetworkIdComponent>(local_entity);
+			if ((position == nullptr) != (local_position == nullptr) || (position && std::abs(position->x - local_position->x) > 0.002f)) return false;
+			if (!local_network_id || local_network_id->value != network_id->value || local_network_id->score != network_id->score) return false;
+		}
+		return true;
+	};
+
+	// Indices follow the observer notifications, so they see the decoded values.
+	lecs::HashIndex<NetworkIdComponent, uint32_t> client_network_ids(*client, &NetworkIdComponent::value);
+
+	encoder.encode(*server, entities, packet);
+	const size_t full_size = packet.size();
+	const bool first_matches = decoder.decode(packet, *client) && matches();
+	bool indexed = client_network_ids.find(7) == decoder.get_local_entity(entities[7]) && client_network_ids.count(0) == 1;
+
+	server->set_component<PositionComponent>(entities[10], { 42.0f, 1.0f, -1.0f });
+	server->remove_component_from_entity<PositionComponent>(entities[20]);
+	server->remove_entity(entities[30]);
+	encoder.encode(*server, entities, packet);
+	const size_t delta_size = packet.size();
+	const bool delta_matches = decoder.decode(packet, *client) && matches();
+
+	encoder.encode(*server, entities, packet);
+	const size_t unchanged_size = packet.size();
+
+	std::cout << "test_replication full packet: " << full_size << " bytes, first matches: " << (first_matches ? "true" : "false")
+		<< ", delta packet: " << delta_size << " bytes, delta matches: " << (delta_matches ? "true" : "false")
+		<< ", unchanged packet: " << unchanged_size << " bytes, indexed: " << (indexed ? "true" : "false") << std::endl;
+}
+
+void test_enabled_entities() {
+	std::unique_ptr<lecs::ECS> ecs = std::make_unique<lecs::ECS>();
+	std::vector<lecs::Entity> entities;
+	for (int i = 0; i < 100; i++) {
+		lecs::Entity entity = ecs->create_entity();
+		ecs->add_component_to_entity<VelocityComponent>(entity);
+		ecs->set_component<VelocityComponent>(entity, { { float(i), 0.0f, 0.0f } });
+		entities.push_back(entity);
+	}
+
+	// Disable the even ones, including the first, which begin() has to skip.
+	for (int i = 0; i < 100; i += 2) {
+		ecs->set_entity_enabled(entities[i], false);
+	}
+	const lecs::Stats before = lecs::get_stats();
+
+	int32_t enabled_count = 0;
+	for (lecs::Entity entity : lecs::EntityIterator<VelocityComponent>(*ecs)) {
+		enabled_count += ecs->is_entity_enabled(entity) ? 1 : 0;
+	}
+	int32_t all_count = 0;
+	for (lecs::Entity entity : lecs::EntityIterator<VelocityComponent>(*ecs, lecs::EntityFilter::IncludeDisabled)) {
+		all_count += ecs->has_component<VelocityComponent>(entity) ? 1 : 0;
+	}
+	lecs::TimeSlicedQuery<VelocityComponent> query;
+	const int32_t sliced_count = query.run(*ecs, 1000, [](lecs::Entity) {});
+
+	ecs->set_entity_enabled(entities[0], true);
+	const bool data_kept = ecs->get_component<VelocityComponent>(entities[2])->velocity[0] == 2.0f &&
+		lecs::get_stats().remove_swap_moves == before.remove_swap_moves;
+
+	std::cout << "test_enabled_entities enabled visited: " << enabled_count << ", with disabled: " << all_count << ", time sliced: " << sliced_count
+		<< ", data kept: " << (data_kept ? "true" : "false") << ", enabled again: " << (ecs->is_entity_enabled(entities[0]) ? "true" : "false") << std::endl;
+}
+
+struct LargeComponent {
+	LargeComponent(int32_t first, int32_t last) : first(first), last(last) {}
+	int32_t first;
+	int32_t values[64];
+	int32_t last;
+};
+
+void test_emplace_and_patch() {
+	std::unique_ptr<lecs::ECS> ecs = std::make_unique<lecs::ECS>();
+	lecs::Entity entity = ecs->create_entity();
+
+	LargeComponent* large = ecs->emplace_component<LargeComponent>(entity, 1, 2);
+	PositionComponent* position = ecs->emplace_component<PositionComponent>(entity, 1.0f, 2.0f, 3.0f);
+	const bool emplaced = large && large->first == 1 && large->last == 2 && position && position->z == 3.0f &&
+		ecs->emplace_component<PositionComponent>(entity, 0.0f, 0.0f, 0.0f) == nullptr;
+
+	lecs::Entity other = ecs->create_entity();
+	const bool added = ecs->add_components(other, VelocityComponent{ { 4.0f, 5.0f, 6.0f } }, NetworkIdComponent{ 7, 8 }) &&
+		ecs->get_component<VelocityComponent>(other)->velocity[2] == 6.0f && ecs->get_component<NetworkIdComponent>(other)->score == 8;
+	// Nothing is added if one of them is already there.
+	const bool rejected = !ecs->add_components(entity, VelocityComponent{}, PositionComponent{}) && !ecs->has_component<VelocityComponent>(entity);
+
+	lecs::HashIndex<NetworkIdComponent, uint32_t> network_ids(*ecs, &NetworkIdComponent::value);
+	ecs->patch_component<NetworkIdComponent>(other, [](NetworkIdComponent& network_id) { network_id.value = 70; });
+	const bool patched = network_ids.find(70) == other && network_ids.find(7) == lecs::Entity::Invalid;
+
+	VelocityComponent* velocity = ecs->add_component_uninitialized<VelocityComponent>(entity);
+	velocity->velocity[0] = velocity->velocity[1] = velocity->velocity[2] = 1.0f;
+
+	std::cout << "test_emplace_and_patch emplaced: " << (emplaced ? "true" : "false") << ", added: " << (added ? "true" : "false")
+		<< ", rejected: " << (rejected ? "true" : "false") << ", patched: " << (patched ? "true" : "false")
+		<< ", uninitialized added: " << (ecs->has_component<VelocityComponent>(entity) ? "true" : "false") << std::endl;
+}
+
+void test_removal_during_iteration() {
+	std::unique_ptr<lecs::ECS> ecs = std::make_unique<lecs::ECS>();
+	std::vector<lecs::Entity> entities;
+	for (int i = 0; i < 1000; i++) {
+		lecs::Entity entity = ecs->create_entity();
+		ecs->emplace_component<NetworkIdComponent>(entity, uint32_t(i), i % 3 == 0 ? 0 : 10);
+		if (i % 2 == 0) {
+			ecs->add_component_to_entity<VelocityComponent>(entity);
+		}
+		entities.push_back(entity);
+	}
+
+	// Kill if score <= 0, from inside the loop.
+	std::vector<int32_t> visits(1000, 0);
+	for (lecs::Entity entity : lecs::ComponentView<NetworkIdComponent>(*ecs)) {
+		const NetworkIdComponent* network_id = ecs->get_component<NetworkIdComponent>(entity);
+		visits[network_id->value]++;
+		if (network_id->score <= 0) {
+			ecs->remove_entity(entity);
+		}
+	}
+
+	// Removing only the component of the view, and filtering on another one.
+	int32_t filtered_visits = 0;
+	for (lecs::Entity entity : lecs::ComponentView<NetworkIdComponent, VelocityComponent>(*ecs)) {
+		filtered_visits++;
+		ecs->remove_component_from_entity<NetworkIdComponent>(entity);
+	}
+
+	bool visited_once = true;
+	int32_t alive = 0;
+	for (int i = 0; i < 1000; i++) {
+		visited_once = visited_once && visits[i] == 1;
+		alive += ecs->is_entity_handle_active(entities[i]) ? 1 : 0;
+	}
+
+	std::cout << "test_removal_during_iteration visited once: " << (visited_once ? "true" : "false") << ", alive: " << alive
+		<< ", filtered visits: " << filtered_visits << ", left in pool: " << ecs->get_component_array<NetworkIdComponent>().get_size() << std::endl;
+}
+
+void test_snapshot() {
+	lecs::ComponentRegistry registry;
+	registry.register_component<VelocityComponent>(1, "Velocity");
+	registry.register_component<PositionComponent>(2, "Position");
+
+	std::unique_ptr<lecs::ECS> source = std::make_unique<lecs::ECS>();
+	std::vector<lecs::Entity> entities;
+	for (int i = 0; i < 10000; i++) {
+		lecs::Entity entity = source->create_entity();
+		source->add_component_to_entity<PositionComponent>(entity);
+		source->set_component<PositionComponent>(entity, { float(i), 0.0f, 0.0f });
+		if (i % 2 == 0) {
+			source->add_component_to_entity<VelocityComponent>(entity);
+			source->set_component<VelocityComponent>(entity, { { 1.0f, 0.0f, 0.0f } });
+		}
+		entities.push_back(entity);
+	}
+
+	// Record 30 frames where one entity in 10 moves, and a few are added and removed.
+	lecs::SnapshotEncoder encoder(registry);
+	encoder.set_key_frame_interval(10);
+	std::vector<std::vector<uint8_t>> frames(30);
+	size_t raw_size = 0;
+	size_t compressed_size = 0;
+	for (size_t frame = 0; frame < frames.size(); frame++) {
+		for (size_t i = frame % 10; i < entities.size(); i += 10) {
+			if (PositionComponent* position = source->get_component<PositionComponent>(entities[i])) {
+				position->x += 1.0f;
+			}
+		}
+		if (frame == 12) {
+			source->remove_entity(entities[3]);
+			source->remove_component_from_entity<VelocityComponent>(entities[4]);
+			source->add_component_to_entity<VelocityComponent>(entities[5]);
+			entities.push_back(source->create_entity());
+		}
+		if (frame == 15) {
+			// No entity takes its index this time, so every later component of the pools shifts.
+			source->remove_entity(entities[1]);
+		}
+
+		encoder.encode(*source, frames[frame]);
+		raw_size += source->get_component_array<PositionComponent>().get_size() * sizeof(PositionComponent) +
+			source->get_component_array<VelocityComponent>().get_size() * sizeof(VelocityComponent);
+		compressed_size += frames[frame].size();
+	}
+
+	// Components are XORed with the same entity, so creating and removing entities doesn't cost more than moving them.
+	const size_t churn_size = std::max(frames[12].size(), frames[15].size());
+	const bool churn_small = churn_size * 10 < std::max(frames[14].size(), frames[16].size()) * 11;
+
+	std::unique_ptr<lecs::ECS> replay = std::make_unique<lecs::ECS>();
+	lecs::JobPool job_pool(2);
+	lecs::SnapshotDecoder decoder(registry, &job_pool);
+	// Starting from a frame that isn't a key frame fails, the replay has to seek back to one.
+	const bool delta_rejected = !decoder.decode(frames[5], *replay) && !lecs::SnapshotDecoder::is_key_frame(frames[5]);
+	bool decoded = true;
+	for (const std::vector<uint8_t>& frame : frames) {
+		decoded = decoded && decoder.decode(frame, *replay);
+	}
+
+	bool matches = true;
+	for (size_t i = 0; matches && i < entities.size(); i++) {
+		lecs::Entity local_entity = decoder.get_local_entity(entities[i]);
+		if (!source->is_entity_handle_active(entities[i])) {
+			matches = local_entity == lecs::Entity::Invalid;
+			continue;
+		}
+
+		const PositionComponent* position = replay->get_component<PositionComponent>(local_entity);
+		const PositionComponent* source_position = source->get_component<PositionComponent>(entities[i]);
+		const bool has_velocity = replay->get_component<VelocityComponent>(local_entity) != nullptr;
+		matches = (position == nullptr) == (source_position == nullptr) && (position == nullptr || position->x == source_position->x) &&
+			has_velocity == (source->get_component<VelocityComponent>(entities[i]) != nullptr);
+	}
+
+	std::cout << "test_snapshot decoded: " << (decoded ? "true" : "false") << ", matches: " << (matches ? "true" : "false")
+		<< ", delta rejected: " << (delta_rejected ? "true" : "false")
+		<< ", compressed under a tenth: " << (compressed_size * 10 < raw_size ? "true" : "false") << ", churn small: " << (churn_small ? "true" : "false") << std::endl;
+}
+
+void test_handle_widths() {
+	const lecs::Entity entity(lecs::EntityIndex(lecs::MAX_ENTITIES - 1), lecs::Entity::MAX_GENERATION);
+	const bool round_trips = entity.get_index() == lecs::EntityIndex(lecs::MAX_ENTITIES - 1) && entity.get_generation() == lecs::Entity::MAX_GENERATION;
+	const bool wraps = lecs::Entity(0, lecs::Entity::MAX_GENERATION + 1).get_generation() == 0;
+
+	// The generation of a reused index grows, so old handles stay inactive.
+	std::unique_ptr<lecs::ECS> ecs = std::make_unique<lecs::ECS>();
+	lecs::Entity first = ecs->create_entity();
+	ecs->remove_entity(first);
+	lecs::Entity second = ecs->create_entity();
+	const bool reused = second.get_index() == first.get_index() && !ecs->is_entity_handle_active(first) && ecs->is_entity_handle_active(second);
+
+	std::cout << "test_handle_widths handle bytes: " << sizeof(lecs::Entity) << ", round trips: " << (round_trips ? "true" : "false")
+		<< ", generation wraps: " << (wraps ? "true" : "false") << ", reused index: " << (reused ? "true" : "false") << std::endl;
+}
+
+void test_trace_replay() {
+	lecs::ComponentRegistry registry;
+	registry.register_component<VelocityComponent>(1, "Velocity");
+	registry.register_component<PositionComponent>(2, "Position");
+
+	// Churn: entities come and go, gain and lose velocities, and a query runs every "frame".
+	std::unique_ptr<lecs::ECS> session = std::make_unique<lecs::ECS>();
+	lecs::Entity existing = session->create_entity(); // before the recording, created in the trace when first used
+	lecs::TraceRecorder recorder(registry);
+	recorder.start(*session);
+
+	std::mt19937 random(7);
+	std::vector<lecs::Entity> alive;
+	size_t visited_in_session = 0;
+	lecs::TimeSlicedQuery<VelocityComponent> sliced_query;
+	for (int frame = 0; frame < 100; frame++) {
+		for (int i = 0; i < 20; i++) {
+			lecs::Entity entity = session->create_entity();
+			session->add_component_to_entity<PositionComponent>(entity);
+			if (random() % 2 == 0) {
+				session->add_component_to_entity<VelocityComponent>(entity);
+			}
+			alive.push_back(entity);
+		}
+		for (int i = 0; i < 10; i++) {
+			const size_t victim = random() % alive.size();
+			if (random() % 2 == 0) {
+				session->remove_entity(alive[victim]);
+				alive[victim] = alive.back();
+				alive.pop_back();
+			}
+			else {
+				session->remove_component_from_entity<VelocityComponent>(alive[victim]);
+			}
+		}
+		for (lecs::Entity entity : lecs::EntityIterator<PositionComponent, VelocityComponent>(*session)) {
+			(void)entity;
+			visited_in_session++;
+		}
+		visited_in_session += sliced_query.run(*session, 50, [](lecs::Entity) {});
+	}
+	session->add_component_to_entity<PositionComponent>(existing);
+
+	// Moved entities are recorded as removed from the recorded ECS, or created in it with their components.
+	std::unique_ptr<lecs::ECS> side = std::make_unique<lecs::ECS>();
+	std::vector<lecs::Entity> side_entities;
+	for (int i = 0; i < 30; i++) {
+		side_entities.push_back(side->create_entity());
+		side->add_component_to_entity<PositionComponent>(side_entities.back());
+		side->add_component_to_entity<VelocityComponent>(side_entities.back());
+	}
+	lecs::EntityRemap remap;
+	bool moved = lecs::move_entities(*side, *session, side_entities, remap);
+	std::vector<lecs::Entity> leaving(alive.begin(), alive.begin() + 40);
+	moved = moved && lecs::move_entities(*session, *side, leaving, remap);
+	for (lecs::Entity entity : lecs::EntityIterator<VelocityComponent>(*session)) {
+		(void)entity;
+		visited_in_session++;
+	}
+	recorder.stop();
+	session->create_entity(); // not recorded anymore
+
+	// Sliced queries replay the same entity indices, so the replay starts with an entity in the index of existing.
+	std::unique_ptr<lecs::ECS> replay = std::make_unique<lecs::ECS>();
+	replay->create_entity();
+	lecs::TraceReport report;
+	const bool replayed = lecs::replay_trace(recorder.get_trace(), registry, *replay, report);
+
+	size_t session_positions = session->get_component_array<PositionComponent>().get_size();
+	size_t replay_positions = replay->get_component_array<PositionComponent>().get_size();
+	const bool same_world = moved && session_positions == replay_positions &&
+		session->get_component_array<VelocityComponent>().get_size() == replay->get_component_array<VelocityComponent>().get_size() &&
+		session->get_alive_entity_count() == replay->get_alive_entity_count();
+
+	lecs::ComponentRegistry empty_registry;
+	lecs::TraceReport rejected_report;
+	const bool rejected = !lecs::replay_trace(recorder.get_trace(), empty_registry, *replay, rejected_report);
+
+	std::cout << "test_trace_replay replayed: " << (replayed ? "true" : "false") << ", same world: " << (same_world ? "true" : "false")
+		<< ", creates: " << report.get(lecs::TraceOperation::CreateEntity).count << ", queries: " << report.get(lecs::TraceOperation::Query).count
+		<< ", sliced queries: " << report.get(lecs::TraceOperation::SlicedQuery).count
+		<< ", same visits: " << (report.visited_entities == visited_in_session ? "true" : "false")
+		<< ", unregistered rejected: " << (rejected ? "true" : "false") << ", bytes per operation: " << recorder.get_trace().size() / recorder.get_operation_count() << std::endl;
+}
+
+void test_sharded_world() {
+	lecs::JobPool job_pool(2);
+	lecs::ShardedWorld world(3, &job_pool);
+
+	// Everything spawns in shard 0, and belongs to the shard of its x.
+	std::vector<lecs::ShardedEntity> entities;
+	for (int i = 0; i < 300; i++) {
+		lecs::ShardedEntity entity = world.create_entity(0);
+		world.get_shard(0).add_component_to_entity<PositionComponent>(entity.entity);
+		world.get_shard(0).set_component<PositionComponent>(entity.entity, { float(i), 0.0f, 0.0f });
+		entities.push_back(entity);
+	}
+
+	auto partition = [](lecs::ECS& shard, lecs::Entity entity) {
+		return uint32_t(shard.get_component<PositionComponent>(entity)->x) % 3;
+	};
+	const bool first_migrated = world.migrate(partition) && world.get_migrated_count() == 200;
+
+	bool handles_follow = true;
+	for (int i = 0; i < 300; i++) {
+		entities[i] = world.get_migrated(entities[i]);
+		const PositionComponent* position = world.get_shard(entities[i].shard).get_component<PositionComponent>(entities[i].entity);
+		handles_follow = handles_follow && entities[i].shard == uint32_t(i % 3) && position != nullptr && position->x == float(i);
+	}
+
+	// Every shard moves its entities on its own, then all of them move to the next shard.
+	world.for_each_shard([](lecs::ECS& shard, uint32_t) {
+		for (lecs::Entity entity : lecs::ComponentView<PositionComponent>(shard)) {
+			shard.get_component<PositionComponent>(entity)->x += 1.0f;
+		}
+	});
+	const bool second_migrated = world.migrate(partition) && world.get_migrated_count() == 300;
+
+	bool partitioned = true;
+	for (uint32_t shard = 0; shard < world.get_shard_count(); shard++) {
+		auto& positions = world.get_shard(shard).get_component_array<PositionComponent>();
+		partitioned = partitioned && positions.get_size() == 100;
+		for (size_t i = 0; i < positions.get_size(); i++) {
+			partitioned = partitioned && uint32_t(positions.get_data_from_component_index(i).x) % 3 == shard;
+		}
+	}
+
+	const bool bad_shard_rejected = !world.migrate([](lecs::ECS&, lecs::Entity) { return 7u; }) && world.get_migrated_count() == 0;
+
+	std::cout << "test_sharded_world first migration: " << (first_migrated ? "true" : "false") << ", handles follow: " << (handles_follow ? "true" : "false")
+		<< ", second migration: " << (second_migrated ? "true" : "false") << ", partitioned: " << (partitioned ? "true" : "false")
+		<< ", bad shard rejected: " << (bad_shard_rejected ? "true" : "false") << std::endl;
+}
+
+void test_dense_views() {
+	std::unique_ptr<lecs::ECS> ecs = std::make_unique<lecs::ECS>();
+	ecs->create_entity(); // entity 0 has no position, begin() used to visit it anyway
+	for (int i = 0; i < 1000; i++) {
+		lecs::Entity entity = ecs->create_entity();
+		ecs->add_component_to_entity<PositionComponent>(entity);
+		ecs->set_component<PositionComponent>(entity, { float(i), 0.0f, 0.0f });
+	}
+
+	size_t visited = 0;
+	lecs::EntityIterator<PositionComponent> query(*ecs);
+	for (auto it = query.begin(); it != query.end(); it++) {
+		visited += ecs->has_component<PositionComponent>(*it) ? 1 : 0;
+	}
+	const bool iterator_fixed = visited == 1000 && std::distance(query.begin(), query.end()) == 1000 && !(query.begin() == query.end());
+
+	lecs::DenseView<PositionComponent> positions(*ecs);
+	lecs::DenseEntityView<PositionComponent> entities(*ecs);
+	using Category = std::iterator_traits<lecs::DenseView<PositionComponent>::iterator>::iterator_category;
+	using EntityCategory = std::iterator_traits<lecs::DenseEntityView<PositionComponent>::iterator>::iterator_category;
+	const bool random_access = std::is_same<Category, std::random_access_iterator_tag>::value && std::is_same<EntityCategory, std::input_iterator_tag>::value &&
+		positions.end() - positions.begin() == 1000 && positions.size() == 1000 && &positions.begin()[10] == &positions[10];
+
+	// Entities and components line up, in both directions.
+	bool aligned = true;
+	for (size_t i = 0; i < entities.size(); i++) {
+		aligned = aligned && ecs->get_component<PositionComponent>(entities[i]) == &positions[i];
+	}
+	std::for_each(positions.begin(), positions.end(), [](PositionComponent& position) { position.y = position.x * 2.0f; });
+	const float last_y = std::prev(positions.end())->y;
+	const bool written = last_y == 1998.0f && std::count_if(std::reverse_iterator<lecs::DenseView<PositionComponent>::iterator>(positions.end()),
+		std::reverse_iterator<lecs::DenseView<PositionComponent>::iterator>(positions.begin()), [](const PositionComponent& position) { return position.x >= 500.0f; }) == 500;
+
+	bool ranges_compose = true;
+#if defined(__cpp_lib_ranges)
+	static_assert(std::ranges::random_access_range<lecs::DenseView<PositionComponent>>, "random access");
+	static_assert(std::ranges::sized_range<lecs::DenseEntityView<PositionComponent>>, "sized");
+	static_assert(std::ranges::random_access_range<lecs::DenseEntityView<PositionComponent>>, "random access entities");
+	auto even = lecs::DenseView<PositionComponent>(*ecs) | std::views::filter([](const PositionComponent& position) { return int(position.x) % 2 == 0; })
+		| std::views::transform([](const PositionComponent& position) { return position.x; });
+	ranges_compose = std::ranges::distance(even) == 500;
+#endif // defined(__cpp_lib_ranges)
+
+	std::cout << "test_dense_views iterator fixed: " << (iterator_fixed ? "true" : "false") << ", random access: " << (random_access ? "true" : "false")
+		<< ", aligned: " << (aligned ? "true" : "false") << ", written: " << (written ? "true" : "false")
+		<< ", ranges compose: " << (ranges_compose ? "true" : "false") << std::endl;
+}
+
+template <size_t Size, bool Indirect>
+struct SizedComponent {
+	uint32_t value;
+	uint8_t payload[Size - sizeof(uint32_t)];
+};
+
+template <size_t Size>
+struct lecs::ComponentStorageOf<SizedComponent<Size, true>> {
+	static const lecs::ComponentStorage value = lecs::ComponentStorage::Indirect;
+};
+
+// Removes half of the components in random order, then sums the others. Returns the seconds of both.
+template <typename Component>
+std::pair<double, double> time_component_storage(bool& out_correct) {
+	constexpr uint32_t num_entities = 100000;
+	std::unique_ptr<lecs::ECS> ecs = std::make_unique<lecs::ECS>();
+	std::vector<lecs::Entity> entities;
+	for (uint32_t i = 0; i < num_entities; i++) {
+		entities.push_back(ecs->create_entity());
+		ecs->emplace_component<Component>(entities.back())->value = i;
+	}
+
+	std::vector<lecs::Entity> removed(entities.begin(), entities.begin() + num_entities / 2);
+	std::shuffle(removed.begin(), removed.end(), std::mt19937(11));
+
+	using namespace std::chrono;
+	high_resolution_clock::time_point t1 = high_resolution_clock::now();
+	for (lecs::Entity entity : removed) {
+		ecs->remove_component_from_entity<Component>(entity);
+	}
+	high_resolution_clock::time_point t2 = high_resolution_clock::now();
+	uint64_t sum = 0;
+	for (const Component& component : lecs::DenseView<Component>(*ecs)) {
+		sum += component.value;
+	}
+	high_resolution_clock::time_point t3 = high_resolution_clock::now();
+
+	out_correct = sum == uint64_t(num_entities / 2 + num_entities - 1) * (num_entities / 2) / 2;
+	for (uint32_t i = 0; i < num_entities; i++) {
+		const Component* component = ecs->get_component<Component>(entities[i]);
+		out_correct = out_correct && (i < num_entities / 2 ? component == nullptr : component != nullptr && component->value == i);
+	}
+
+	return { duration_cast<duration<double>>(t2 - t1).count(), duration_cast<duration<double>>(t3 - t2).count() };
+}
+
+template <size_t Size>
+bool test_component_storage_size() {
+	bool inline_correct, indirect_correct;
+	const std::pair<double, double> inline_times = time_component_storage<SizedComponent<Size, false>>(inline_correct);
+	const std::pair<double, double> indirect_times = time_component_storage<SizedComponent<Size, true>>(indirect_correct);
+	std::cout << "test_indirect_storage " << Size << " bytes, removal took " << inline_times.first << " seconds inline, "
+		<< indirect_times.first << " indirect, iteration took " << inline_times.second << " seconds inline, " << indirect_times.second << " indirect\n";
+	return inline_correct && indirect_correct;
+}
+
+void test_indirect_storage() {
+	// Bigger inline components don't fit LECS_MAX_ENTITIES in memory here.
+	const bool correct = test_component_storage_size<16>() && test_component_storage_size<64>() && test_component_storage_size<256>();
+
+	// Moving between worlds reallocates in the slab of the destination.
+	std::unique_ptr<lecs::ECS> source = std::make_unique<lecs::ECS>();
+	std::unique_ptr<lecs::ECS> destination = std::make_unique<lecs::ECS>();
+	std::vector<lecs::Entity> selection;
+	for (uint32_t i = 0; i < 100; i++) {
+		lecs::Entity entity = source->create_entity();
+		source->emplace_component<SizedComponent<2048, true>>(entity)->value = i;
+		if (i % 3 == 0) {
+			selection.push_back(entity);
+		}
+	}
+	lecs::EntityRemap remap;
+	bool moved = lecs::move_entities(*source, *destination, selection, remap);
+	for (lecs::Entity entity : selection) {
+		const SizedComponent<2048, true>* component = destination->get_component<SizedComponent<2048, true>>(remap.get(entity));
+		moved = moved && component != nullptr && component->value % 3 == 0;
+	}
+	uint32_t kept_sum = 0;
+	for (const SizedComponent<2048, true>& component : lecs::DenseView<SizedComponent<2048, true>>(*source)) {
+		kept_sum += component.value % 3 == 0 ? 1000 : component.value;
+	}
+	moved = moved && kept_sum == 4950 - 1683;
+
+	std::cout << "test_indirect_storage correct: " << (correct ? "true" : "false") << ", moved: " << (moved ? "true" : "false") << std::endl;
+}
+
+struct BossComponent {
+	uint32_t phase;
+};
+
+template <>
+struct lecs::ComponentStorageOf<BossComponent> {
+	static const lecs::ComponentStorage value = lecs::ComponentStorage::Rare;
+};
+
+void test_rare_storage() {
+	std::unique_ptr<lecs::ECS> ecs = std::make_unique<lecs::ECS>();
+	std::vector<lecs::Entity> entities;
+	for (uint32_t i = 0; i < 5000; i++) {
+		entities.push_back(ecs->create_entity());
+	}
+
+	// Random churn, checked against a std::map: removals shift the probe chains of the hash map.
+	std::mt19937 random(5);
+	std::map<uint32_t, uint32_t> expected;
+	bool same = true;
+	for (uint32_t step = 0; step < 20000; step++) {
+		const uint32_t i = random() % (step < 10000 ? 5000 : 300);
+		if (expected.count(i) != 0) {
+			same = same && ecs->remove_component_from_entity<BossComponent>(entities[i]);
+			expected.erase(i);
+		}
+		else {
+			same = same && ecs->emplace_component<BossComponent>(entities[i], step) != nullptr;
+			expected[i] = step;
+		}
+	}
+	for (uint32_t i = 0; i < entities.size(); i++) {
+		const BossComponent* boss = ecs->get_component<BossComponent>(entities[i]);
+		auto it = expected.find(i);
+		same = same && (it == expected.end() ? boss == nullptr : boss != nullptr && boss->phase == it->second);
+	}
+	same = same && lecs::DenseView<BossComponent>(*ecs).size() == expected.size();
+
+	// The pool of a rare component only grows with its components.
+	const bool small = sizeof(lecs::ComponentArray<BossComponent>) < 1024 &&
+		sizeof(lecs::ComponentArray<VelocityComponent>) > lecs::MAX_ENTITIES * sizeof(VelocityComponent);
+
+	std::unique_ptr<lecs::ECS> destination = std::make_unique<lecs::ECS>();
+	std::vector<lecs::Entity> selection;
+	for (const auto& boss : expected) {
+		if (boss.first % 2 == 0) {
+			selection.push_back(entities[boss.first]);
+		}
+	}
+	lecs::EntityRemap remap;
+	bool moved = lecs::move_entities(*ecs, *destination, selection, remap) &&
+		lecs::DenseView<BossComponent>(*destination).size() == selection.size() &&
+		lecs::DenseView<BossComponent>(*ecs).size() == expected.size() - selection.size();
+	for (lecs::Entity entity : selection) {
+		const BossComponent* boss = destination->get_component<BossComponent>(remap.get(entity));
+		moved = moved && boss != nullptr && boss->phase == expected[entity.get_index()];
+	}
+
+	std::cout << "test_rare_storage same as map: " << (same ? "true" : "false") << ", pool bytes: " << sizeof(lecs::ComponentArray<BossComponent>)
+		<< ", small: " << (small ? "true" : "false") << ", moved: " << (moved ? "true" : "false") << std::endl;
+}
+
+struct CountedComponent {
+	static int32_t alive;
+	CountedComponent() { alive++; }
+	CountedComponent(const CountedComponent&) { alive++; }
+	~CountedComponent() { alive--; }
+};
+int32_t CountedComponent::alive = 0;
+
+void test_world_clear() {
+	constexpr uint32_t num_entities = 100000;
+	std::unique_ptr<lecs::ECS> ecs = std::make_unique<lecs::ECS>();
+	lecs::HashIndex<NetworkIdComponent, uint32_t> network_ids(*ecs, &NetworkIdComponent::value);
+	std::vector<lecs::Entity> entities;
+	auto populate = [&](lecs::ECS& world) {
+		entities.clear();
+		for (uint32_t i = 0; i < num_entities; i++) {
+			lecs::Entity entity = world.create_entity();
+			world.add_component_to_entity<VelocityComponent>(entity);
+			world.emplace_component<NetworkIdComponent>(entity, i, 0);
+			if (i % 10 == 0) {
+				world.add_component_to_entity<CountedComponent>(entity);
+				world.emplace_component<BossComponent>(entity, i);
+			}
+			if (i % 3 == 0) {
+				world.remove_entity(entity); // leaves generations behind in the free list
+			}
+			else {
+				entities.push_back(entity);
+			}
+		}
+	};
+
+	// One component type, then everything.
+	populate(*ecs);
+	ecs->clear<CountedComponent>();
+	const bool type_cleared = CountedComponent::alive == 0 && ecs->get_component_array<CountedComponent>().get_size() == 0 &&
+		!ecs->has_component<CountedComponent>(entities[6]) && ecs->has_component<BossComponent>(entities[6]);
+
+	ecs->add_component_to_entity<CountedComponent>(entities[0]);
+	ecs->clear();
+
+	bool cleared = ecs->get_entity_count() == 0 && CountedComponent::alive == 0 && network_ids.find(10) == lecs::Entity::Invalid &&
+		ecs->get_component_array<VelocityComponent>().get_size() == 0 && lecs::DenseView<BossComponent>(*ecs).size() == 0;
+	for (lecs::Entity entity : entities) {
+		cleared = cleared && !ecs->is_entity_handle_active(entity) && ecs->get_component<NetworkIdComponent>(entity) == nullptr;
+	}
+
+	// The same indices come back with new generations.
+	std::vector<lecs::Entity> old_entities = entities;
+	populate(*ecs);
+	bool reused = network_ids.find(11) == entities[7] && ecs->get_component<BossComponent>(entities[6])->phase == 10;
+	for (size_t i = 0; i < old_entities.size(); i++) {
+		reused = reused && !ecs->is_entity_handle_active(old_entities[i]) && entities[i].get_index() == old_entities[i].get_index();
+	}
+
+	// Without observers, clear doesn't visit the entities.
+	std::unique_ptr<lecs::ECS> other = std::make_unique<lecs::ECS>();
+	populate(*other);
+	using namespace std::chrono;
+	high_resolution_clock::time_point t1 = high_resolution_clock::now();
+	for (lecs::Entity entity : entities) {
+		other->remove_entity(entity);
+	}
+	high_resolution_clock::time_point t2 = high_resolution_clock::now();
+	populate(*other);
+	high_resolution_clock::time_point t3 = high_resolution_clock::now();
+	other->clear();
+	high_resolution_clock::time_point t4 = high_resolution_clock::now();
+
+	std::cout << "test_world_clear removing the entities took " << duration_cast<duration<double>>(t2 - t1).count() << " seconds, clear took "
+		<< duration_cast<duration<double>>(t4 - t3).count() << " seconds with " << entities.size() << " entities\n";
+	std::cout << "test_world_clear type cleared: " << (type_cleared ? "true" : "false") << ", cleared: " << (cleared ? "true" : "false")
+		<< ", reused: " << (reused ? "true" : "false") << std::endl;
+}
+
+struct SmoothedComponent {
+	float position;
+	// Not trivial, so that the previous values are constructed and destroyed too.
+	std::string label;
+};
+
+template <>
+struct lecs::ComponentStorageOf<SmoothedComponent> {
+	static const lecs::ComponentStorage value = lecs::ComponentStorage::DoubleBuffered;
+};
+
+struct SmoothedTargetComponent {
+	lecs::Entity target;
+	float weight;
+};
+
+template <>
+struct lecs::ComponentStorageOf<SmoothedTargetComponent> {
+	static const lecs::ComponentStorage value = lecs::ComponentStorage::DoubleBuffered;
+};
+
+void test_double_buffer() {
+	std::unique_ptr<lecs::ECS> ecs = std::make_unique<lecs::ECS>();
+	std::vector<lecs::Entity> entities;
+	for (int i = 0; i < 1000; i++) {
+		entities.push_back(ecs->create_entity());
+		ecs->emplace_component<SmoothedComponent>(entities.back(), float(i), "smoothed");
+	}
+
+	bool added_same = true;
+	for (lecs::Entity entity : entities) {
+		added_same = added_same && ecs->get_previous_component<SmoothedComponent>(entity)->position == ecs->get_component<SmoothedComponent>(entity)->position;
+	}
+
+	// Every frame a thread reads the previous positions while this one writes the current ones from them.
+	bool parallel_correct = true;
+	for (int frame = 0; frame < 10; frame++) {
+		double previous_sum = 0.0;
+		std::thread reader([&]() {
+			for (lecs::Entity entity : entities) {
+				previous_sum += ecs->get_previous_component<SmoothedComponent>(entity)->position;
+			}
+		});
+		for (lecs::Entity entity : entities) {
+			ecs->get_component<SmoothedComponent>(entity)->position = ecs->get_previous_component<SmoothedComponent>(entity)->position + 1.0f;
+		}
+		reader.join();
+		ecs->swap_buffers<SmoothedComponent>();
+
+		parallel_correct = parallel_correct && previous_sum == 499500.0 + 1000.0 * frame;
+	}
+
+	// Removals move the last components, both values must follow them.
+	for (size_t i = 0; i < entities.size(); i += 3) {
+		ecs->remove_entity(entities[i]);
+	}
+	bool removed_correct = ecs->get_previous_component<SmoothedComponent>(entities[0]) == nullptr;
+	for (size_t i = 1; i < entities.size(); i++) {
+		if (i % 3 == 0) {
+			continue;
+		}
+		const SmoothedComponent* previous = ecs->get_previous_component<SmoothedComponent>(entities[i]);
+		removed_correct = removed_correct && previous != nullptr && previous->position == float(i + 10) && previous->label == "smoothed";
+	}
+
+	// Moved components have their entities remapped in both values.
+	std::unique_ptr<lecs::ECS> side_world = std::make_unique<lecs::ECS>();
+	ecs->set_entity_remapper<SmoothedTargetComponent>([](SmoothedTargetComponent& component, const lecs::EntityRemap& remap) {
+		component.target = remap.get(component.target);
+	});
+	ecs->create_entity();
+	std::vector<lecs::Entity> moved = { side_world->create_entity(), side_world->create_entity() };
+	side_world->emplace_component<SmoothedTargetComponent>(moved[0], moved[1], 1.0f);
+	lecs::EntityRemap remap;
+	bool moved_remapped = lecs::move_entities(*side_world, *ecs, moved, remap);
+	const SmoothedTargetComponent* moved_previous = ecs->get_previous_component<SmoothedTargetComponent>(remap.get(moved[0]));
+	moved_remapped = moved_remapped && moved_previous != nullptr && moved_previous->target == remap.get(moved[1]) &&
+		ecs->get_component<SmoothedTargetComponent>(remap.get(moved[0]))->target == remap.get(moved[1]);
+
+	// Even uninitialized, the previous value is never garbage.
+	SmoothedTargetComponent* uninitialized = ecs->add_component_uninitialized<SmoothedTargetComponent>(entities[1]);
+	const SmoothedTargetComponent* uninitialized_previous = ecs->get_previous_component<SmoothedTargetComponent>(entities[1]);
+	const bool uninitialized_zeroed = uninitialized != nullptr && uninitialized->weight == 0.0f && uninitialized_previous->weight == 0.0f &&
+		!uninitialized_previous->target.is_valid();
+
+	std::cout << "test_double_buffer added same: " << (added_same ? "true" : "false") << ", parallel correct: " << (parallel_correct ? "true" : "false")
+		<< ", removed correct: " << (removed_correct ? "true" : "false") << ", moved remapped: " << (moved_remapped ? "true" : "false")
+		<< ", uninitialized zeroed: " << (uninitialized_zeroed ? "true" : "false") << std::endl;
+}
+
+#if defined(LECS_HAS_SHARED_MEMORY)
+void test_inspector() {
+	std::unique_ptr<lecs::ECS> ecs = std::make_unique<lecs::ECS>();
+	for (int i = 0; i < 1000; i++) {
+		lecs::Entity entity = ecs->create_entity();
+		ecs->add_component_to_entity<VelocityComponent>(entity);
+		if (i % 4 == 0) {
+			ecs->emplace_component<BossComponent>(entity, uint32_t(i));
+		}
+	}
+
+	lecs::ComponentRegistry registry;
+	registry.register_component<VelocityComponent>(1, "Velocity");
+	const std::string name = "/lecs_test_inspector";
+
+	lecs::InspectorSnapshot snapshot;
+	const bool missing_rejected = !lecs::read_inspector_snapshot(name, snapshot);
+
+	lecs::InspectorPublisher inspector(&registry);
+	bool published = inspector.open(name) && !lecs::read_inspector_snapshot(name, snapshot); // nothing published yet
+	inspector.set_timing("physics", std::chrono::microseconds(250));
+	inspector.publish(*ecs, std::chrono::milliseconds(16));
+	published = published && lecs::read_inspector_snapshot(name, snapshot) && snapshot.frame_number == 1 && snapshot.alive_entity_count == 1000 &&
+		snapshot.pool_count == 2 && snapshot.timing_count == 1 && snapshot.timings[0].nanoseconds == 250000 && snapshot.frame_time_nanoseconds == 16000000;
+	bool pools_right = true;
+	for (uint32_t i = 0; i < snapshot.pool_count; i++) {
+		const lecs::InspectorSnapshot::Pool& pool = snapshot.pools[i];
+		if (pool.component_id == static_cast<uint32_t>(lecs::ComponentID::get<VelocityComponent>())) {
+			pools_right = pools_right && pool.component_count == 1000 && std::string(pool.name) == "Velocity";
+		}
+		else {
+			// The rare pool is tiny next to the dense one.
+			pools_right = pools_right && pool.component_count == 250 && pool.name[0] == '\0' && pool.memory_use < snapshot.memory_use / 100;
+		}
+	}
+
+	// The timings follow the frame number, a torn copy would mix two frames.
+	std::atomic<bool> done{ false };
+	std::thread publisher([&]() {
+		for (int64_t frame = 2; frame <= 20000; frame++) {
+			inspector.set_timing("physics", std::chrono::nanoseconds(frame));
+			inspector.set_timing("render", std::chrono::nanoseconds(frame));
+			inspector.publish(*ecs, std::chrono::nanoseconds(frame));
+		}
+		done = true;
+	});
+
+	uint32_t reads = 0;
+	bool consistent = true;
+	while (!done) {
+		if (lecs::read_inspector_snapshot(name, snapshot)) {
+			reads++;
+			const int64_t frame = static_cast<int64_t>(snapshot.frame_number);
+			consistent = consistent && (frame == 1 || (snapshot.frame_time_nanoseconds == frame && snapshot.timings[0].nanoseconds == frame &&
+				snapshot.timings[1].nanoseconds == frame));
+		}
+	}
+	publisher.join();
+
+	inspector.close();
+	const bool removed = !lecs::read_inspector_snapshot(name, snapshot);
+
+	std::cout << "test_inspector missing rejected: " << (missing_rejected ? "true" : "false") << ", published: " << (published ? "true" : "false")
+		<< ", pools right: " << (pools_right ? "true" : "false") << ", consistent: " << (consistent ? "true" : "false")
+		<< " (" << reads << " reads), removed: " << (removed ? "true" : "false") << std::endl;
+}
+#endif // defined(LECS_HAS_SHARED_MEMORY)
+
+#if defined(LECS_HAS_SHARED_MEMORY)
+void test_shared_pools() {
+	std::unique_ptr<lecs::ECS> ecs = std::make_unique<lecs::ECS>();
+	std::vector<lecs::Entity> entities;
+	for (uint32_t i = 0; i < 1000; i++) {
+		entities.push_back(ecs->create_entity());
+		ecs->emplace_component<NetworkIdComponent>(entities.back(), i, 1); // the score is the frame number
+	}
+
+	const std::string name = "/lecs_test_shared_pool";
+	lecs::SharedPoolPublisher<NetworkIdComponent> publisher;
+	lecs::SharedPoolReader<NetworkIdComponent> reader;
+	lecs::SharedPoolReader<NetworkIdComponent> other_reader;
+	lecs::SharedPoolReader<NetworkIdComponent> third_reader;
+	lecs::SharedPoolReader<VelocityComponent> wrong_reader;
+	bool opened = publisher.open(name, 2000, 2) && reader.open(name) && other_reader.open(name) && !third_reader.open(name) &&
+		!wrong_reader.open(name) && !reader.acquire();
+
+	// The entities line up with the components.
+	bool published = publisher.publish(*ecs) && reader.acquire() && reader.get_frame_number() == 1 && reader.get_size() == 1000;
+	for (uint32_t i = 0; published && i < reader.get_size(); i++) {
+		published = reader.get_entities()[i] == entities[reader.get_components()[i].value];
+	}
+	reader.release();
+
+	// The pinned frame doesn't change, whatever the publisher does.
+	std::atomic<bool> done{ false };
+	std::thread publisher_thread([&]() {
+		for (int32_t frame = 2; frame <= 3000; frame++) {
+			for (NetworkIdComponent& network_id : lecs::DenseView<NetworkIdComponent>(*ecs)) {
+				network_id.score = frame;
+			}
+			publisher.publish(*ecs);
+		}
+		done = true;
+	});
+
+	uint32_t acquires = 0;
+	bool stable = true;
+	uint64_t last_frame = 0;
+	while (!done) {
+		if (!reader.acquire()) {
+			continue;
+		}
+		acquires++;
+		const int32_t frame = static_cast<int32_t>(reader.get_frame_number());
+		stable = stable && reader.get_frame_number() >= last_frame && other_reader.acquire();
+		last_frame = reader.get_frame_number();
+		for (int pass = 0; pass < 2; pass++) {
+			for (uint32_t i = 0; i < reader.get_size(); i++) {
+				stable = stable && reader.get_components()[i].score == frame;
+			}
+		}
+		other_reader.release();
+	}
+	publisher_thread.join();
+	reader.release();
+
+	const bool full_rejected = [&]() {
+		for (uint32_t i = 0; i < 1001; i++) {
+			ecs->emplace_component<NetworkIdComponent>(ecs->create_entity(), i, 0);
+		}
+		return !publisher.publish(*ecs);
+	}();
+
+	reader.close();
+	other_reader.close();
+	const bool slot_freed = third_reader.open(name);
+	third_reader.close();
+	publisher.close();
+	const bool removed = !reader.open(name);
+
+	std::cout << "test_shared_pools opened: " << (opened ? "true" : "false") << ", published: " << (published ? "true" : "false")
+		<< ", stable: " << (stable ? "true" : "false") << " (" << acquires << " acquires), full rejected: " << (full_rejected ? "true" : "false")
+		<< ", slot freed: " << (slot_freed ? "true" : "false") << ", removed: " << (removed ? "true" : "false") << std::endl;
+}
+#endif // defined(LECS_HAS_SHARED_MEMORY)
 
 int main() {
 	std::cout << "Welcome to LECS" << std::endl;
@@ -136,5 +1529,34 @@ int main() {
 	ecs->add_component_to_entity<TransformComponent>(ent);
 
 	test_system_update(*ecs);
+	test_time_sliced_query();
+	test_system_groups();
+	test_frame_profiler();
+	test_stats();
+	test_spatial_grid();
+	test_secondary_indexes();
+	test_world_checksum();
+	test_cell_streaming();
+	test_move_entities();
+	test_replication();
+	test_enabled_entities();
+	test_emplace_and_patch();
+	test_removal_during_iteration();
+	test_snapshot();
+	test_handle_widths();
+	test_trace_replay();
+	test_sharded_world();
+	test_dense_views();
+	test_indirect_storage();
+	test_rare_storage();
+	test_world_clear();
+	test_double_buffer();
+#if defined(LECS_HAS_SHARED_MEMORY)
+	test_inspector();
+	test_shared_pools();
+#endif // defined(LECS_HAS_SHARED_MEMORY)
+#if defined(LECS_HAS_COROUTINES)
+	test_coroutine_systems();
+#endif // defined(LECS_HAS_COROUTINES)
 	return 0;
 }
\ No newline at end of file
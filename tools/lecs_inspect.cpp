@@ -0,0 +1,99 @@
+// LECS (Lightweight Entity Component System) inspector command line tool
+//
+// Written by Marco Vallario
+//
+// LICENSE: See end of file for license information
+//
+// USAGE:
+// Prints what an InspectorPublisher publishes, see lecs_inspector.hpp:
+// lecs_inspect <segment name> [interval in milliseconds, 1000 by default] [number of prints, 0 (forever) by default]
+//
+// It maps the segment only while it copies it, so it can be started and stopped at any time, and it keeps waiting if
+// the segment is not there (yet, or anymore).
+//
+// g++ -std=c++14 -O2 tools/lecs_inspect.cpp -o lecs_inspect
+
+#define LECS_IMPLEMENTATION
+#include "../lecs/lecs.hpp"
+#include "../lecs/lecs_registry.hpp"
+#include "../lecs/lecs_shared_memory.hpp"
+#include "../lecs/lecs_inspector.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+namespace {
+	double to_milliseconds(int64_t nanoseconds) {
+		return static_cast<double>(nanoseconds) / 1000000.0;
+	}
+
+	void print_snapshot(const lecs::InspectorSnapshot& snapshot) {
+		std::cout << "frame " << snapshot.frame_number << ": " << to_milliseconds(snapshot.frame_time_nanoseconds) << " ms, "
+			<< snapshot.alive_entity_count << " entities alive (" << snapshot.entity_count << " of " << snapshot.max_entities << " indices used), "
+			<< snapshot.memory_use / 1024 << " KB\n";
+		std::cout << "  swap moves " << snapshot.stats.remove_swap_moves << ", free list hits " << snapshot.stats.free_list_hits
+			<< ", pools created " << snapshot.stats.lazy_pool_creations << ", invalid handles " << snapshot.stats.invalid_handle_rejections << "\n";
+
+		for (uint32_t i = 0; i < snapshot.pool_count; ++i) {
+			const lecs::InspectorSnapshot::Pool& pool = snapshot.pools[i];
+			std::cout << "  pool " << pool.component_id << (pool.name[0] != '\0' ? " " : "") << pool.name << ": "
+				<< pool.component_count << " components, " << pool.memory_use / 1024 << " KB\n";
+		}
+
+		for (uint32_t i = 0; i < snapshot.timing_count; ++i) {
+			std::cout << "  " << snapshot.timings[i].name << ": " << to_milliseconds(snapshot.timings[i].nanoseconds) << " ms\n";
+		}
+		std::cout << std::flush;
+	}
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		std::cerr << "usage: lecs_inspect <segment name> [interval ms] [count]\n";
+		return 1;
+	}
+
+	const char* name = argv[1];
+	const int interval_ms = argc > 2 ? std::atoi(argv[2]) : 1000;
+	const int count = argc > 3 ? std::atoi(argv[3]) : 0;
+
+	lecs::InspectorSnapshot snapshot;
+	for (int printed = 0; count == 0 || printed < count; ++printed) {
+		if (lecs::read_inspector_snapshot(name, snapshot)) {
+			print_snapshot(snapshot);
+		}
+		else {
+			std::cout << "nothing published as " << name << std::endl;
+		}
+
+		if (count == 0 || printed + 1 < count) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+		}
+	}
+
+	return 0;
+}
+
+//MIT License
+//
+//Copyright(c) 2020 Marco Vallario
+//
+//Permission is hereby granted, free of charge, to any person obtaining a copy
+//of this software and associated documentation files(the "Software"), to deal
+//in the Software without restriction, including without limitation the rights
+//to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+//copies of the Software, and to permit persons to whom the Software is
+//furnished to do so, subject to the following conditions :
+//
+//The above copyright notice and this permission notice shall be included in all
+//copies or substantial portions of the Software.
+//
+//THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+//IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+//FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+//AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+//LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+//OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+//SOFTWARE.